@@ -8,8 +8,15 @@ layout (triangle_strip, max_vertices = 4) out;
 in vec3 vertex_color[];
 in float timestep[];
 
-// Uniform (global) buffer
-uniform mat4 projection_mat;
+// Per-frame data shared by all materials, filled once per frame
+layout(std140) uniform PerFrame {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 light_position;
+    vec4 light_color;
+    float timer;
+    int spec_power;
+};
 
 // Simulation parameters (constants)
 uniform float particle_size = .5;
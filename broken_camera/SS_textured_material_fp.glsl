@@ -7,6 +7,7 @@ in vec2 uv_;
 
 // Uniform (global) buffer
 uniform sampler2D texture_map;
+uniform float progress = -1.0; // Loading progress from 0 to 1, negative when not loading
 
 
 void main() 
@@ -16,6 +17,12 @@ void main()
     // Retrieve texture value
     vec4 pixel = texture(texture_map, uv_);
 
+    // Draw the loading progress as a bar along the bottom of the screen
+    if (progress >= 0.0 && uv_.y > 0.96 && uv_.y < 0.98 && uv_.x > 0.05 && uv_.x < 0.95) {
+        float filled = 0.05 + 0.9 * progress;
+        pixel = (uv_.x < filled) ? vec4(0.95, 0.75, 0.4, 1.0) : vec4(0.2, 0.2, 0.2, 1.0);
+    }
+
     // Use texture in determining fragment colour
     gl_FragColor = pixel;
 }
@@ -1,6 +1,7 @@
 // Material with no illumination simulation
 
 #version 130
+#extension GL_ARB_uniform_buffer_object : require
 
 // Vertex buffer
 in vec3 vertex;
@@ -11,8 +12,13 @@ in vec2 uv;
 out vec4 color_;
 out vec2 uv_;
 
+// Transforms of the node being drawn, from the per-draw ring buffer
+layout(std140) uniform PerDraw {
+    mat4 world_mat;
+    mat4 normal_mat;
+};
+
 // Uniform (global) buffer
-uniform mat4 world_mat;
 uniform mat4 view_mat;
 uniform mat4 projection_mat;
 
@@ -1,8 +1,11 @@
 #include "Ui.h"
+#include "render_stats.h"
+#include "draw_ring.h"
 
 
 game::Ui::Ui(const std::string name, const Resource* wallGeometry, const Resource* material, const Resource* texture) : SceneNode(name, wallGeometry, material, texture, NULL) {
 	num_collected_ = 0;
+	progress_ = -1.0f;
 	//height_ = 600;
 	//width_ = 800;
 }
@@ -19,6 +22,10 @@ void game::Ui::IncrementCollected(void) {
 	}
 }
 
+void game::Ui::SetProgress(float progress) {
+	progress_ = progress;
+}
+
 void game::Ui::Draw(Camera* camera) {
 	
 	SceneNode::Draw(camera);
@@ -26,47 +33,32 @@ void game::Ui::Draw(Camera* camera) {
 
 }
 
-void game::Ui::SetupShader(GLuint program) {
-
-	// Set attributes for shaders
-	GLint vertex_att = glGetAttribLocation(program, "vertex");
-	glVertexAttribPointer(vertex_att, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), 0);
-	glEnableVertexAttribArray(vertex_att);
-
-	GLint normal_att = glGetAttribLocation(program, "normal");
-	glVertexAttribPointer(normal_att, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(normal_att);
-
-	GLint color_att = glGetAttribLocation(program, "color");
-	glVertexAttribPointer(color_att, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)(6 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(color_att);
-
-	GLint tex_att = glGetAttribLocation(program, "uv");
-	glVertexAttribPointer(tex_att, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*)(9 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(tex_att);
+void game::Ui::SetupShader(const ProgramLocations &locations) {
 
 	// World transformation
-	glm::mat4 scaling = glm::scale(glm::mat4(1.0), scale_);
-	glm::mat4 rotation = glm::mat4_cast(orientation_);
+	glm::mat4 scaling = glm::scale(glm::mat4(1.0), GetScale());
+	glm::mat4 rotation = glm::mat4_cast(GetOrientation());
 	//glm::vec3 pos = glm::vec3( position_.x + parent_->GetPosition().x, position_.y + parent_->GetPosition().y, position_.z + parent_->GetPosition().z);
-	glm::mat4 translation = glm::translate(glm::mat4(1.0), position_);
+	glm::mat4 translation = glm::translate(glm::mat4(1.0), GetPosition());
 	glm::mat4 transf = translation * rotation * scaling;
 
 	// Set projection matrix in shader
-	GLint projection_mat = glGetUniformLocation(program, "projection_mat");
-	glUniformMatrix4fv(projection_mat, 1, GL_FALSE, glm::value_ptr(glm::ortho(-0.5f, 0.5f, 0.5f, -0.5f)));
+	GL_COUNT(glUniformMatrix4fv(locations.uniform[ProjectionMatUniform], 1, GL_FALSE, glm::value_ptr(glm::ortho(-0.5f, 0.5f, 0.5f, -0.5f))));
 	
-	GLint world_mat = glGetUniformLocation(program, "world_mat");
-	glUniformMatrix4fv(world_mat, 1, GL_FALSE, glm::value_ptr(transf));
+	DrawUniforms data;
+	data.world_mat = transf * GetDequantization();
+	data.normal_mat = glm::mat4(1.0);
+	DrawRing::Push(data);
 
 	// Timer
-	GLint timer_var = glGetUniformLocation(program, "timer");
 	double current_time = glfwGetTime();
-	glUniform1f(timer_var, (float)current_time);
+	GL_COUNT(glUniform1f(locations.uniform[TimerUniform], (float)current_time));
 
 	// num collected objectives
-	GLint collect_var = glGetUniformLocation(program, "num_collected");
-	glUniform1i(collect_var, num_collected_);
+	GL_COUNT(glUniform1i(locations.uniform[NumCollectedUniform], num_collected_));
+
+	// loading progress
+	GL_COUNT(glUniform1f(locations.uniform[ProgressUniform], progress_));
 }
 /*
 void game::Ui::setOrthographicProjection() {
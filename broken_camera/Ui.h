@@ -22,15 +22,18 @@ namespace game {
 
         //update the number of collected objectives
         void IncrementCollected(void);
+        //set the loading progress, from 0 to 1; negative hides the progress bar
+        void SetProgress(float progress);
 
         void Draw(Camera* camera);
 
     protected:
-        void SetupShader(GLuint program);
+        void SetupShader(const ProgramLocations &locations);
         
 
     private:
         int num_collected_;
+        float progress_;
         //int height_, width_;
         
     
@@ -0,0 +1,137 @@
+#include <ios>
+#include <stdexcept>
+#include <SOIL/SOIL.h>
+
+#include "asset_loader.h"
+
+namespace game {
+
+    AssetLoader::Job::Job(void) {
+
+        image.pixels = NULL;
+    }
+
+
+    AssetLoader::Job::~Job() {
+
+        if (image.pixels) {
+            SOIL_free_image_data(image.pixels);
+        }
+    }
+
+
+    AssetLoader::AssetLoader(ResourceManager *resman, unsigned int num_threads) : pool_(num_threads) {
+
+        resman_ = resman;
+        num_uploaded_ = 0;
+    }
+
+
+    AssetLoader::~AssetLoader() {
+    }
+
+
+    void AssetLoader::LoadResource(ResourceType type, const std::string name, const char *filename) {
+
+        if ((type != Material) && (type != Texture) && (type != Mesh)) {
+            throw(std::invalid_argument(std::string("Invalid type of resource")));
+        }
+
+        Job *job = new Job();
+        job->type = type;
+        job->name = name;
+        job->filename = filename;
+        job->vertex_format = resman_->GetVertexFormat();
+        jobs_.push_back(std::unique_ptr<Job>(job));
+
+        pool_.Submit([this, job] { Read(job); });
+    }
+
+
+    void AssetLoader::Read(Job *job) {
+
+        // Runs on a worker thread
+        try {
+            if (job->type == Material) {
+                ResourceManager::ReadMaterial(job->filename.c_str(), job->material);
+            }
+            else if (job->type == Texture) {
+                ResourceManager::ReadTexture(job->filename.c_str(), job->image);
+            }
+            else {
+                job->mesh.reset(new MeshSource());
+                ResourceManager::ReadMesh(job->filename.c_str(), job->vertex_format, *job->mesh);
+            }
+        }
+        catch (std::exception &e) {
+            job->error = e.what();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            completed_.push_back(job);
+        }
+        job_done_.notify_one();
+    }
+
+
+    bool AssetLoader::Upload(double time_budget) {
+
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(time_budget));
+
+        while (num_uploaded_ < jobs_.size()) {
+            // Take the next finished job, waiting for the workers until the
+            // time runs out
+            Job *job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (!job_done_.wait_until(lock, deadline, [this] { return !completed_.empty(); })) {
+                    return false;
+                }
+                job = completed_.front();
+                completed_.pop_front();
+            }
+
+            if (!job->error.empty()) {
+                throw(std::ios_base::failure(job->error));
+            }
+
+            // Create the OpenGL objects, then drop the data read from disk
+            if (job->type == Material) {
+                resman_->AddMaterial(job->name, job->material);
+                job->material = MaterialSource();
+            }
+            else if (job->type == Texture) {
+                resman_->AddTexture(job->name, job->image, job->filename.c_str());
+            }
+            else {
+                resman_->AddMesh(job->name, *job->mesh, job->filename.c_str());
+                job->mesh.reset();
+            }
+            num_uploaded_++;
+
+            if (std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+        }
+
+        return num_uploaded_ == jobs_.size();
+    }
+
+
+    float AssetLoader::GetProgress(void) const {
+
+        if (jobs_.empty()) {
+            return 1.0f;
+        }
+        return (float) num_uploaded_ / (float) jobs_.size();
+    }
+
+
+    unsigned int AssetLoader::GetNumThreads(void) const {
+
+        return pool_.GetNumThreads();
+    }
+
+} // namespace game
@@ -0,0 +1,74 @@
+#ifndef ASSET_LOADER_H_
+#define ASSET_LOADER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "resource_manager.h"
+#include "thread_pool.h"
+
+namespace game {
+
+    // Loads resources from files on a pool of worker threads. The workers
+    // read shader sources, decode images and parse meshes; the thread that
+    // owns the OpenGL context then creates the OpenGL objects in Upload()
+    class AssetLoader {
+
+        public:
+            // With num_threads = 0, one worker is started per hardware thread
+            AssetLoader(ResourceManager *resman, unsigned int num_threads = 0);
+            ~AssetLoader();
+
+            // Queue a resource to be loaded; same arguments as
+            // ResourceManager::LoadResource
+            void LoadResource(ResourceType type, const std::string name, const char *filename);
+            // Add the resources finished by the workers to the resource
+            // manager, for at most time_budget seconds. Returns true once all
+            // queued resources were added. Errors from the workers are
+            // thrown here
+            bool Upload(double time_budget);
+            // Fraction of the queued resources already added
+            float GetProgress(void) const;
+            unsigned int GetNumThreads(void) const;
+
+        private:
+            // One queued resource and the data read by the worker
+            struct Job {
+                ResourceType type;
+                std::string name;
+                std::string filename;
+                VertexFormat vertex_format;
+                MaterialSource material;
+                TextureImage image;
+                std::unique_ptr<MeshSource> mesh;
+                std::string error; // Set if the worker failed
+
+                Job(void);
+                // Frees the image if it was never uploaded
+                ~Job();
+            };
+
+            ResourceManager *resman_;
+            std::vector<std::unique_ptr<Job> > jobs_;
+            size_t num_uploaded_;
+            // Jobs finished by the workers, waiting for Upload()
+            std::deque<Job *> completed_;
+            std::mutex mutex_;
+            std::condition_variable job_done_;
+            // Declared last so the workers stop before the jobs are freed
+            ThreadPool pool_;
+
+            void Read(Job *job);
+
+            AssetLoader(const AssetLoader &);
+            AssetLoader &operator=(const AssetLoader &);
+
+    }; // class AssetLoader
+
+} // namespace game
+
+#endif // ASSET_LOADER_H_
@@ -7,6 +7,8 @@
 #include <iostream>
 
 #include "camera.h"
+#include "render_stats.h"
+#include "gl_state.h"
 
 namespace game {
 
@@ -15,6 +17,8 @@ namespace game {
         orientation_ = glm::quat(0, glm::vec3(1)); // Orientation of Player
         forward_ = glm::vec3(0,0,-1); // Initial forward vector
         side_= glm::vec3(1,0,0); // Initial side vector
+        viewport_height_ = 0.0;
+        frame_uniforms_ = 0;
     }
 
 
@@ -99,33 +103,54 @@ namespace game {
         float top = tan((fov / 2.0) * (glm::pi<float>() / 180.0)) * near;
         float right = top * w / h;
         projection_matrix_ = glm::frustum(-right, right, -top, top, near, far);
+        viewport_height_ = h;
     }
 
 
-    void Camera::SetupShader(GLuint program) {
+    const glm::mat4 &Camera::GetProjectionMatrix(void) const {
 
-        // Update view matrix
-        SetupViewMatrix();
+        return projection_matrix_;
+    }
+
+
+    const glm::mat4 &Camera::GetViewMatrix(void) const {
+
+        return view_matrix_;
+    }
+
+
+    float Camera::GetPixelsPerUnit(float distance) const {
 
-        // Set view matrix in shader
-        GLint view_mat = glGetUniformLocation(program, "view_mat");
-        glUniformMatrix4fv(view_mat, 1, GL_FALSE, glm::value_ptr(view_matrix_));
+        // The projection maps a height of 2 * distance / projection[1][1]
+        // to the full viewport
+        return projection_matrix_[1][1] * viewport_height_ * 0.5f / distance;
+    }
 
-        // Set projection matrix in shader
-        GLint projection_mat = glGetUniformLocation(program, "projection_mat");
-        glUniformMatrix4fv(projection_mat, 1, GL_FALSE, glm::value_ptr(projection_matrix_));
 
-        //Set Light position
-        GLint light_position = glGetUniformLocation(program, "light_position");
-        glUniform3fv(light_position, 1, glm::value_ptr(light_position_));
+    void Camera::SetupFrameUniforms(void) {
 
-        //Set Light color
-        GLint light_color = glGetUniformLocation(program, "light_color");
-        glUniform4fv(light_color, 1, glm::value_ptr(light_col_));
+        // Update view matrix
+        SetupViewMatrix();
 
-        //Set Specular Power
-        GLint specular_power = glGetUniformLocation(program, "spec_power");
-        glUniform1i(specular_power, spec_power_);
+        FrameUniforms data;
+        data.view_mat = view_matrix_;
+        data.projection_mat = projection_matrix_;
+        data.light_position = glm::vec4(light_position_, 1.0);
+        data.light_color = glm::vec4(light_col_, 1.0);
+        data.timer = (GLfloat) glfwGetTime();
+        data.spec_power = (GLint) spec_power_;
+        data.padding[0] = data.padding[1] = 0.0f;
+
+        // The buffer is created on first use, once there is an OpenGL
+        // context, and stays bound to the binding point of the block
+        if (frame_uniforms_ == 0) {
+            glGenBuffers(1, &frame_uniforms_);
+            GLState::BindBuffer(GL_UNIFORM_BUFFER, frame_uniforms_);
+            glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_DYNAMIC_DRAW);
+            GLState::BindBufferBase(GL_UNIFORM_BUFFER, frame_uniforms_binding, frame_uniforms_);
+        }
+        GLState::BindBuffer(GL_UNIFORM_BUFFER, frame_uniforms_);
+        GL_COUNT(glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &data));
     }
 
     void Camera::Update(glm::quat o, glm::vec3 f, glm::vec3 s, glm::vec3 pos)
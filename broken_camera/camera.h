@@ -7,8 +7,21 @@
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
+#include "resource.h"
+
 namespace game {
 
+    // Contents of the PerFrame uniform block, in the std140 layout
+    struct FrameUniforms {
+        glm::mat4 view_mat;
+        glm::mat4 projection_mat;
+        glm::vec4 light_position;
+        glm::vec4 light_color;
+        GLfloat timer;
+        GLint spec_power;
+        GLfloat padding[2];
+    };
+
     // Abstraction of a camera
     class Camera {
 
@@ -43,8 +56,16 @@ namespace game {
         // Set projection from frustum parameters: field-of-view,
         // near and far planes, and width and height of viewport
         void SetProjection(GLfloat fov, GLfloat near, GLfloat far, GLfloat w, GLfloat h);
-        // Set all camera-related variables in shader program
-        void SetupShader(GLuint program);
+        const glm::mat4 &GetProjectionMatrix(void) const;
+        // View matrix of the last SetupFrameUniforms
+        const glm::mat4 &GetViewMatrix(void) const;
+        // Height on screen, in pixels, of an object one unit tall at the
+        // given distance from the camera
+        float GetPixelsPerUnit(float distance) const;
+        // Fill the PerFrame uniform block with the view, projection and
+        // light of the camera and the current time. Called once per frame,
+        // before drawing
+        void SetupFrameUniforms(void);
 
         void Update(glm::quat o, glm::vec3 f, glm::vec3 s, glm::vec3 pos);
 
@@ -58,10 +79,12 @@ namespace game {
         glm::vec3 side_; // Initial side vector
         glm::mat4 view_matrix_; // View matrix
         glm::mat4 projection_matrix_; // Projection matrix
+        float viewport_height_; // In pixels
 
         glm::vec3 light_position_;
         glm::vec3 light_col_;
         float spec_power_;
+        GLuint frame_uniforms_; // Uniform buffer of the PerFrame block
 
         float debugModeCurrentSpeed = 2.0;
         float debugModeMaxSpeed = 5.0;
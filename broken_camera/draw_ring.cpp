@@ -0,0 +1,164 @@
+#include <cstring>
+
+#include "draw_ring.h"
+#include "render_stats.h"
+#include "gl_state.h"
+
+namespace game {
+
+    GLuint DrawRing::buffer_ = 0;
+    GLubyte *DrawRing::mapped_ = NULL;
+    GLintptr DrawRing::slot_size_ = 0;
+    GLsync DrawRing::fence_[DrawRing::num_segments_] = { 0 };
+    int DrawRing::segment_ = 0;
+    GLuint DrawRing::slot_ = 0;
+    bool DrawRing::open_ = false;
+
+
+    void DrawRing::Init(void) {
+
+        // Each slot is bound on its own, so it starts on the offset
+        // alignment of uniform buffers
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        slot_size_ = sizeof(DrawUniforms);
+        if (alignment > 0) {
+            slot_size_ = (slot_size_ + alignment - 1) / alignment * alignment;
+        }
+        GLsizeiptr size = slot_size_ * slots_per_segment_ * num_segments_;
+
+        glGenBuffers(1, &buffer_);
+        GLState::BindBuffer(GL_UNIFORM_BUFFER, buffer_);
+        if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) {
+            // Coherent mapping: writes are seen by the GPU without flushing.
+            // Dynamic storage keeps glBufferSubData usable if the mapping
+            // fails
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_UNIFORM_BUFFER, size, NULL, flags | GL_DYNAMIC_STORAGE_BIT);
+            mapped_ = (GLubyte *) glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags);
+        }
+        else {
+            // Older drivers copy each slot with glBufferSubData
+            glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_STREAM_DRAW);
+        }
+    }
+
+
+    void DrawRing::BeginFrame(void) {
+
+        if (open_) {
+            return;
+        }
+        if (buffer_ == 0) {
+            Init();
+        }
+
+        // Wait until the GPU is done with the last frame that used this
+        // segment. With three segments this only blocks when the CPU is
+        // more than two frames ahead
+        GLsync &fence = fence_[segment_];
+        if (fence) {
+            GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            if ((result == GL_TIMEOUT_EXPIRED) || (result == GL_WAIT_FAILED)) {
+                RenderStats::AddRingWait();
+                while (result == GL_TIMEOUT_EXPIRED) {
+                    result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+                }
+            }
+            glDeleteSync(fence);
+            fence = 0;
+        }
+        slot_ = 0;
+        open_ = true;
+    }
+
+
+    void DrawRing::EndFrame(void) {
+
+        if (!open_) {
+            return;
+        }
+        fence_[segment_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        segment_ = (segment_ + 1) % num_segments_;
+        open_ = false;
+    }
+
+
+    GLintptr DrawRing::Write(const void *data, GLsizeiptr size) {
+
+        BeginFrame();
+
+        // A frame with more draws than slots starts over at the front of
+        // its segment once the GPU has caught up
+        GLuint slots = (GLuint) ((size + slot_size_ - 1) / slot_size_);
+        if (slot_ + slots > slots_per_segment_) {
+            glFinish();
+            RenderStats::AddRingWait();
+            slot_ = 0;
+        }
+
+        GLintptr offset = (segment_ * slots_per_segment_ + slot_) * slot_size_;
+        slot_ += slots;
+        if (mapped_) {
+            memcpy(mapped_ + offset, data, size);
+        }
+        else {
+            GLState::BindBuffer(GL_UNIFORM_BUFFER, buffer_);
+            GL_COUNT(glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data));
+        }
+        RenderStats::AddRingWrite((unsigned int) size);
+        return offset;
+    }
+
+
+    void DrawRing::Push(const DrawUniforms &data) {
+
+        GLintptr offset = Write(&data, sizeof(DrawUniforms));
+
+        // The slot of the draw is selected by the range bound to the block
+        GLState::BindBufferRange(GL_UNIFORM_BUFFER, draw_uniforms_binding, buffer_, offset, sizeof(DrawUniforms));
+    }
+
+
+    GLuint DrawRing::PushInstances(const DrawUniforms *data, GLuint count) {
+
+        // Slots are a multiple of the size of one instance, so the first
+        // instance is at a whole index
+        GLintptr offset = Write(data, count * sizeof(DrawUniforms));
+        return (GLuint) (offset / sizeof(DrawUniforms));
+    }
+
+
+    GLuint DrawRing::GetBuffer(void) {
+
+        if (buffer_ == 0) {
+            Init();
+        }
+        return buffer_;
+    }
+
+
+    void DrawRing::Clear(void) {
+
+        for (int i = 0; i < num_segments_; i++) {
+            if (fence_[i]) {
+                glDeleteSync(fence_[i]);
+                fence_[i] = 0;
+            }
+        }
+        if (buffer_) {
+            if (mapped_) {
+                GLState::BindBuffer(GL_UNIFORM_BUFFER, buffer_);
+                glUnmapBuffer(GL_UNIFORM_BUFFER);
+                mapped_ = NULL;
+            }
+            GLState::ForgetBuffer(buffer_);
+            glDeleteBuffers(1, &buffer_);
+            buffer_ = 0;
+        }
+        segment_ = 0;
+        slot_ = 0;
+        open_ = false;
+    }
+
+} // namespace game
@@ -0,0 +1,87 @@
+#ifndef DRAW_RING_H_
+#define DRAW_RING_H_
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+namespace game {
+
+    // Data of one draw, as laid out in the PerDraw uniform block. Normals
+    // are transformed as directions, so the last column of the normal
+    // matrix is free; it holds the texture array layers of the texture and
+    // normal map
+    struct DrawUniforms {
+        glm::mat4 world_mat;
+        glm::mat4 normal_mat;
+    };
+
+    // One draw of an indirect command buffer, as read by
+    // glMultiDrawElementsIndirect
+    struct DrawElementsCommand {
+        GLuint count;
+        GLuint instance_count;
+        GLuint first_index;
+        GLint base_vertex;
+        GLuint base_instance;
+    };
+
+    // Binding point of the PerDraw uniform block
+    const GLuint draw_uniforms_binding = 1;
+
+    // Most instances written to the ring for one draw
+    const GLuint max_draw_instances = 1024;
+
+    // Ring buffer that receives the PerDraw data of every node drawn. The
+    // buffer is split in one segment per frame in flight; a segment is only
+    // written again once the fence placed after its frame has passed, so
+    // the CPU never overwrites data that the GPU still reads. Where the
+    // driver supports it the buffer stays mapped for the whole run and a
+    // draw costs a copy and a glBindBufferRange. Only used from the thread
+    // that owns the OpenGL context
+    class DrawRing {
+
+        public:
+            // Start filling the segment of a new frame, waiting for the GPU
+            // to finish with it if needed. Nothing happens if a frame is
+            // already open
+            static void BeginFrame(void);
+            // Close the frame; its segment is fenced and not reused until
+            // the GPU has drawn it
+            static void EndFrame(void);
+            // Copy the data of one draw into the ring and bind it to the
+            // PerDraw block. Opens a frame if none is open
+            static void Push(const DrawUniforms &data);
+            // Copy the data of count instances, one after the other, into
+            // the ring. Returns the index of the first one in the buffer,
+            // seen as an array of DrawUniforms
+            static GLuint PushInstances(const DrawUniforms *data, GLuint count);
+            // Reserve consecutive slots in the current frame and copy data
+            // to them; returns the offset of the first one
+            static GLintptr Write(const void *data, GLsizeiptr size);
+            // Buffer of the ring, for instance attributes and indirect
+            // commands that read from it
+            static GLuint GetBuffer(void);
+            // Delete the buffer and fences
+            static void Clear(void);
+
+        private:
+            // Create the buffer on first use, once there is a context
+            static void Init(void);
+
+            static const int num_segments_ = 3; // Frames in flight
+            static const GLuint slots_per_segment_ = 4096; // Draws per frame
+            static GLuint buffer_; // Uniform buffer of the ring
+            static GLubyte *mapped_; // Persistent mapping, or NULL
+            static GLintptr slot_size_; // Slot stride, aligned for binding
+            static GLsync fence_[num_segments_]; // Set when a frame is closed
+            static int segment_; // Segment of the current frame
+            static GLuint slot_; // Next free slot in the segment
+            static bool open_; // Whether a frame is being filled
+
+    }; // class DrawRing
+
+} // namespace game
+
+#endif // DRAW_RING_H_
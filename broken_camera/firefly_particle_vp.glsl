@@ -6,11 +6,21 @@ in vec3 normal;
 in vec3 color;
 in vec2 uv;
 
-// Uniform (global) buffer
-uniform mat4 world_mat;
-uniform mat4 view_mat;
-uniform mat4 normal_mat;
-uniform float timer;
+// Transforms of the node being drawn, from the per-draw ring buffer
+layout(std140) uniform PerDraw {
+    mat4 world_mat;
+    mat4 normal_mat;
+};
+
+// Per-frame data shared by all materials, filled once per frame
+layout(std140) uniform PerFrame {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 light_position;
+    vec4 light_color;
+    float timer;
+    int spec_power;
+};
 
 // Attributes forwarded to the geometry shader
 out vec4 particle_color;
@@ -0,0 +1,77 @@
+#include "frustum.h"
+
+namespace game {
+
+    Frustum::Frustum(void) {
+
+        // Planes that hold everything
+        for (int i = 0; i < 6; i++) {
+            plane_[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        }
+    }
+
+
+    Frustum::Frustum(const glm::mat4 &view_projection) {
+
+        // A point is inside when -w <= x, y, z <= w in clip space. Each
+        // bound is a plane made of the last row plus or minus another
+        // row of the matrix, which is stored by columns
+        glm::vec4 row[4];
+        for (int i = 0; i < 4; i++) {
+            row[i] = glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+        }
+        plane_[0] = row[3] + row[0]; // Left
+        plane_[1] = row[3] - row[0]; // Right
+        plane_[2] = row[3] + row[1]; // Bottom
+        plane_[3] = row[3] - row[1]; // Top
+        plane_[4] = row[3] + row[2]; // Near
+        plane_[5] = row[3] - row[2]; // Far
+
+        // Normalize so that distances to the planes are in world units
+        for (int i = 0; i < 6; i++) {
+            plane_[i] /= glm::length(glm::vec3(plane_[i]));
+        }
+    }
+
+
+    bool Frustum::Intersects(const BoundingSphere &sphere) const {
+
+        if (sphere.radius < 0.0f) {
+            return true;
+        }
+        for (int i = 0; i < 6; i++) {
+            if (glm::dot(glm::vec3(plane_[i]), sphere.center) + plane_[i].w < -sphere.radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+
+    BoundingSphere merge_bounds(const BoundingSphere &a, const BoundingSphere &b) {
+
+        // Unknown bounds stay unknown
+        if ((a.radius < 0.0f) || (b.radius < 0.0f)) {
+            BoundingSphere unknown = { a.center, -1.0f };
+            return unknown;
+        }
+
+        // One sphere may already hold the other
+        glm::vec3 offset = b.center - a.center;
+        float distance = glm::length(offset);
+        if (distance + b.radius <= a.radius) {
+            return a;
+        }
+        if (distance + a.radius <= b.radius) {
+            return b;
+        }
+
+        // Otherwise the sphere spans from the far side of one to the far
+        // side of the other
+        BoundingSphere merged;
+        merged.radius = (distance + a.radius + b.radius) * 0.5f;
+        merged.center = a.center + offset * ((merged.radius - a.radius) / distance);
+        return merged;
+    }
+
+} // namespace game
@@ -0,0 +1,37 @@
+#ifndef FRUSTUM_H_
+#define FRUSTUM_H_
+
+#include <glm/glm.hpp>
+
+namespace game {
+
+    // Bounding sphere in world space. A negative radius marks bounds that
+    // are not known, which are never culled
+    struct BoundingSphere {
+        glm::vec3 center;
+        float radius;
+    };
+
+    // The six planes of a view frustum, facing inwards, taken from a
+    // projection and view matrix
+    class Frustum {
+
+        public:
+            Frustum(void);
+            Frustum(const glm::mat4 &view_projection);
+
+            // Whether some of the sphere may be inside the frustum. Spheres
+            // of unknown bounds always are
+            bool Intersects(const BoundingSphere &sphere) const;
+
+        private:
+            glm::vec4 plane_[6]; // Normal and distance, normalized
+
+    }; // class Frustum
+
+    // Smallest sphere that holds both spheres
+    BoundingSphere merge_bounds(const BoundingSphere &a, const BoundingSphere &b);
+
+} // namespace game
+
+#endif // FRUSTUM_H_
@@ -5,6 +5,11 @@
 
 #include "game.h"
 #include "path_config.h"
+#include "render_stats.h"
+#include "draw_ring.h"
+#include "sampler_cache.h"
+#include "gl_state.h"
+#include "node_pool.h"
 #include <string>
 
 namespace game {
@@ -28,6 +33,9 @@ glm::vec3 camera_look_at_g(-51,67,800);
 glm::vec3 camera_up_g(0.0, 1.0, 0.0);
 static double last_time = 0;
 
+// GPU memory for meshes and textures before unused ones are evicted
+const size_t resource_memory_budget_g = 512 * 1024 * 1024;
+
 // Materials 
 const std::string material_directory_g = MATERIAL_DIRECTORY;
 
@@ -35,6 +43,8 @@ const std::string material_directory_g = MATERIAL_DIRECTORY;
 Game::Game(void){
 
     // Don't do work in the constructor, leave it for the Init() function
+    gui_ = NULL;
+    loading_screen_ = NULL;
 }
 
 
@@ -47,7 +57,7 @@ void Game::Init(void){
     InitEventHandlers();
 
     // Set variables
-    game_state_ = init;
+    game_state_ = loading;
 }
 
        
@@ -85,8 +95,8 @@ void Game::InitWindow(void){
 void Game::InitView(void){
 
     // Set up z-buffer
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
+    GLState::Enable(GL_DEPTH_TEST);
+    GLState::DepthFunc(GL_LESS);
 
     // Set viewport
     int width, height;
@@ -123,8 +133,9 @@ void Game::InitView(void){
     filename = std::string(MATERIAL_DIRECTORY) + std::string("/shaders/pond");
     resman_.LoadResource(Material, "PondMat", filename.c_str());
 
-    Ui* a = new Ui("LoadingScreen", resman_.GetResource("SimpleWall"), resman_.GetResource("PlainTexMaterial"), resman_.GetResource("Loading"));
+    Ui* a = NodePool::Create<Ui>("LoadingScreen", resman_.GetResource("SimpleWall"), resman_.GetResource("PlainTexMaterial"), resman_.GetResource("Loading"));
     a->Draw(&camera_);
+    NodePool::Destroy(a);
     
     // Push buffer drawn in the background onto the display
     glfwSwapBuffers(window_);
@@ -144,6 +155,14 @@ void Game::InitEventHandlers(void){
 
 void Game::SetupResources(void){
 
+    double start_time = glfwGetTime();
+
+    resman_.SetMemoryBudget(resource_memory_budget_g);
+
+    // Files are read on worker threads; the OpenGL objects are created
+    // below, on this thread
+    AssetLoader loader(&resman_);
+
     // Setup drawing to texture
     scene_.SetupDrawToTexture();
 
@@ -170,74 +189,74 @@ void Game::SetupResources(void){
     {
         
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/material");
-        resman_.LoadResource(Material, "ObjectMaterial", filename.c_str());
+        loader.LoadResource(Material, "ObjectMaterial", filename.c_str());
 
         // Load material to be applied to gui
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/ui");
-        resman_.LoadResource(Material, "GuiMaterial", filename.c_str());
+        loader.LoadResource(Material, "GuiMaterial", filename.c_str());
 
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/texture_and_normal");
-        resman_.LoadResource(Material, "TextureNormalMaterial", filename.c_str());
+        loader.LoadResource(Material, "TextureNormalMaterial", filename.c_str());
 
         
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/random_textured_material");
-        resman_.LoadResource(Material, "RandomTexMaterial", filename.c_str());
+        loader.LoadResource(Material, "RandomTexMaterial", filename.c_str());
 
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/normal_map");
-        resman_.LoadResource(Material, "TerrainMat", filename.c_str());
+        loader.LoadResource(Material, "TerrainMat", filename.c_str());
 
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/screen_space");
-        resman_.LoadResource(Material, "ScreenSpaceMaterial", filename.c_str());
+        loader.LoadResource(Material, "ScreenSpaceMaterial", filename.c_str());
 
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/shaders/cubemap_material");
-        resman_.LoadResource(Material, "SkyboxMaterial", filename.c_str());
+        loader.LoadResource(Material, "SkyboxMaterial", filename.c_str());
 
         /// Particle Systems ///
 
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/Sand-nato");
-        resman_.LoadResource(Material, "PS-SandTornatoMaterial", filename.c_str());
+        loader.LoadResource(Material, "PS-SandTornatoMaterial", filename.c_str());
 
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/Fire");
-        resman_.LoadResource(Material, "PS-Fire", filename.c_str());
+        loader.LoadResource(Material, "PS-Fire", filename.c_str());
 
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/firefly_particle");
-        resman_.LoadResource(Material, "PS-FirFlyMaterial", filename.c_str());
+        loader.LoadResource(Material, "PS-FirFlyMaterial", filename.c_str());
        
     }
 
     ////// TEXTURES ////// 
     {
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/moon.jpg");
-        resman_.LoadResource(Texture, "MoonTex", filename.c_str());
+        loader.LoadResource(Texture, "MoonTex", filename.c_str());
 
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/sparkle.png");
-        resman_.LoadResource(Texture, "sparkle", filename.c_str());
+        loader.LoadResource(Texture, "sparkle", filename.c_str());
 
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/SandParticle.png");
-        resman_.LoadResource(Texture, "SandParticle", filename.c_str());
+        loader.LoadResource(Texture, "SandParticle", filename.c_str());
 
 
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/rocky.png");
-        resman_.LoadResource(Texture, "Texture1", filename.c_str());
+        loader.LoadResource(Texture, "Texture1", filename.c_str());
         
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/noise.png");
-        resman_.LoadResource(Texture, "NoiseTex", filename.c_str());
+        loader.LoadResource(Texture, "NoiseTex", filename.c_str());
 
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/sandy_with_artificial_shadows.png");
-         resman_.LoadResource(Texture, "TextureMaterial", filename.c_str());
+         loader.LoadResource(Texture, "TextureMaterial", filename.c_str());
 
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/T5NormalMap.png");
-        resman_.LoadResource(Texture, "Texture2", filename.c_str());
+        loader.LoadResource(Texture, "Texture2", filename.c_str());
    
 
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/SkyBoxCubeMap.png");
-        resman_.LoadResource(Texture, "CubeMap", filename.c_str());
+        loader.LoadResource(Texture, "CubeMap", filename.c_str());
 
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Sun.png");
-        resman_.LoadResource(Texture, "RedStar", filename.c_str());
+        loader.LoadResource(Texture, "RedStar", filename.c_str());
 
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Orb_Texture.png");
-        resman_.LoadResource(Texture, "OrbTexture", filename.c_str());
+        loader.LoadResource(Texture, "OrbTexture", filename.c_str());
     }
 
  
@@ -246,100 +265,128 @@ void Game::SetupResources(void){
     {
         //Obelisk
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/models/Obelisk.obj");
-        resman_.LoadResource(Mesh, "ObeliskMesh", filename.c_str());
+        loader.LoadResource(Mesh, "ObeliskMesh", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Obelisk_Texture.png");
-        resman_.LoadResource(Texture, "ObeliskTexture", filename.c_str());
+        loader.LoadResource(Texture, "ObeliskTexture", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Obelisk_Normal.png");
-        resman_.LoadResource(Texture, "ObeliskNormal", filename.c_str());
+        loader.LoadResource(Texture, "ObeliskNormal", filename.c_str());
 
         //Watch Tower
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/models/Watch_Tower.obj");
-        resman_.LoadResource(Mesh, "WatchTowerBaseMesh", filename.c_str());
+        loader.LoadResource(Mesh, "WatchTowerBaseMesh", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Watch_Tower_Texture.png");
-        resman_.LoadResource(Texture, "WatchTowerBaseTexture", filename.c_str());
+        loader.LoadResource(Texture, "WatchTowerBaseTexture", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Watch_Tower_Normal.png");
-        resman_.LoadResource(Texture, "WatchTowerBaseNormal", filename.c_str());
+        loader.LoadResource(Texture, "WatchTowerBaseNormal", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/models/Watch_Eye.obj");
-        resman_.LoadResource(Mesh, "WatchEyeMesh", filename.c_str());
+        loader.LoadResource(Mesh, "WatchEyeMesh", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Watch_Eye_Texture.png");
-        resman_.LoadResource(Texture, "WatchEyeTexture", filename.c_str());
+        loader.LoadResource(Texture, "WatchEyeTexture", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Watch_Eye_Normal.png");
-        resman_.LoadResource(Texture, "WatchEyeNormal", filename.c_str());
+        loader.LoadResource(Texture, "WatchEyeNormal", filename.c_str());
 
         //Palm Tree
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/models/Palm_tree_trunk.obj");
-        resman_.LoadResource(Mesh, "PalmTreeTrunkMesh", filename.c_str());
+        loader.LoadResource(Mesh, "PalmTreeTrunkMesh", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Palm_tree_trunk_Texture.png");
-        resman_.LoadResource(Texture, "PalmTreeTrunkTexture", filename.c_str());
+        loader.LoadResource(Texture, "PalmTreeTrunkTexture", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Palm_tree_Normal.png");
-        resman_.LoadResource(Texture, "PalmTreeNormal", filename.c_str());
+        loader.LoadResource(Texture, "PalmTreeNormal", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/models/Palm_tree_head.obj");
-        resman_.LoadResource(Mesh, "PalmTreeHeadMesh", filename.c_str());
+        loader.LoadResource(Mesh, "PalmTreeHeadMesh", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Palm_tree_head_Texture.png");
-        resman_.LoadResource(Texture, "PalmTreeHeadTexture", filename.c_str());
+        loader.LoadResource(Texture, "PalmTreeHeadTexture", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/models/Palm_tree_leaf.obj");
-        resman_.LoadResource(Mesh, "PalmTreeLeafMesh", filename.c_str());
+        loader.LoadResource(Mesh, "PalmTreeLeafMesh", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Palm_tree_leaf_Texture.png");
-        resman_.LoadResource(Texture, "PalmTreeLeafTexture", filename.c_str());
+        loader.LoadResource(Texture, "PalmTreeLeafTexture", filename.c_str());
 
         //Dry Shrub
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/models/Dry_shrub.obj");
-        resman_.LoadResource(Mesh, "DryShrubMesh", filename.c_str());
+        loader.LoadResource(Mesh, "DryShrubMesh", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Dry_shrub_Texture.png");
-        resman_.LoadResource(Texture, "DryShrubMeshTexture", filename.c_str());
+        loader.LoadResource(Texture, "DryShrubMeshTexture", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Dry_shrub_Normal.png");
-        resman_.LoadResource(Texture, "DryShrubMeshNormal", filename.c_str());
+        loader.LoadResource(Texture, "DryShrubMeshNormal", filename.c_str());
 
         //Tree
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/models/Tree.obj");
-        resman_.LoadResource(Mesh, "TreeMesh", filename.c_str());
+        loader.LoadResource(Mesh, "TreeMesh", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Tree_Texture.png");
-        resman_.LoadResource(Texture, "TreeTexture", filename.c_str());
+        loader.LoadResource(Texture, "TreeTexture", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Tree_Normal.png");
-        resman_.LoadResource(Texture, "TreeNormal", filename.c_str());
+        loader.LoadResource(Texture, "TreeNormal", filename.c_str());
 
         //Hut 1
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/models/Hut_1.obj");
-        resman_.LoadResource(Mesh, "Hut1Mesh", filename.c_str());
+        loader.LoadResource(Mesh, "Hut1Mesh", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Hut_1_Texture.png");
-        resman_.LoadResource(Texture, "Hut1Texture", filename.c_str());
+        loader.LoadResource(Texture, "Hut1Texture", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Hut_1_Normal.png");
-        resman_.LoadResource(Texture, "Hut1Normal", filename.c_str());
+        loader.LoadResource(Texture, "Hut1Normal", filename.c_str());
 
         //Oasis Plant
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/models/Oasis_plant.obj");
-        resman_.LoadResource(Mesh, "OasisPlantMesh", filename.c_str());
+        loader.LoadResource(Mesh, "OasisPlantMesh", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Oasis_plant_Texture.png");
-        resman_.LoadResource(Texture, "OasisPlantTexture", filename.c_str());
+        loader.LoadResource(Texture, "OasisPlantTexture", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Oasis_plant_Normal.png");
-        resman_.LoadResource(Texture, "OasisPlantNormal", filename.c_str());
+        loader.LoadResource(Texture, "OasisPlantNormal", filename.c_str());
 
         //Tumbleweed
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/models/Tumbleweed.obj");
-        resman_.LoadResource(Mesh, "TumbleweedMesh", filename.c_str());
+        loader.LoadResource(Mesh, "TumbleweedMesh", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Dry_shrub_Texture.png");
-        resman_.LoadResource(Texture, "TumbleweedTexture", filename.c_str());
+        loader.LoadResource(Texture, "TumbleweedTexture", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Dry_shrub_Normal.png");
-        resman_.LoadResource(Texture, "TumbleweedNormal", filename.c_str());
+        loader.LoadResource(Texture, "TumbleweedNormal", filename.c_str());
 
         //OtherTree
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/models/Tree_Trunk.obj");
-        resman_.LoadResource(Mesh, "TreeTrunkMesh", filename.c_str());
+        loader.LoadResource(Mesh, "TreeTrunkMesh", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Tree_Trunk_Texture.png");
-        resman_.LoadResource(Texture, "TreeTrunkTexture", filename.c_str());
+        loader.LoadResource(Texture, "TreeTrunkTexture", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/Tree_Trunk_Normal.png");
-        resman_.LoadResource(Texture, "TreeTrunkNormal", filename.c_str());
+        loader.LoadResource(Texture, "TreeTrunkNormal", filename.c_str());
 
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/models/Tree_Branch_1.obj");
-        resman_.LoadResource(Mesh, "TreeBranches1Mesh", filename.c_str());
+        loader.LoadResource(Mesh, "TreeBranches1Mesh", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/models/Tree_Branch_2.obj");
-        resman_.LoadResource(Mesh, "TreeBranches2Mesh", filename.c_str());
+        loader.LoadResource(Mesh, "TreeBranches2Mesh", filename.c_str());
         filename = std::string(MATERIAL_DIRECTORY) + std::string("/models/Tree_Branch_3.obj");
-        resman_.LoadResource(Mesh, "TreeBranches3Mesh", filename.c_str());
+        loader.LoadResource(Mesh, "TreeBranches3Mesh", filename.c_str());
 
     }
     
-
+    // Add the resources as the workers finish them. In between, keep the
+    // window responsive and show the progress on the loading screen
+    while (!loader.Upload(1.0 / 60.0)) {
+        DrawLoadScreen(loader.GetProgress());
+    }
+    DrawLoadScreen(1.0f);
+    NodePool::Destroy(loading_screen_);
+    loading_screen_ = NULL;
+
+    // Textures of the props drawn with the texture and normal material
+    // share arrays, so their nodes batch together
+    resman_.PackTextureArray("PropTextures", { "ObeliskTexture", "WatchTowerBaseTexture", "WatchEyeTexture",
+        "PalmTreeTrunkTexture", "PalmTreeHeadTexture", "PalmTreeLeafTexture", "DryShrubMeshTexture", "TreeTexture",
+        "Hut1Texture", "OasisPlantTexture", "TumbleweedTexture", "TreeTrunkTexture" });
+    resman_.PackTextureArray("PropNormals", { "ObeliskNormal", "WatchTowerBaseNormal", "WatchEyeNormal",
+        "PalmTreeNormal", "DryShrubMeshNormal", "TreeNormal", "Hut1Normal", "OasisPlantNormal", "TumbleweedNormal",
+        "TreeTrunkNormal" });
+    // The light uses the same material, so its texture is an array too
+    resman_.PackTextureArray("LightTextures", { "RedStar" });
+
+    // Report load times, so that runs with and without the mesh cache can
+    // be compared
+    const MeshLoadStats &stats = resman_.GetMeshLoadStats();
+    std::cout << "Resources loaded in " << (glfwGetTime() - start_time) * 1000.0 << " ms with " << loader.GetNumThreads() << " threads" << std::endl;
+    std::cout << "Meshes: " << stats.num_cached << " from cache in " << stats.cached_ms << " ms, " <<
+        stats.num_parsed << " from OBJ files in " << stats.parsed_ms << " ms" << std::endl;
+    const ProgramLoadStats &program_stats = resman_.GetProgramLoadStats();
+    std::cout << "Shader programs: " << program_stats.num_cached << " from cache in " << program_stats.cached_ms << " ms, " <<
+        program_stats.num_compiled << " compiled in " << program_stats.compiled_ms << " ms" << std::endl;
 }
 
 
@@ -351,7 +398,7 @@ void Game::SetupScene(void) {
     scene_.SetBackgroundColor(viewport_background_color_g);
     
     //player
-    SceneNode* playerShape = new SceneNode("PlayerShape", resman_.GetResource("Orb"), resman_.GetResource("ObjectMaterial"));
+    SceneNode* playerShape = NodePool::Create<SceneNode>("PlayerShape", resman_.GetResource("Orb"), resman_.GetResource("ObjectMaterial"));
     player_.SetShape(playerShape);
     player_.SetPosition(glm::vec3(-370, 40, 420));
     scene_.AddNode(playerShape);
@@ -372,12 +419,13 @@ void Game::SetupScene(void) {
     
     //skybox init
     {
-        SceneNode* skyBox = new SceneNode("SkyBox", resman_.GetResource("SkyBox"), resman_.GetResource("SkyboxMaterial"), resman_.GetResource("CubeMap"));
+        SceneNode* skyBox = NodePool::Create<SceneNode>("SkyBox", resman_.GetResource("SkyBox"), resman_.GetResource("SkyboxMaterial"), resman_.GetResource("CubeMap"));
         skyBox->Scale(glm::vec3(camera_far_clip_distance_g*1.1)); // same dist as far cliping plane from the center of the box
         scene_.skyBox_ = skyBox;
     }
 
     StartScreen();
+    game_state_ = init;
 
     glfwSetInputMode(window_, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 }
@@ -393,8 +441,6 @@ void Game::MainLoop(void){
             double current_time = glfwGetTime();
             double delta_time = current_time - last_time;
             if ((delta_time) > 0.05){
-                glEnable(GL_CULL_FACE);       
-
                 // updates game objects
                 camera_.UpdateLightInfo(l->GetTransf() * glm::vec4(l->GetPosition(), 1.0), l->GetLightCol(), l->GetSpecPwr());
                 scene_.Update(delta_time);
@@ -440,13 +486,20 @@ void Game::MainLoop(void){
             //show win screen
             std::string filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/WinScreen.png");
             resman_.LoadResource(Texture, "Winner", filename.c_str());
-            gui_ = new Ui("win", resman_.GetResource("SimpleWall"), resman_.GetResource("PlainTexMaterial"), resman_.GetResource("Winner"));
+            NodePool::Destroy(gui_);
+            gui_ = NodePool::Create<Ui>("win", resman_.GetResource("SimpleWall"), resman_.GetResource("PlainTexMaterial"), resman_.GetResource("Winner"));
             gui_->Draw(&camera_);
             glfwSwapBuffers(window_);
+            DrawRing::EndFrame();
             game_state_ = lost;
             continue;
         }
 
+        // Camera, light and time are the same for every draw of the frame
+        camera_.SetupFrameUniforms();
+        DrawRing::BeginFrame();
+        RenderStats::BeginFrame();
+
         // handles updates when player is alive
         if (game_state_ != dead) { 
             // Draw to the scene
@@ -464,22 +517,32 @@ void Game::MainLoop(void){
             
             // Process the texture with a screen-space effect and display
             // the texture
-            float death_duration = scene_.DisplayTexture(resman_.GetResource("ScreenSpaceMaterial")->GetResource());
+            float death_duration = scene_.DisplayTexture(resman_.GetResource("ScreenSpaceMaterial"));
             if (death_duration >= 10) {
                 game_state_ = lost;
                 
                 //update display to game over screen
                 std::string filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/GameOver.png");
                 resman_.LoadResource(Texture, "GameOver", filename.c_str());
-                gui_ = new Ui("LossScreen", resman_.GetResource("SimpleWall"), resman_.GetResource("PlainTexMaterial"), resman_.GetResource("GameOver"));
+                NodePool::Destroy(gui_);
+                gui_ = NodePool::Create<Ui>("LossScreen", resman_.GetResource("SimpleWall"), resman_.GetResource("PlainTexMaterial"), resman_.GetResource("GameOver"));
                 gui_->Draw(&camera_);
                 glfwSwapBuffers(window_);
+                DrawRing::EndFrame();
                 continue;
             }
         }
             
         // Push buffer drawn in the background onto the display
         glfwSwapBuffers(window_);
+        DrawRing::EndFrame();
+        RenderStats::EndFrame();
+
+        // Nodes removed during the frame, e.g. collected orbs
+        scene_.FlushRemovals();
+
+        // Free meshes and textures no longer drawn if over the budget
+        resman_.Trim();
 
         // Update other events like input handling
         glfwPollEvents();
@@ -514,11 +577,23 @@ void Game::KeyCallback(GLFWwindow* window, int key, int scancode, int action, in
             std::cout << "z:" << z << std::endl;
             std::cout << "orb_positions.push_back(glm::vec3(" << x << "," << y << "," << z << "));" << std::endl;
         }
+        // Print what the last frame drew
+        if (key == GLFW_KEY_F && action == GLFW_PRESS) {
+            RenderStats::Print();
+            game->resman_.PrintMemoryStats();
+            NodePool::PrintStats();
+        }
+        // Switch levels of detail on and off
+        if (key == GLFW_KEY_L && action == GLFW_PRESS) {
+            SceneNode::SetLodEnabled(!SceneNode::GetLodEnabled());
+            std::cout << "Levels of detail " << (SceneNode::GetLodEnabled() ? "on" : "off") << std::endl;
+        }
     }
     // handles start-up key-strokes
     else if (game->game_state_ == init && key == GLFW_KEY_SPACE) {
         game->game_state_ = inProgress;  
-        game->gui_ = new Ui("Hud", game->resman_.GetResource("SimpleWall"), game->resman_.GetResource("GuiMaterial"), game->resman_.GetResource("NoiseTex"));
+        NodePool::Destroy(game->gui_);
+        game->gui_ = NodePool::Create<Ui>("Hud", game->resman_.GetResource("SimpleWall"), game->resman_.GetResource("GuiMaterial"), game->resman_.GetResource("NoiseTex"));
     }
 
  
@@ -537,6 +612,18 @@ void Game::ResizeCallback(GLFWwindow* window, int width, int height){
 
 Game::~Game(){
     
+    // Destroy the scene before the resources its nodes hold, then free
+    // the node pools at once
+    NodePool::Destroy(gui_);
+    NodePool::Destroy(loading_screen_);
+    scene_.Clear();
+    NodePool::Clear();
+
+    // Free the OpenGL objects while the context is still there
+    resman_.Clear();
+    DrawRing::Clear();
+    SamplerCache::Clear();
+    RenderStats::Clear();
     glfwTerminate();
 }
 
@@ -552,7 +639,7 @@ void Game::CreateTrees() {
     Resource* thorn_geom = resman_.GetResource("thorn");
 
     // creates tree instance and updates attributes
-    Tree* tree = new Tree("tree", geom, mat, 20, 1, thorn_geom, resman_.GetResource("MoonTex"));
+    Tree* tree = NodePool::Create<Tree>("tree", geom, mat, 20, 1, thorn_geom, resman_.GetResource("MoonTex"));
     tree->SetPosition(glm::vec3(0, -5, 790));
     scene_.AddNode(tree);
     tree->createBranches(branch_geom, mat, 4);
@@ -568,12 +655,12 @@ void Game::CreateTrees() {
 // movement function for debugging
 void Game::DebugCameraMovement()
 {
-    double* mouseX = new double(0);
-    double* mouseY = new double(0);
+    double mouseX = 0.0;
+    double mouseY = 0.0;
 
-    glfwGetCursorPos(window_, mouseX, mouseY);
+    glfwGetCursorPos(window_, &mouseX, &mouseY);
 
-    glm::vec2 mousePosition = glm::vec2(*mouseX, *mouseY);
+    glm::vec2 mousePosition = glm::vec2(mouseX, mouseY);
 
     glm::vec2 mouseSlide = mousePosition - lastFrameMousePosition_;
 
@@ -626,34 +713,56 @@ void Game::DebugCameraMovement()
 // creates a scene node instance
 SceneNode* Game::CreateInstance(std::string entity_name, std::string object_name, std::string material_name, std::string texture_name, std::string normal_name) {
 
-    Resource* geom = resman_.GetResource(object_name);
-    if (!geom) {
+    return CreateInstance(entity_name, GetInstanceResources(object_name, material_name, texture_name, normal_name));
+}
+
+
+// creates a scene node instance from resources looked up beforehand
+SceneNode* Game::CreateInstance(std::string entity_name, const InstanceResources &resources) {
+
+    Resource* geom = resman_.GetResource(resources.geometry);
+    Resource* mat = resman_.GetResource(resources.material);
+    if (!geom || !mat) {
+        throw(GameException(std::string("Missing resources for node \"") + entity_name + std::string("\"")));
+    }
+    Resource* tex = resman_.GetResource(resources.texture);
+    Resource* normal_map = resman_.GetResource(resources.normal_map);
+
+    SceneNode* scn = scene_.CreateNode(entity_name, geom, mat, tex, normal_map);
+    return scn;
+}
+
+
+// looks up the resources of a scene node by name
+InstanceResources Game::GetInstanceResources(std::string object_name, std::string material_name, std::string texture_name, std::string normal_name) {
+
+    InstanceResources resources;
+
+    resources.geometry = resman_.GetMesh(object_name);
+    if (resources.geometry.IsNull()) {
         throw(GameException(std::string("Could not find resource \"") + object_name + std::string("\"")));
     }
 
-    Resource* mat = resman_.GetResource(material_name);
-    if (!mat) {
+    resources.material = resman_.GetMaterial(material_name);
+    if (resources.material.IsNull()) {
         throw(GameException(std::string("Could not find resource \"") + material_name + std::string("\"")));
     }
 
-    Resource* tex = NULL;
     if (texture_name != "") {
-        tex = resman_.GetResource(texture_name);
-        if (!tex) {
-            throw(GameException(std::string("Could not find resource \"") + material_name + std::string("\"")));
+        resources.texture = resman_.GetTexture(texture_name);
+        if (resources.texture.IsNull()) {
+            throw(GameException(std::string("Could not find resource \"") + texture_name + std::string("\"")));
         }
     }
 
-    Resource* norm = NULL;
     if (normal_name != "") {
-        norm = resman_.GetResource(normal_name);
-        if (!norm) {
-            throw(GameException(std::string("Could not find resource \"") + material_name + std::string("\"")));
+        resources.normal_map = resman_.GetTexture(normal_name);
+        if (resources.normal_map.IsNull()) {
+            throw(GameException(std::string("Could not find resource \"") + normal_name + std::string("\"")));
         }
     }
 
-    SceneNode* scn = scene_.CreateNode(entity_name, geom, mat, tex);
-    return scn;
+    return resources;
 }
 
 void Game::HandleCollisions() {
@@ -665,7 +774,7 @@ void Game::HandleCollisions() {
     }
 
     // world Object collisions
-    std::vector<SceneNode*> collidables = scene_.GetCollidables();
+    const std::vector<SceneNode*> &collidables = scene_.GetCollidables();
     for (int i = 0; i < collidables.size(); ) {
         SceneNode* curr_node = collidables[i];
         float node_dist = glm::length(curr_node->GetPosition() - player_.GetPosition());
@@ -680,7 +789,7 @@ void Game::HandleCollisions() {
                     game_state_ = won;
                 }
                 std::cout << "You collected an Orb!" << std::endl;
-                scene_.RemoveCollidable(curr_node->GetName());
+                scene_.RemoveCollidable(curr_node);
             }
         }
         i++;
@@ -711,7 +820,7 @@ Orb* Game::createOrbInstance(std::string entity_name, std::string object_name, s
         }
     }
 
-    Orb* orb = new Orb(entity_name, geom, mat, tex);
+    Orb* orb = NodePool::Create<Orb>(entity_name, geom, mat, tex);
     orb->SetScale(glm::vec3(10, 10, 10));
     scene_.AddNode(orb);
     orbs_left_++;
@@ -720,10 +829,12 @@ Orb* Game::createOrbInstance(std::string entity_name, std::string object_name, s
     orb->AddChild("Ring2", resman_.GetResource("Ring"), resman_.GetResource("RandomTexMaterial"), resman_.GetResource("OrbTexture"));
     orb->AddChild("Ring3", resman_.GetResource("Ring"), resman_.GetResource("RandomTexMaterial"), resman_.GetResource("OrbTexture"));
 
-    // scales the orbs
+    // scales the orbs. The rings share RandomTexMaterial, which reads
+    // world_mat per instance, so they are drawn as instances
     std::vector<SceneNode*> children = orb->GetChildren();
     for (int i = 0; i < children.size(); ++i) {
         children[i]->SetScale(glm::vec3(10, 10, 10));
+        children[i]->SetInstanced(true);
     }
 
     return orb;
@@ -747,7 +858,7 @@ void Game::createTerrain(const char* file_name, glm::vec3 pos) {
     resman_.CreatePlane("terrain", terrain_l, terrain_w, 300, 300, heightMap);
 
     // adds to scene
-    Terrain* t = new Terrain("terrain", resman_.GetResource("terrain"), resman_.GetResource("TerrainMat"), resman_.GetResource("Texture1"), resman_.GetResource("Texture2"), heightMap, terrain_l, terrain_w);
+    Terrain* t = NodePool::Create<Terrain>("terrain", resman_.GetResource("terrain"), resman_.GetResource("TerrainMat"), resman_.GetResource("Texture1"), resman_.GetResource("Texture2"), heightMap, terrain_l, terrain_w);
     t->SetPosition(pos);
     scene_.AddNode(t);
     terrain_ = t;
@@ -766,7 +877,7 @@ Light* Game::CreateLightInstance(std::string entity_name, std::string object_nam
     }
 
     // creates light object and adds it to the scenegraph to be rendered
-    Light* light = new Light( 800.0f, glm::vec3(1, 0, 0), entity_name, geom, mat, tex);
+    Light* light = NodePool::Create<Light>(800.0f, glm::vec3(1, 0, 0), entity_name, geom, mat, tex);
     scene_.AddNode(light);
 
     return light;
@@ -791,40 +902,42 @@ void Game::createObeliskZone() {
     PlaceObject(obelisk, x, 8, z);
 
     //Watch Towers   
-    game::SceneNode* newWatchTower = CreateInstance("WatchTower1", "WatchTowerBaseMesh", "TextureNormalMaterial", "WatchTowerBaseTexture", "WatchTowerBaseNormal");
+    InstanceResources tower_res = GetInstanceResources("WatchTowerBaseMesh", "TextureNormalMaterial", "WatchTowerBaseTexture", "WatchTowerBaseNormal");
+    InstanceResources eye_res = GetInstanceResources("WatchEyeMesh", "TextureNormalMaterial", "WatchEyeTexture", "WatchEyeNormal");
+    game::SceneNode* newWatchTower = CreateInstance("WatchTower1", tower_res);
     newWatchTower->SetScale(glm::vec3(8, 8, 8));
     PlaceObject(newWatchTower, x + 125, 8, z + 125);
 
-    game::SceneNode* watchEye = CreateInstance("WatchEye1", "WatchEyeMesh", "TextureNormalMaterial", "WatchEyeTexture", "WatchEyeNormal");
+    game::SceneNode* watchEye = CreateInstance("WatchEye1", eye_res);
     watchEye->SetParent(newWatchTower);
     watchEye->SetScale(glm::vec3(12, 12, 12));
     watchEye->Translate(glm::vec3(0, 90, 0));
 
-    newWatchTower = CreateInstance("WatchTower2", "WatchTowerBaseMesh", "TextureNormalMaterial", "WatchTowerBaseTexture", "WatchTowerBaseNormal");
+    newWatchTower = CreateInstance("WatchTower2", tower_res);
     newWatchTower->SetScale(glm::vec3(8, 8, 8));
     newWatchTower->Rotate(glm::angleAxis(glm::pi<float>(), glm::vec3(0, 1, 0)));
     PlaceObject(newWatchTower, x - 125, 8, z - 125);
 
-    watchEye = CreateInstance("WatchEye2", "WatchEyeMesh", "TextureNormalMaterial", "WatchEyeTexture", "WatchEyeNormal");
+    watchEye = CreateInstance("WatchEye2", eye_res);
     watchEye->SetParent(newWatchTower);
     watchEye->SetScale(glm::vec3(12, 12, 12));
     watchEye->Translate(glm::vec3(0, 90, 0));
 
-    newWatchTower = CreateInstance("WatchTower3", "WatchTowerBaseMesh", "TextureNormalMaterial", "WatchTowerBaseTexture", "WatchTowerBaseNormal");
+    newWatchTower = CreateInstance("WatchTower3", tower_res);
     newWatchTower->SetScale(glm::vec3(8, 8, 8));
     PlaceObject(newWatchTower, x + 125, 8, z - 125);
 
-    watchEye = CreateInstance("WatchEye3", "WatchEyeMesh", "TextureNormalMaterial", "WatchEyeTexture", "WatchEyeNormal");
+    watchEye = CreateInstance("WatchEye3", eye_res);
     watchEye->SetParent(newWatchTower);
     watchEye->SetScale(glm::vec3(12, 12, 12));
     watchEye->Translate(glm::vec3(0, 90, 0));
 
-    newWatchTower = CreateInstance("WatchTower4", "WatchTowerBaseMesh", "TextureNormalMaterial", "WatchTowerBaseTexture", "WatchTowerBaseNormal");
+    newWatchTower = CreateInstance("WatchTower4", tower_res);
     newWatchTower->SetScale(glm::vec3(8, 8, 8));
     newWatchTower->Rotate(glm::angleAxis(glm::pi<float>(), glm::vec3(0, 1, 0)));
     PlaceObject(newWatchTower, x - 125, 8, z + 125);
 
-    watchEye = CreateInstance("WatchEye4", "WatchEyeMesh", "TextureNormalMaterial", "WatchEyeTexture", "WatchEyeNormal");
+    watchEye = CreateInstance("WatchEye4", eye_res);
     watchEye->SetParent(newWatchTower);
     watchEye->SetScale(glm::vec3(12, 12, 12));
     watchEye->Translate(glm::vec3(0, 90, 0));    
@@ -846,9 +959,11 @@ void Game::createVillage() {
 
     //Huts
     game::SceneNode* hut;
+    InstanceResources hut_res = GetInstanceResources("Hut1Mesh", "TextureNormalMaterial", "Hut1Texture", "Hut1Normal");
     for (int i = 0; i < x_z_positions.size(); ++i) {
-        hut = CreateInstance("Hut" + i, "Hut1Mesh", "TextureNormalMaterial", "Hut1Texture", "Hut1Normal");
+        hut = CreateInstance("Hut" + i, hut_res);
         hut->SetScale(glm::vec3(8, 8, 8));
+        hut->SetInstanced(true);
         glm::vec3 hutPos = x_z_positions[i];
         PlaceObject(hut, hutPos.x, hutPos.y, hutPos.z);
     }
@@ -877,10 +992,12 @@ void Game::createVillage() {
 
     // instantiates the bushes
     game::SceneNode* bush;
+    InstanceResources bush_res = GetInstanceResources("DryShrubMesh", "TextureNormalMaterial", "DryShrubMeshTexture", "DryShrubMeshNormal");
     for (int j = 0; j < bush_positions.size(); ++j)
     {
-       bush = CreateInstance("DryShrub" + j, "DryShrubMesh", "TextureNormalMaterial", "DryShrubMeshTexture", "DryShrubMeshNormal");
+       bush = CreateInstance("DryShrub" + j, bush_res);
        bush->SetScale(glm::vec3(8, 8, 8));
+       bush->SetInstanced(true);
        glm::vec3 BushPos = bush_positions[j];
        PlaceObject(bush, BushPos.x, BushPos.y, BushPos.z);
     }
@@ -891,16 +1008,20 @@ SceneNode* Game::makePalmTree(int treeNum, glm::vec3 pos) {
     //Palm Tree
     game::SceneNode* palmTreeTrunk = CreateInstance("PalmTreeTrunk" + treeNum, "PalmTreeTrunkMesh", "TextureNormalMaterial", "PalmTreeTrunkTexture", "PalmTreeNormal");
     palmTreeTrunk->SetScale(glm::vec3(8,8,8));
+    palmTreeTrunk->SetInstanced(true);
     game::SceneNode* palmTreeHead = CreateInstance("PalmTreeHead" + treeNum, "PalmTreeHeadMesh", "TextureNormalMaterial", "PalmTreeHeadTexture", "PalmTreeNormal");
     palmTreeHead->SetScale(glm::vec3(8, 8, 8));
+    palmTreeHead->SetInstanced(true);
     palmTreeHead->SetParent(palmTreeTrunk);
 
     // goes through and add leaves to the trees
+    InstanceResources leaf_res = GetInstanceResources("PalmTreeLeafMesh", "TextureNormalMaterial", "PalmTreeLeafTexture", "PalmTreeNormal");
     for (int i = 0; i < 14; i++)
     {
         std::string name = treeNum + "Leaf" + i;
-        game::SceneNode* newLeaf = CreateInstance(name, "PalmTreeLeafMesh", "TextureNormalMaterial", "PalmTreeLeafTexture", "PalmTreeNormal");
+        game::SceneNode* newLeaf = CreateInstance(name, leaf_res);
         newLeaf->SetScale(glm::vec3(8, 8, 8));
+        newLeaf->SetInstanced(true);
         newLeaf->Translate(glm::vec3(0.0, 48.0, 0.0));
         if (i > 7) newLeaf->Rotate(glm::angleAxis(0.5f + 0.04f * (float)i, glm::vec3(1, 0, 0)));
         newLeaf->Rotate(glm::angleAxis((float)i, glm::vec3(0, 1, 0)));
@@ -916,24 +1037,28 @@ SceneNode* Game::makeDeadTree(int treeNum, glm::vec3 pos)
     //SwayingTree
     game::SceneNode* treeTrunk = CreateInstance("TreeTrunk" + treeNum, "TreeTrunkMesh", "TextureNormalMaterial", "TreeTrunkTexture", "TreeTrunkNormal");
     treeTrunk->SetScale(glm::vec3(5, 5, 5));
+    treeTrunk->SetInstanced(true);
     PlaceObject(treeTrunk, -180.0f, 8.0f, 750.0f);
     deadTreeParts.push_back(treeTrunk);
 
     // the branches moving locally to trunk
     game::SceneNode* treeBranch1 = CreateInstance("TreeBranches1" + treeNum, "TreeBranches1Mesh", "TextureNormalMaterial", "TreeTrunkTexture", "TreeTrunkNormal");
     treeBranch1->SetScale(glm::vec3(5, 5, 5));
+    treeBranch1->SetInstanced(true);
     treeBranch1->SetParent(treeTrunk);
     treeBranch1->Translate(glm::vec3(0.0f, 50.0f, 0.0f));
     deadTreeParts.push_back(treeBranch1);
 
     game::SceneNode* treeBranch2 = CreateInstance("TreeBranches2" + treeNum, "TreeBranches2Mesh", "TextureNormalMaterial", "TreeTrunkTexture", "TreeTrunkNormal");
     treeBranch2->SetScale(glm::vec3(5, 5, 5));
+    treeBranch2->SetInstanced(true);
     treeBranch2->SetParent(treeBranch1);
     treeBranch2->Translate(glm::vec3(0.0f, 0.0f, 0.0f));
     deadTreeParts.push_back(treeBranch2);
 
     game::SceneNode* treeBranch3 = CreateInstance("TreeBranches3" + treeNum, "TreeBranches3Mesh", "TextureNormalMaterial", "TreeTrunkTexture", "TreeTrunkNormal");
     treeBranch3->SetScale(glm::vec3(5, 5, 5));
+    treeBranch3->SetInstanced(true);
     treeBranch3->SetParent(treeBranch2);
     treeBranch3->Translate(glm::vec3(0.0f, 0.0f, 0.0f));
     deadTreeParts.push_back(treeBranch3);
@@ -944,38 +1069,22 @@ SceneNode* Game::makeDeadTree(int treeNum, glm::vec3 pos)
 // function that triggers watch tower behaviour when player gets close
 void Game::watchTowerBehaviour(float angle)
 {
-
-    glm::vec3 direction = glm::normalize(camera_.GetPosition() - scene_.GetNode("WatchTower1")->GetPosition());
-    glm::vec3 rotationAxis = glm::normalize(glm::cross(direction, scene_.GetNode("WatchEye1")->GetForward()));
-    float dotP = glm::dot(direction, glm::normalize(scene_.GetNode("WatchTower1")->GetForward()));
-    float ang = glm::acos(dotP);
-
-    if ((glm::distance(camera_.GetPosition(), scene_.GetNode("WatchTower1")->GetPosition())) > 200.0f) scene_.GetNode("WatchEye1")->Rotate(glm::angleAxis(angle * 8.0f, glm::vec3(0.0, 1.0, 0.0)));
-    else scene_.GetNode("WatchEye1")->SetOrientation(glm::normalize(glm::angleAxis(ang, rotationAxis)));
-
-    direction = glm::normalize(camera_.GetPosition() - scene_.GetNode("WatchTower2")->GetPosition());
-    rotationAxis = glm::normalize(glm::cross(direction, scene_.GetNode("WatchEye2")->GetForward()));
-    dotP = glm::dot(direction, glm::normalize(scene_.GetNode("WatchTower2")->GetForward()));
-    ang = glm::acos(dotP);
-
-    if ((glm::distance(camera_.GetPosition(), scene_.GetNode("WatchTower2")->GetPosition())) > 200.0f) scene_.GetNode("WatchEye2")->Rotate(glm::angleAxis(angle * 8.0f, glm::vec3(0.0, 1.0, 0.0)));
-    else scene_.GetNode("WatchEye2")->SetOrientation(glm::normalize(glm::angleAxis(ang, rotationAxis)));
-
-    direction = glm::normalize(camera_.GetPosition() - scene_.GetNode("WatchTower3")->GetPosition());
-    rotationAxis = glm::normalize(glm::cross(direction, scene_.GetNode("WatchEye3")->GetForward()));
-    dotP = glm::dot(direction, glm::normalize(scene_.GetNode("WatchTower3")->GetForward()));
-    ang = glm::acos(dotP);
-
-    if ((glm::distance(camera_.GetPosition(), scene_.GetNode("WatchTower3")->GetPosition())) > 200.0f) scene_.GetNode("WatchEye3")->Rotate(glm::angleAxis(angle * 8.0f, glm::vec3(0.0, 1.0, 0.0)));
-    else scene_.GetNode("WatchEye3")->SetOrientation(glm::normalize(glm::angleAxis(ang, rotationAxis)));
-
-    direction = glm::normalize(camera_.GetPosition() - scene_.GetNode("WatchTower4")->GetPosition());
-    rotationAxis = glm::normalize(glm::cross(direction, scene_.GetNode("WatchEye4")->GetForward()));
-    dotP = glm::dot(direction, glm::normalize(scene_.GetNode("WatchTower4")->GetForward()));
-    ang = glm::acos(dotP);
-
-    if ((glm::distance(camera_.GetPosition(), scene_.GetNode("WatchTower4")->GetPosition())) > 200.0f) scene_.GetNode("WatchEye4")->Rotate(glm::angleAxis(angle * 8.0f, glm::vec3(0.0, 1.0, 0.0)));
-    else scene_.GetNode("WatchEye4")->SetOrientation(glm::normalize(glm::angleAxis(ang, rotationAxis)));
+    // Look up each tower and eye once. The names are short enough not to
+    // be allocated
+    static const char *tower_name[4] = { "WatchTower1", "WatchTower2", "WatchTower3", "WatchTower4" };
+    static const char *eye_name[4] = { "WatchEye1", "WatchEye2", "WatchEye3", "WatchEye4" };
+    for (int i = 0; i < 4; i++) {
+        SceneNode *tower = scene_.GetNode(tower_name[i]);
+        SceneNode *eye = scene_.GetNode(eye_name[i]);
+
+        glm::vec3 direction = glm::normalize(camera_.GetPosition() - tower->GetPosition());
+        glm::vec3 rotationAxis = glm::normalize(glm::cross(direction, eye->GetForward()));
+        float dotP = glm::dot(direction, glm::normalize(tower->GetForward()));
+        float ang = glm::acos(dotP);
+
+        if ((glm::distance(camera_.GetPosition(), tower->GetPosition())) > 200.0f) eye->Rotate(glm::angleAxis(angle * 8.0f, glm::vec3(0.0, 1.0, 0.0)));
+        else eye->SetOrientation(glm::normalize(glm::angleAxis(ang, rotationAxis)));
+    }
 }
 
 
@@ -1016,10 +1125,12 @@ void Game::createOasis() {
     flower_positions.push_back(glm::vec3(419.017, 0, 989.477));
 
     game::SceneNode* oasisPlant;
+    InstanceResources plant_res = GetInstanceResources("OasisPlantMesh", "TextureNormalMaterial", "OasisPlantTexture", "OasisPlantNormal");
     for (int j = 0; j < flower_positions.size(); ++j) {
-        oasisPlant = CreateInstance("OasisPlant", "OasisPlantMesh", "TextureNormalMaterial", "OasisPlantTexture", "OasisPlantNormal");
+        oasisPlant = CreateInstance("OasisPlant", plant_res);
         glm::vec3 FlowerPos = flower_positions[j];
         oasisPlant->SetScale(glm::vec3(18, 18, 18));
+        oasisPlant->SetInstanced(true);
         oasisPlant->Rotate(glm::angleAxis(3 * glm::pi<float>() / 4, glm::vec3(0, 1, 0)));
         PlaceObject(oasisPlant, FlowerPos.x, FlowerPos.y, FlowerPos.z);
     }   
@@ -1037,9 +1148,11 @@ void Game::createOasis() {
 // creates the area where the tornados are
 void Game::createSandNadoZone() {
 
-    game::SceneNode* sand = new SceneNode("sandNato", resman_.GetResource("SParticle1000"), resman_.GetResource("PS-SandTornatoMaterial"), resman_.GetResource("SandParticle"));
+    game::SceneNode* sand = NodePool::Create<SceneNode>("sandNato", resman_.GetResource("SParticle1000"), resman_.GetResource("PS-SandTornatoMaterial"), resman_.GetResource("SandParticle"));
     sand->SetPosition(glm::vec3(337, 30, 463));
     sand->SetScale(glm::vec3(50));
+    // The shader lifts and swirls the particles far past where they start
+    sand->SetBounds(glm::vec3(0.0), 6.0f);
     scene_.AddNode(sand, SceneGraph::EFFECTS);
 
 }
@@ -1048,24 +1161,31 @@ void Game::createSandNadoZone() {
 // creates the fire by the obelisk
 void Game::createfires() {
     // place the fire around the obilisk nados 
-    game::SceneNode* fire = new SceneNode("Fire1", resman_.GetResource("SParticle1000"), resman_.GetResource("PS-Fire"));
+    game::SceneNode* fire = NodePool::Create<SceneNode>("Fire1", resman_.GetResource("SParticle1000"), resman_.GetResource("PS-Fire"));
     fire->SetPosition(glm::vec3(-74, 0, 776));
     fire->SetScale(glm::vec3(5));
+    // Fire_vp.glsl scales the height of the particles by their world
+    // height, so they rise by hundreds of units. The bounds are left
+    // unknown, so that the fire is never culled
+    fire->SetBounds(glm::vec3(0.0), -1.0f);
     scene_.AddNode(fire, SceneGraph::EFFECTS);
 
-    fire = new SceneNode("Fire2", resman_.GetResource("SParticle1000"), resman_.GetResource("PS-Fire"));
+    fire = NodePool::Create<SceneNode>("Fire2", resman_.GetResource("SParticle1000"), resman_.GetResource("PS-Fire"));
     fire->SetPosition(glm::vec3(-74, 0, 830));
     fire->SetScale(glm::vec3(5));
+    fire->SetBounds(glm::vec3(0.0), -1.0f);
     scene_.AddNode(fire, SceneGraph::EFFECTS);
 
-    fire = new SceneNode("Fire3", resman_.GetResource("SParticle1000"), resman_.GetResource("PS-Fire"));
+    fire = NodePool::Create<SceneNode>("Fire3", resman_.GetResource("SParticle1000"), resman_.GetResource("PS-Fire"));
     fire->SetPosition(glm::vec3(-15, 0, 830));
     fire->SetScale(glm::vec3(5));
+    fire->SetBounds(glm::vec3(0.0), -1.0f);
     scene_.AddNode(fire, SceneGraph::EFFECTS);
 
-    fire = new SceneNode("Fire4", resman_.GetResource("SParticle1000"), resman_.GetResource("PS-Fire"));
+    fire = NodePool::Create<SceneNode>("Fire4", resman_.GetResource("SParticle1000"), resman_.GetResource("PS-Fire"));
     fire->SetPosition(glm::vec3(-15, 0, 776));
     fire->SetScale(glm::vec3(5));
+    fire->SetBounds(glm::vec3(0.0), -1.0f);
     scene_.AddNode(fire, SceneGraph::EFFECTS);
 }    
 
@@ -1105,6 +1225,9 @@ void Game::generateTerrainFeatures(float x, float z) {
     int gridSide = 10;
     std::vector<std::vector<bool>> grid(gridSide, std::vector<bool>(gridSide, false));
 
+    InstanceResources bush_res = GetInstanceResources("DryShrubMesh", "TextureNormalMaterial", "DryShrubMeshTexture", "DryShrubMeshNormal");
+    InstanceResources tumbleweed_res = GetInstanceResources("TumbleweedMesh", "TextureNormalMaterial", "TumbleweedTexture", "TumbleweedNormal");
+
     for (int i = featureDensity; i > 0; --i) {
         int col = rand() % gridSide;
         int row = rand() % gridSide;
@@ -1114,13 +1237,15 @@ void Game::generateTerrainFeatures(float x, float z) {
         if (!grid[row][col]) {
             int choice = rand() % 2;
             if (choice) {
-                bush = CreateInstance(row + col + "DryShrub" + i, "DryShrubMesh", "TextureNormalMaterial", "DryShrubMeshTexture", "DryShrubMeshNormal");
+                bush = CreateInstance(row + col + "DryShrub" + i, bush_res);
                 bush->SetScale(glm::vec3(8, 8, 8));
+                bush->SetInstanced(true);
                 PlaceObject(bush, x - distBPoints * row, -0.5, z + distBPoints * col);
             }
             else {
-                newTumbleweed = CreateInstance(col + row + "Tumbleweed" + i, "TumbleweedMesh", "TextureNormalMaterial", "TumbleweedTexture", "TumbleweedNormal");
+                newTumbleweed = CreateInstance(col + row + "Tumbleweed" + i, tumbleweed_res);
                 newTumbleweed->SetScale(glm::vec3(18, 18, 18));
+                newTumbleweed->SetInstanced(true);
                 PlaceObject(newTumbleweed, x - distBPoints * row, 2, z + distBPoints * col);
             }           
 
@@ -1154,13 +1279,28 @@ void Game::LoadScreen()
     filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/loading.png");
     resman_.LoadResource(Texture, "Loading", filename.c_str());
 
-    Ui* a = new Ui("LoadingScreen", resman_.GetResource("SWall"), resman_.GetResource("PlainTexMaterial"), resman_.GetResource("Loading"));
-    a->Draw(&camera_);
+    loading_screen_ = NodePool::Create<Ui>("LoadingScreen", resman_.GetResource("SWall"), resman_.GetResource("PlainTexMaterial"), resman_.GetResource("Loading"));
+    loading_screen_->Draw(&camera_);
 
     // Push buffer drawn in the background onto the display
     glfwSwapBuffers(window_);
 }
 
+// Redraws the loading screen while resources load
+void Game::DrawLoadScreen(float progress)
+{
+    glfwPollEvents();
+
+    glClearColor(viewport_background_color_g[0], viewport_background_color_g[1], viewport_background_color_g[2], 0.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    loading_screen_->SetProgress(progress);
+    loading_screen_->Draw(&camera_);
+
+    glfwSwapBuffers(window_);
+    DrawRing::EndFrame();
+}
+
 // This is the start screen function, which loads the screen
 void Game::StartScreen()
 {
@@ -1170,8 +1310,9 @@ void Game::StartScreen()
     std::string filename = std::string(MATERIAL_DIRECTORY) + std::string("/textures/start.png");
     resman_.LoadResource(Texture, "StartScreen", filename.c_str());
 
-    Ui* a = new Ui("StartScreen", resman_.GetResource("SimpleWall"), resman_.GetResource("PlainTexMaterial"), resman_.GetResource("StartScreen"));
+    Ui* a = NodePool::Create<Ui>("StartScreen", resman_.GetResource("SimpleWall"), resman_.GetResource("PlainTexMaterial"), resman_.GetResource("StartScreen"));
     a->Draw(&camera_);
+    NodePool::Destroy(a);
     
     // Push buffer drawn in the background onto the display
     glfwSwapBuffers(window_);
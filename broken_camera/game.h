@@ -18,6 +18,7 @@
 #include "tree.h"
 #include "light.h"
 #include "Ui.h"
+#include "asset_loader.h"
 
 namespace game {
 
@@ -32,10 +33,19 @@ namespace game {
             virtual ~GameException() throw() {};
     };
 
+    // Resources of a scene node, resolved from their names once so that
+    // many instances can share them
+    struct InstanceResources {
+        MeshHandle geometry;
+        MaterialHandle material;
+        TextureHandle texture;
+        TextureHandle normal_map;
+    };
+
     // Game application
     class Game {
 
-        enum game_state_t { won, lost, inProgress , init, dead};
+        enum game_state_t { won, lost, inProgress , init, dead, loading};
 
         public:
             // Constructor and destructor
@@ -70,6 +80,7 @@ namespace game {
 
             //hud
             Ui* gui_;
+            Ui* loading_screen_;
 
             //Tree
             //game::SceneNode* treeTrunk;
@@ -93,6 +104,8 @@ namespace game {
             void createTerrain(const char* file_name, glm::vec3);
             Orb* createOrbInstance(std::string entity_name, std::string object_name, std::string material_name, std::string texture_name);
             SceneNode* CreateInstance(std::string entity_name, std::string object_name, std::string material_name, std::string texture_name = std::string(""), std::string normal_name = std::string(""));
+            SceneNode* CreateInstance(std::string entity_name, const InstanceResources &resources);
+            InstanceResources GetInstanceResources(std::string object_name, std::string material_name, std::string texture_name = std::string(""), std::string normal_name = std::string(""));
             Light* CreateLightInstance(std::string entity_name, std::string object_name, std::string material_name, std::string texture_name);
             
             // handle Player-Scene node collisions
@@ -120,6 +133,7 @@ namespace game {
 
             //create diferent screens
             void LoadScreen();
+            void DrawLoadScreen(float progress);
             void StartScreen();
 
     }; // class Game
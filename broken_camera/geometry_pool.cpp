@@ -0,0 +1,209 @@
+#include <iostream>
+
+#include "geometry_pool.h"
+#include "gl_state.h"
+
+namespace game {
+
+    FreeList::FreeList(GLuint size) {
+
+        size_ = size;
+        num_free_ = size;
+        if (size > 0) {
+            free_[0] = size;
+        }
+    }
+
+
+    bool FreeList::Allocate(GLuint count, GLuint &start) {
+
+        for (std::map<GLuint, GLuint>::iterator it = free_.begin(); it != free_.end(); ++it) {
+            if (it->second < count) {
+                continue;
+            }
+            start = it->first;
+            GLuint rest = it->second - count;
+            free_.erase(it);
+            if (rest > 0) {
+                free_[start + count] = rest;
+            }
+            num_free_ -= count;
+            return true;
+        }
+        return false;
+    }
+
+
+    void FreeList::Free(GLuint start, GLuint count) {
+
+        if (count == 0) {
+            return;
+        }
+        num_free_ += count;
+
+        // Merge with the free range that follows, then the one before
+        std::map<GLuint, GLuint>::iterator next = free_.find(start + count);
+        if (next != free_.end()) {
+            count += next->second;
+            free_.erase(next);
+        }
+        std::map<GLuint, GLuint>::iterator it = free_.lower_bound(start);
+        if (it != free_.begin()) {
+            --it;
+            if (it->first + it->second == start) {
+                it->second += count;
+                return;
+            }
+        }
+        free_[start] = count;
+    }
+
+
+    GLuint FreeList::GetSize(void) const {
+
+        return size_;
+    }
+
+
+    GLuint FreeList::GetFree(void) const {
+
+        return num_free_;
+    }
+
+
+    GLuint FreeList::GetLargestFree(void) const {
+
+        GLuint largest = 0;
+        for (std::map<GLuint, GLuint>::const_iterator it = free_.begin(); it != free_.end(); ++it) {
+            if (it->second > largest) {
+                largest = it->second;
+            }
+        }
+        return largest;
+    }
+
+
+    size_t FreeList::GetNumFreeRanges(void) const {
+
+        return free_.size();
+    }
+
+
+    // Size of one index of a layout
+    static size_t index_bytes(const VertexLayout &layout) {
+
+        return (layout.index_type == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+    }
+
+
+    static bool same_attrib(const VertexAttrib &a, const VertexAttrib &b) {
+
+        return (a.size == b.size) && (a.type == b.type) && (a.normalized == b.normalized) && (a.offset == b.offset);
+    }
+
+
+    GeometryPool::GeometryPool(const VertexLayout &layout)
+        : vertices_((GLuint) (geometry_pool_vertex_bytes / layout.stride)), indices_(geometry_pool_indices) {
+
+        layout_ = layout;
+
+        // The buffers are filled piece by piece as meshes are added
+        glGenBuffers(1, &array_buffer_);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, array_buffer_);
+        glBufferData(GL_ARRAY_BUFFER, (size_t) vertices_.GetSize() * layout.stride, NULL, GL_STATIC_DRAW);
+
+        glGenBuffers(1, &element_array_buffer_);
+        GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_array_buffer_);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.GetSize() * index_bytes(layout), NULL, GL_STATIC_DRAW);
+    }
+
+
+    GeometryPool::~GeometryPool() {
+
+        GLState::ForgetBuffer(array_buffer_);
+        GLState::ForgetBuffer(element_array_buffer_);
+        glDeleteBuffers(1, &array_buffer_);
+        glDeleteBuffers(1, &element_array_buffer_);
+    }
+
+
+    bool GeometryPool::Matches(const VertexLayout &layout) const {
+
+        // Positions are mapped to model space per mesh, so only the storage
+        // of the attributes has to be the same
+        return (layout.stride == layout_.stride) && (layout.index_type == layout_.index_type) &&
+            same_attrib(layout.position, layout_.position) && same_attrib(layout.normal, layout_.normal) &&
+            same_attrib(layout.color, layout_.color) && same_attrib(layout.uv, layout_.uv);
+    }
+
+
+    bool GeometryPool::Allocate(const void *vertex, GLuint num_vertices, const void *index, GLuint num_indices, GeometryRange &range) {
+
+        GLuint first_vertex, first_index;
+        if (!vertices_.Allocate(num_vertices, first_vertex)) {
+            return false;
+        }
+        if (!indices_.Allocate(num_indices, first_index)) {
+            vertices_.Free(first_vertex, num_vertices);
+            return false;
+        }
+
+        // Indices stay relative to the mesh; draws add the base vertex
+        GLState::BindBuffer(GL_ARRAY_BUFFER, array_buffer_);
+        glBufferSubData(GL_ARRAY_BUFFER, (size_t) first_vertex * layout_.stride, (size_t) num_vertices * layout_.stride, vertex);
+        GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_array_buffer_);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, first_index * index_bytes(layout_), num_indices * index_bytes(layout_), index);
+
+        range.base_vertex = (GLint) first_vertex;
+        range.num_vertices = num_vertices;
+        range.first_index = first_index;
+        range.num_indices = num_indices;
+        return true;
+    }
+
+
+    void GeometryPool::Free(const GeometryRange &range) {
+
+        vertices_.Free((GLuint) range.base_vertex, range.num_vertices);
+        indices_.Free(range.first_index, range.num_indices);
+    }
+
+
+    GLuint GeometryPool::GetArrayBuffer(void) const {
+
+        return array_buffer_;
+    }
+
+
+    GLuint GeometryPool::GetElementArrayBuffer(void) const {
+
+        return element_array_buffer_;
+    }
+
+
+    bool GeometryPool::Fits(const VertexLayout &layout, GLuint num_vertices, GLuint num_indices) {
+
+        return ((size_t) num_vertices * layout.stride <= geometry_pool_vertex_bytes) && (num_indices <= geometry_pool_indices);
+    }
+
+
+    void GeometryPool::PrintStats(void) const {
+
+        // Fragmentation is the share of free space that is not in the
+        // largest free range, and so cannot hold the largest mesh that the
+        // free space would
+        const FreeList *list[2] = { &vertices_, &indices_ };
+        const char *list_name[2] = { "vertices", "indices" };
+        std::cout << "Geometry pool, " << layout_.stride << "-byte vertices:";
+        for (int i = 0; i < 2; i++) {
+            GLuint free = list[i]->GetFree();
+            GLuint largest = list[i]->GetLargestFree();
+            float fragmentation = (free > 0) ? 100.0f * (1.0f - (float) largest / free) : 0.0f;
+            std::cout << " " << list_name[i] << " " << list[i]->GetSize() - free << "/" << list[i]->GetSize() <<
+                " used, " << list[i]->GetNumFreeRanges() << " free ranges, largest " << largest <<
+                ", " << fragmentation << "% fragmented" << ((i == 0) ? ";" : "");
+        }
+        std::cout << std::endl;
+    }
+
+} // namespace game
@@ -0,0 +1,77 @@
+#ifndef GEOMETRY_POOL_H_
+#define GEOMETRY_POOL_H_
+
+#include <map>
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "resource.h"
+
+namespace game {
+
+    // Vertex and index buffer space of one pool
+    const size_t geometry_pool_vertex_bytes = 32*1024*1024;
+    const GLuint geometry_pool_indices = 4*1024*1024;
+
+    // First-fit allocator of ranges of elements. Free ranges are kept by
+    // start, so a freed range is merged with the free ranges next to it
+    class FreeList {
+
+        public:
+            FreeList(GLuint size);
+
+            // Take count elements; false if no free range is large enough
+            bool Allocate(GLuint count, GLuint &start);
+            // Give back a range taken by Allocate
+            void Free(GLuint start, GLuint count);
+
+            GLuint GetSize(void) const;
+            GLuint GetFree(void) const;
+            // Largest range that can be allocated
+            GLuint GetLargestFree(void) const;
+            // Number of separate free ranges
+            size_t GetNumFreeRanges(void) const;
+
+        private:
+            std::map<GLuint, GLuint> free_; // Start and length of free ranges
+            GLuint size_;
+            GLuint num_free_;
+
+    }; // class FreeList
+
+    // One vertex buffer and one index buffer shared by the static meshes of
+    // a vertex layout. Meshes are drawn at their base vertex and first
+    // index, so the buffers and vertex arrays stay bound between them
+    class GeometryPool {
+
+        public:
+            GeometryPool(const VertexLayout &layout);
+            ~GeometryPool();
+
+            // Whether meshes of a layout can be stored in the pool
+            bool Matches(const VertexLayout &layout) const;
+            // Copy a mesh to free space of the buffers; false if it does not
+            // fit
+            bool Allocate(const void *vertex, GLuint num_vertices, const void *index, GLuint num_indices, GeometryRange &range);
+            // Make the space of a mesh free again
+            void Free(const GeometryRange &range);
+
+            GLuint GetArrayBuffer(void) const;
+            GLuint GetElementArrayBuffer(void) const;
+            // Whether a mesh is small enough for an empty pool
+            static bool Fits(const VertexLayout &layout, GLuint num_vertices, GLuint num_indices);
+            // Print the use and fragmentation of the buffers
+            void PrintStats(void) const;
+
+        private:
+            VertexLayout layout_;
+            GLuint array_buffer_;
+            GLuint element_array_buffer_;
+            FreeList vertices_;
+            FreeList indices_;
+
+    }; // class GeometryPool
+
+} // namespace game
+
+#endif // GEOMETRY_POOL_H_
@@ -0,0 +1,323 @@
+#include "gl_state.h"
+#include "render_stats.h"
+
+namespace game {
+
+    GLuint GLState::program_ = GLState::unknown_;
+    GLuint GLState::vertex_array_ = GLState::unknown_;
+    GLuint GLState::buffer_[GLState::num_buffer_targets_] = { GLState::unknown_, GLState::unknown_, GLState::unknown_, GLState::unknown_ };
+    GLuint GLState::framebuffer_ = GLState::unknown_;
+    GLuint GLState::active_texture_ = GLState::unknown_;
+    GLuint GLState::texture_[GLState::num_texture_units_][GLState::num_texture_targets_] = {
+        { GLState::unknown_, GLState::unknown_ }, { GLState::unknown_, GLState::unknown_ },
+        { GLState::unknown_, GLState::unknown_ }, { GLState::unknown_, GLState::unknown_ },
+        { GLState::unknown_, GLState::unknown_ }, { GLState::unknown_, GLState::unknown_ },
+        { GLState::unknown_, GLState::unknown_ }, { GLState::unknown_, GLState::unknown_ } };
+    GLuint GLState::sampler_[GLState::num_texture_units_] = { GLState::unknown_, GLState::unknown_, GLState::unknown_, GLState::unknown_,
+        GLState::unknown_, GLState::unknown_, GLState::unknown_, GLState::unknown_ };
+    GLint GLState::enabled_[GLState::num_capabilities_] = { -1, -1, -1 };
+    GLint GLState::depth_mask_ = -1;
+    GLenum GLState::depth_func_ = GLState::unknown_;
+    GLenum GLState::blend_func_[4] = { GLState::unknown_, GLState::unknown_, GLState::unknown_, GLState::unknown_ };
+    GLenum GLState::blend_equation_[2] = { GLState::unknown_, GLState::unknown_ };
+
+
+    int GLState::BufferIndex(GLenum target) {
+
+        switch (target) {
+            case GL_ARRAY_BUFFER: return 0;
+            case GL_ELEMENT_ARRAY_BUFFER: return 1;
+            case GL_UNIFORM_BUFFER: return 2;
+            case GL_DRAW_INDIRECT_BUFFER: return 3;
+            default: return -1;
+        }
+    }
+
+
+    int GLState::TextureIndex(GLenum target) {
+
+        switch (target) {
+            case GL_TEXTURE_2D: return 0;
+            case GL_TEXTURE_2D_ARRAY: return 1;
+            default: return -1;
+        }
+    }
+
+
+    int GLState::CapabilityIndex(GLenum capability) {
+
+        switch (capability) {
+            case GL_CULL_FACE: return 0;
+            case GL_BLEND: return 1;
+            case GL_DEPTH_TEST: return 2;
+            default: return -1;
+        }
+    }
+
+
+    bool GLState::Changes(bool different) {
+
+        if (!different) {
+            RenderStats::AddElidedCall();
+        }
+        return different;
+    }
+
+
+    void GLState::UseProgram(GLuint program) {
+
+        if (Changes(program_ != program)) {
+            GL_COUNT(glUseProgram(program));
+            RenderStats::AddProgramBind();
+            program_ = program;
+        }
+    }
+
+
+    void GLState::BindVertexArray(GLuint vertex_array) {
+
+        if (Changes(vertex_array_ != vertex_array)) {
+            GL_COUNT(glBindVertexArray(vertex_array));
+            RenderStats::AddVertexArrayBind();
+            vertex_array_ = vertex_array;
+
+            // The element array buffer is part of the vertex array
+            buffer_[BufferIndex(GL_ELEMENT_ARRAY_BUFFER)] = unknown_;
+        }
+    }
+
+
+    void GLState::BindBuffer(GLenum target, GLuint buffer) {
+
+        int index = BufferIndex(target);
+        if (index < 0) {
+            GL_COUNT(glBindBuffer(target, buffer));
+        }
+        else if (Changes(buffer_[index] != buffer)) {
+            GL_COUNT(glBindBuffer(target, buffer));
+            buffer_[index] = buffer;
+        }
+    }
+
+
+    void GLState::BindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+
+        GL_COUNT(glBindBufferBase(target, index, buffer));
+        int target_index = BufferIndex(target);
+        if (target_index >= 0) {
+            buffer_[target_index] = buffer;
+        }
+    }
+
+
+    void GLState::BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+
+        GL_COUNT(glBindBufferRange(target, index, buffer, offset, size));
+        int target_index = BufferIndex(target);
+        if (target_index >= 0) {
+            buffer_[target_index] = buffer;
+        }
+    }
+
+
+    void GLState::BindFramebuffer(GLuint framebuffer) {
+
+        if (Changes(framebuffer_ != framebuffer)) {
+            GL_COUNT(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+            framebuffer_ = framebuffer;
+        }
+    }
+
+
+    void GLState::BindTexture(GLuint unit, GLenum target, GLuint texture) {
+
+        // Each target of a unit has its own binding. Units and targets
+        // past the tracked ones are always bound
+        int index = TextureIndex(target);
+        bool tracked = (unit < num_texture_units_) && (index >= 0);
+        if (tracked && !Changes(texture_[unit][index] != texture)) {
+            return;
+        }
+        if (active_texture_ != unit) {
+            GL_COUNT(glActiveTexture(GL_TEXTURE0 + unit));
+            active_texture_ = unit;
+        }
+        GL_COUNT(glBindTexture(target, texture));
+        RenderStats::AddTextureBind();
+        if (tracked) {
+            texture_[unit][index] = texture;
+        }
+    }
+
+
+    void GLState::BindSampler(GLuint unit, GLuint sampler) {
+
+        if (!(GLEW_VERSION_3_3 || GLEW_ARB_sampler_objects)) {
+            return;
+        }
+        if ((unit < num_texture_units_) && !Changes(sampler_[unit] != sampler)) {
+            return;
+        }
+        GL_COUNT(glBindSampler(unit, sampler));
+        if (unit < num_texture_units_) {
+            sampler_[unit] = sampler;
+        }
+    }
+
+
+    void GLState::Enable(GLenum capability) {
+
+        SetEnabled(capability, true);
+    }
+
+
+    void GLState::Disable(GLenum capability) {
+
+        SetEnabled(capability, false);
+    }
+
+
+    void GLState::SetEnabled(GLenum capability, bool enabled) {
+
+        int index = CapabilityIndex(capability);
+        if ((index >= 0) && !Changes(enabled_[index] != (enabled ? 1 : 0))) {
+            return;
+        }
+        if (enabled) {
+            GL_COUNT(glEnable(capability));
+        }
+        else {
+            GL_COUNT(glDisable(capability));
+        }
+        if (index >= 0) {
+            enabled_[index] = enabled ? 1 : 0;
+        }
+    }
+
+
+    void GLState::DepthMask(GLboolean mask) {
+
+        if (Changes(depth_mask_ != mask)) {
+            GL_COUNT(glDepthMask(mask));
+            depth_mask_ = mask;
+        }
+    }
+
+
+    void GLState::DepthFunc(GLenum func) {
+
+        if (Changes(depth_func_ != func)) {
+            GL_COUNT(glDepthFunc(func));
+            depth_func_ = func;
+        }
+    }
+
+
+    void GLState::BlendFuncSeparate(GLenum src_rgb, GLenum dst_rgb, GLenum src_alpha, GLenum dst_alpha) {
+
+        bool different = (blend_func_[0] != src_rgb) || (blend_func_[1] != dst_rgb) ||
+            (blend_func_[2] != src_alpha) || (blend_func_[3] != dst_alpha);
+        if (Changes(different)) {
+            GL_COUNT(glBlendFuncSeparate(src_rgb, dst_rgb, src_alpha, dst_alpha));
+            blend_func_[0] = src_rgb;
+            blend_func_[1] = dst_rgb;
+            blend_func_[2] = src_alpha;
+            blend_func_[3] = dst_alpha;
+        }
+    }
+
+
+    void GLState::BlendEquationSeparate(GLenum mode_rgb, GLenum mode_alpha) {
+
+        if (Changes((blend_equation_[0] != mode_rgb) || (blend_equation_[1] != mode_alpha))) {
+            GL_COUNT(glBlendEquationSeparate(mode_rgb, mode_alpha));
+            blend_equation_[0] = mode_rgb;
+            blend_equation_[1] = mode_alpha;
+        }
+    }
+
+
+    void GLState::ForgetProgram(GLuint program) {
+
+        // A program in use is only really deleted once it is no longer
+        // used, but its name can already be given to a new one
+        if (program_ == program) {
+            program_ = unknown_;
+        }
+    }
+
+
+    void GLState::ForgetVertexArray(GLuint vertex_array) {
+
+        if (vertex_array_ == vertex_array) {
+            vertex_array_ = 0;
+            buffer_[BufferIndex(GL_ELEMENT_ARRAY_BUFFER)] = unknown_;
+        }
+    }
+
+
+    void GLState::ForgetBuffer(GLuint buffer) {
+
+        for (int i = 0; i < num_buffer_targets_; i++) {
+            if (buffer_[i] == buffer) {
+                buffer_[i] = 0;
+            }
+        }
+    }
+
+
+    void GLState::ForgetFramebuffer(GLuint framebuffer) {
+
+        if (framebuffer_ == framebuffer) {
+            framebuffer_ = 0;
+        }
+    }
+
+
+    void GLState::ForgetTexture(GLuint texture) {
+
+        for (int i = 0; i < num_texture_units_; i++) {
+            for (int j = 0; j < num_texture_targets_; j++) {
+                if (texture_[i][j] == texture) {
+                    texture_[i][j] = 0;
+                }
+            }
+        }
+    }
+
+
+    void GLState::ForgetSampler(GLuint sampler) {
+
+        for (int i = 0; i < num_texture_units_; i++) {
+            if (sampler_[i] == sampler) {
+                sampler_[i] = 0;
+            }
+        }
+    }
+
+
+    void GLState::Reset(void) {
+
+        program_ = unknown_;
+        vertex_array_ = unknown_;
+        for (int i = 0; i < num_buffer_targets_; i++) {
+            buffer_[i] = unknown_;
+        }
+        framebuffer_ = unknown_;
+        active_texture_ = unknown_;
+        for (int i = 0; i < num_texture_units_; i++) {
+            texture_[i][0] = texture_[i][1] = unknown_;
+            sampler_[i] = unknown_;
+        }
+        for (int i = 0; i < num_capabilities_; i++) {
+            enabled_[i] = -1;
+        }
+        depth_mask_ = -1;
+        depth_func_ = unknown_;
+        for (int i = 0; i < 4; i++) {
+            blend_func_[i] = unknown_;
+        }
+        blend_equation_[0] = blend_equation_[1] = unknown_;
+    }
+
+} // namespace game
@@ -0,0 +1,86 @@
+#ifndef GL_STATE_H_
+#define GL_STATE_H_
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+namespace game {
+
+    // Shadow of the OpenGL state that the game changes: bound program,
+    // vertex array, buffers, framebuffer, 2D and array textures and
+    // samplers per unit, face culling, blending and depth. A call that
+    // would set what is already set is skipped and counted as elided. All
+    // changes of this state must go through here, or the shadow no longer
+    // matches the context. State starts unknown, so the first call of each
+    // kind is always made. Only used from the thread that owns the OpenGL
+    // context
+    class GLState {
+
+        public:
+            static void UseProgram(GLuint program);
+            // Binding a vertex array also selects its element array buffer
+            static void BindVertexArray(GLuint vertex_array);
+            static void BindBuffer(GLenum target, GLuint buffer);
+            // Indexed bindings are always made, as the range usually moves;
+            // they also set the generic binding of the target
+            static void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+            static void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+            static void BindFramebuffer(GLuint framebuffer);
+            // Bind a texture to a texture unit, numbered from 0
+            static void BindTexture(GLuint unit, GLenum target, GLuint texture);
+            // Bind a sampler to a texture unit; 0 uses the parameters of
+            // the texture. Does nothing without sampler objects
+            static void BindSampler(GLuint unit, GLuint sampler);
+            // Face culling, blending and depth test
+            static void Enable(GLenum capability);
+            static void Disable(GLenum capability);
+            static void SetEnabled(GLenum capability, bool enabled);
+            static void DepthMask(GLboolean mask);
+            static void DepthFunc(GLenum func);
+            static void BlendFuncSeparate(GLenum src_rgb, GLenum dst_rgb, GLenum src_alpha, GLenum dst_alpha);
+            static void BlendEquationSeparate(GLenum mode_rgb, GLenum mode_alpha);
+            // Deleting a bound object binds 0 in its place. Call before the
+            // object is deleted, as its name can be reused
+            static void ForgetProgram(GLuint program);
+            static void ForgetVertexArray(GLuint vertex_array);
+            static void ForgetBuffer(GLuint buffer);
+            static void ForgetFramebuffer(GLuint framebuffer);
+            static void ForgetTexture(GLuint texture);
+            static void ForgetSampler(GLuint sampler);
+            // Mark all the state unknown, after code that changes it
+            // directly
+            static void Reset(void);
+
+        private:
+            // Index of a tracked buffer or texture target or capability,
+            // or -1
+            static int BufferIndex(GLenum target);
+            static int TextureIndex(GLenum target);
+            static int CapabilityIndex(GLenum capability);
+            // Count a call, made or not
+            static bool Changes(bool different);
+
+            static const GLuint unknown_ = ~0u; // Binding not known
+            static const int num_buffer_targets_ = 4;
+            static const int num_capabilities_ = 3;
+            static const int num_texture_units_ = 8;
+            static const int num_texture_targets_ = 2;
+
+            static GLuint program_;
+            static GLuint vertex_array_;
+            static GLuint buffer_[num_buffer_targets_];
+            static GLuint framebuffer_;
+            static GLuint active_texture_; // Selected unit
+            static GLuint texture_[num_texture_units_][num_texture_targets_];
+            static GLuint sampler_[num_texture_units_];
+            static GLint enabled_[num_capabilities_]; // 0, 1 or -1 if unknown
+            static GLint depth_mask_;
+            static GLenum depth_func_;
+            static GLenum blend_func_[4];
+            static GLenum blend_equation_[2];
+
+    }; // class GLState
+
+} // namespace game
+
+#endif // GL_STATE_H_
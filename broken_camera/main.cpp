@@ -9,14 +9,29 @@
 
 #include <iostream>
 #include <exception>
+#include <cstring>
 #include "game.h"
+#include "scene_benchmark.h"
 
 // Macro for printing exceptions
 #define PrintException(exception_object)\
 	std::cerr << exception_object.what() << std::endl
 
+// Number of scene nodes built by --benchmark
+#define BENCHMARK_NUM_INSTANCES 10000
+// Number of transforms computed by --benchmark
+#define BENCHMARK_NUM_TRANSFORMS 100000
+
 // Main function that builds and runs the game
-int main(void){
+int main(int argc, char *argv[]){
+
+    // Time world construction and transforms instead of running the game
+    if ((argc > 1) && (strcmp(argv[1], "--benchmark") == 0)){
+        game::benchmark_world_construction(BENCHMARK_NUM_INSTANCES);
+        game::benchmark_transforms(BENCHMARK_NUM_TRANSFORMS);
+        return 0;
+    }
+
     game::Game app; // Game application 
 
     try {
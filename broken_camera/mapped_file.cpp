@@ -0,0 +1,140 @@
+#include <string>
+#include <ios>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "mapped_file.h"
+
+namespace game {
+
+    MappedFile::MappedFile(void) {
+
+        data_ = NULL;
+        size_ = 0;
+#ifdef _WIN32
+        file_ = INVALID_HANDLE_VALUE;
+        mapping_ = NULL;
+#else
+        fd_ = -1;
+#endif
+    }
+
+
+    MappedFile::~MappedFile() {
+
+        Close();
+    }
+
+
+    void MappedFile::Open(const char *filename) {
+
+        Close();
+
+#ifdef _WIN32
+        file_ = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file_ == INVALID_HANDLE_VALUE) {
+            throw(std::ios_base::failure(std::string("Error opening file ") + std::string(filename)));
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_, &size)) {
+            Close();
+            throw(std::ios_base::failure(std::string("Error reading size of file ") + std::string(filename)));
+        }
+        size_ = (size_t) size.QuadPart;
+
+        // Empty files cannot be mapped, but are valid
+        if (size_ == 0) {
+            return;
+        }
+
+        mapping_ = CreateFileMappingA(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping_ == NULL) {
+            Close();
+            throw(std::ios_base::failure(std::string("Error mapping file ") + std::string(filename)));
+        }
+
+        data_ = (const char *) MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+        if (data_ == NULL) {
+            Close();
+            throw(std::ios_base::failure(std::string("Error mapping file ") + std::string(filename)));
+        }
+#else
+        fd_ = open(filename, O_RDONLY);
+        if (fd_ < 0) {
+            throw(std::ios_base::failure(std::string("Error opening file ") + std::string(filename)));
+        }
+
+        struct stat st;
+        if (fstat(fd_, &st) != 0) {
+            Close();
+            throw(std::ios_base::failure(std::string("Error reading size of file ") + std::string(filename)));
+        }
+        size_ = (size_t) st.st_size;
+
+        // Empty files cannot be mapped, but are valid
+        if (size_ == 0) {
+            return;
+        }
+
+        void *data = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (data == MAP_FAILED) {
+            Close();
+            throw(std::ios_base::failure(std::string("Error mapping file ") + std::string(filename)));
+        }
+        data_ = (const char *) data;
+
+        // The whole file is read front to back
+        madvise(data, size_, MADV_SEQUENTIAL);
+#endif
+    }
+
+
+    void MappedFile::Close(void) {
+
+#ifdef _WIN32
+        if (data_) {
+            UnmapViewOfFile(data_);
+        }
+        if (mapping_) {
+            CloseHandle(mapping_);
+        }
+        if (file_ != INVALID_HANDLE_VALUE) {
+            CloseHandle(file_);
+        }
+        mapping_ = NULL;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (data_) {
+            munmap((void *) data_, size_);
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+        fd_ = -1;
+#endif
+        data_ = NULL;
+        size_ = 0;
+    }
+
+
+    const char *MappedFile::GetData(void) const {
+
+        return data_;
+    }
+
+
+    size_t MappedFile::GetSize(void) const {
+
+        return size_;
+    }
+
+} // namespace game
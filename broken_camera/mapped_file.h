@@ -0,0 +1,43 @@
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+
+namespace game {
+
+    // Read-only view of a whole file mapped into memory
+    class MappedFile {
+
+        public:
+            MappedFile(void);
+            ~MappedFile();
+
+            // Map the file into memory, replacing any previous mapping
+            // Throws std::ios_base::failure if the file cannot be mapped
+            void Open(const char *filename);
+            // Release the mapping
+            void Close(void);
+
+            // Contents of the file; not null-terminated
+            const char *GetData(void) const;
+            size_t GetSize(void) const;
+
+        private:
+            const char *data_;
+            size_t size_;
+#ifdef _WIN32
+            void *file_; // HANDLE of the file
+            void *mapping_; // HANDLE of the file mapping
+#else
+            int fd_;
+#endif
+
+            // A mapping has a single owner
+            MappedFile(const MappedFile &);
+            MappedFile &operator=(const MappedFile &);
+
+    }; // class MappedFile
+
+} // namespace game
+
+#endif // MAPPED_FILE_H_
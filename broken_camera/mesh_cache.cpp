@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "mesh_cache.h"
+
+namespace game {
+
+    namespace {
+
+        const char mesh_cache_magic[4] = { 'M', 'S', 'H', 'C' };
+        const uint32_t mesh_cache_version = 4;
+
+
+        // Get the size and modification time that a cache is checked against
+        bool stat_source(const char *filename, uint64_t &size, int64_t &mtime) {
+
+            struct stat st;
+            if (stat(filename, &st) != 0) {
+                return false;
+            }
+            size = (uint64_t) st.st_size;
+            mtime = (int64_t) st.st_mtime;
+            return true;
+        }
+
+    } // namespace
+
+
+    MeshCache::MeshCache(void) {
+
+        header_ = NULL;
+    }
+
+
+    bool MeshCache::Open(const char *source_filename, VertexFormat format) {
+
+        Close();
+
+        uint64_t source_size;
+        int64_t source_mtime;
+        if (!stat_source(source_filename, source_size, source_mtime)) {
+            return false;
+        }
+
+        // A missing cache is not an error
+        std::string filename = GetCacheFilename(source_filename);
+        struct stat st;
+        if (stat(filename.c_str(), &st) != 0) {
+            return false;
+        }
+        try {
+            file_.Open(filename.c_str());
+        }
+        catch (std::ios_base::failure &) {
+            return false;
+        }
+
+        // Check that the cache was written by this version from the same
+        // OBJ file, and that it is complete
+        if (file_.GetSize() < sizeof(MeshCacheHeader)) {
+            Close();
+            return false;
+        }
+        const MeshCacheHeader *header = (const MeshCacheHeader *) file_.GetData();
+        if ((memcmp(header->magic, mesh_cache_magic, sizeof(mesh_cache_magic)) != 0) ||
+            (header->version != mesh_cache_version) ||
+            (header->source_size != source_size) ||
+            (header->source_mtime != source_mtime) ||
+            (header->vertex_format != (uint32_t) format) ||
+            (header->num_lods > (uint32_t) mesh_max_lods)) {
+            Close();
+            return false;
+        }
+        uint64_t expected_size = sizeof(MeshCacheHeader) + (uint64_t) header->vertex_bytes + (uint64_t) header->index_bytes;
+        if (file_.GetSize() != expected_size) {
+            Close();
+            return false;
+        }
+
+        header_ = header;
+        return true;
+    }
+
+
+    void MeshCache::Close(void) {
+
+        header_ = NULL;
+        file_.Close();
+    }
+
+
+    bool MeshCache::Write(const char *source_filename, VertexFormat format, const PackedMesh &mesh) {
+
+        MeshCacheHeader header = {};
+        memcpy(header.magic, mesh_cache_magic, sizeof(mesh_cache_magic));
+        header.version = mesh_cache_version;
+        if (!stat_source(source_filename, header.source_size, header.source_mtime)) {
+            return false;
+        }
+        header.vertex_format = format;
+        header.num_vertices = (uint32_t) mesh.num_vertices;
+        header.num_indices = (uint32_t) mesh.num_indices;
+        header.vertex_bytes = (uint32_t) mesh.vertex.size();
+        header.index_bytes = (uint32_t) mesh.index.size();
+        for (int k = 0; k < 3; k++) {
+            header.bounds_min[k] = mesh.bounds_min[k];
+            header.bounds_max[k] = mesh.bounds_max[k];
+        }
+        header.layout = mesh.layout;
+        header.num_lods = (uint32_t) std::min(mesh.lod.size(), (size_t) mesh_max_lods);
+        for (uint32_t i = 0; i < header.num_lods; i++) {
+            header.lod[i] = mesh.lod[i];
+        }
+
+        std::ofstream f;
+        f.open(GetCacheFilename(source_filename).c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (f.fail()) {
+            return false;
+        }
+        f.write((const char *) &header, sizeof(header));
+        f.write((const char *) mesh.vertex.data(), mesh.vertex.size());
+        f.write((const char *) mesh.index.data(), mesh.index.size());
+        f.close();
+
+        // A partial file fails the size check when it is opened
+        return !f.fail();
+    }
+
+
+    std::string MeshCache::GetCacheFilename(const char *source_filename) {
+
+        return std::string(source_filename) + std::string(MESH_CACHE_EXTENSION);
+    }
+
+
+    const void *MeshCache::GetVertices(void) const {
+
+        return file_.GetData() + sizeof(MeshCacheHeader);
+    }
+
+
+    size_t MeshCache::GetVertexBytes(void) const {
+
+        return header_->vertex_bytes;
+    }
+
+
+    const void *MeshCache::GetIndices(void) const {
+
+        return file_.GetData() + sizeof(MeshCacheHeader) + header_->vertex_bytes;
+    }
+
+
+    GLsizei MeshCache::GetNumIndices(void) const {
+
+        return header_->num_indices;
+    }
+
+
+    const VertexLayout &MeshCache::GetLayout(void) const {
+
+        return header_->layout;
+    }
+
+
+    glm::vec3 MeshCache::GetBoundsMin(void) const {
+
+        return glm::vec3(header_->bounds_min[0], header_->bounds_min[1], header_->bounds_min[2]);
+    }
+
+
+    glm::vec3 MeshCache::GetBoundsMax(void) const {
+
+        return glm::vec3(header_->bounds_max[0], header_->bounds_max[1], header_->bounds_max[2]);
+    }
+
+
+    int MeshCache::GetNumLods(void) const {
+
+        return (int) header_->num_lods;
+    }
+
+
+    const MeshLod *MeshCache::GetLods(void) const {
+
+        return header_->lod;
+    }
+
+} // namespace game
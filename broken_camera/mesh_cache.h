@@ -0,0 +1,74 @@
+#ifndef MESH_CACHE_H_
+#define MESH_CACHE_H_
+
+#include <string>
+#include <cstdint>
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "vertex_format.h"
+#include "mapped_file.h"
+
+// Extension added to the name of an OBJ file to get the name of its cache
+#define MESH_CACHE_EXTENSION ".meshcache"
+
+namespace game {
+
+    // Header at the start of a mesh cache file. The vertex data follows the
+    // header, then the index data
+    struct MeshCacheHeader {
+        char magic[4]; // "MSHC"
+        uint32_t version; // Bumped whenever the layout or the loader changes
+        uint64_t source_size; // Size and modification time of the OBJ file
+        int64_t source_mtime;
+        uint32_t vertex_format; // VertexFormat the mesh was packed with
+        uint32_t num_vertices;
+        uint32_t num_indices;
+        uint32_t vertex_bytes;
+        uint32_t index_bytes;
+        float bounds_min[3];
+        float bounds_max[3];
+        VertexLayout layout; // Only read back by the program that wrote it
+        uint32_t num_lods;
+        MeshLod lod[mesh_max_lods]; // Ranges of the index data
+    };
+
+    // Binary copy of a mesh in the format of the OpenGL buffers, stored
+    // next to the OBJ file it was built from
+    class MeshCache {
+
+        public:
+            MeshCache(void);
+
+            // Map the cache of an OBJ file into memory. Returns false if the
+            // cache is missing, unreadable, older than the OBJ file, or
+            // stored in another format
+            bool Open(const char *source_filename, VertexFormat format);
+            void Close(void);
+
+            // Save the cache of an OBJ file. Returns false if the cache
+            // could not be written, which only means it is rebuilt next run
+            static bool Write(const char *source_filename, VertexFormat format, const PackedMesh &mesh);
+            static std::string GetCacheFilename(const char *source_filename);
+
+            // Data of an open cache
+            const void *GetVertices(void) const;
+            size_t GetVertexBytes(void) const;
+            const void *GetIndices(void) const;
+            GLsizei GetNumIndices(void) const;
+            const VertexLayout &GetLayout(void) const;
+            glm::vec3 GetBoundsMin(void) const;
+            glm::vec3 GetBoundsMax(void) const;
+            int GetNumLods(void) const;
+            const MeshLod *GetLods(void) const;
+
+        private:
+            MappedFile file_;
+            const MeshCacheHeader *header_;
+
+    }; // class MeshCache
+
+} // namespace game
+
+#endif // MESH_CACHE_H_
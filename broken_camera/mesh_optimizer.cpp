@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
+
+#include "mesh_optimizer.h"
+
+namespace game {
+
+    namespace {
+
+        // Hash and compare vertices by the bits of their attributes
+        struct VertexKey {
+            const GLfloat *att;
+        };
+
+        struct VertexKeyHash {
+            size_t operator()(const VertexKey &key) const {
+                // FNV-1a over the bytes of the attributes
+                const unsigned char *bytes = (const unsigned char *) key.att;
+                uint64_t hash = 14695981039346656037ULL;
+                for (size_t i = 0; i < mesh_vertex_att * sizeof(GLfloat); i++) {
+                    hash ^= bytes[i];
+                    hash *= 1099511628211ULL;
+                }
+                return (size_t) hash;
+            }
+        };
+
+        struct VertexKeyEqual {
+            bool operator()(const VertexKey &a, const VertexKey &b) const {
+                return memcmp(a.att, b.att, mesh_vertex_att * sizeof(GLfloat)) == 0;
+            }
+        };
+
+
+        // Score of a vertex from its position in the cache and the number
+        // of triangles still to be emitted that use it
+        float vertex_score(int cache_pos, int remaining) {
+
+            const float cache_decay_power = 1.5f;
+            const float last_tri_score = 0.75f;
+            const float valence_boost_scale = 2.0f;
+            const float valence_boost_power = 0.5f;
+
+            if (remaining == 0) {
+                // No triangle needs this vertex
+                return -1.0f;
+            }
+
+            float score = 0.0f;
+            if (cache_pos >= 0) {
+                if (cache_pos < 3) {
+                    // Vertices of the last triangle get a fixed score, so
+                    // that strips are not favored over fans
+                    score = last_tri_score;
+                }
+                else {
+                    float scaler = 1.0f / (optimizer_cache_size - 3);
+                    score = powf(1.0f - (cache_pos - 3) * scaler, cache_decay_power);
+                }
+            }
+
+            // Boost vertices with few triangles left, so that lone
+            // triangles are not left behind
+            score += valence_boost_scale * powf((float) remaining, -valence_boost_power);
+            return score;
+        }
+
+    } // namespace
+
+
+    void weld_vertices(MeshData& data) {
+
+        size_t num_vertices = data.vertex.size() / mesh_vertex_att;
+
+        // Map each vertex to the first vertex with the same attributes
+        std::unordered_map<VertexKey, GLuint, VertexKeyHash, VertexKeyEqual> unique;
+        unique.reserve(num_vertices);
+        std::vector<GLuint> remap(num_vertices);
+        std::vector<GLfloat> vertex;
+        vertex.reserve(data.vertex.size());
+        for (size_t i = 0; i < num_vertices; i++) {
+            VertexKey key = { &data.vertex[i * mesh_vertex_att] };
+            GLuint next = (GLuint) (vertex.size() / mesh_vertex_att);
+            std::pair<std::unordered_map<VertexKey, GLuint, VertexKeyHash, VertexKeyEqual>::iterator, bool> res = unique.insert(std::make_pair(key, next));
+            if (res.second) {
+                vertex.insert(vertex.end(), key.att, key.att + mesh_vertex_att);
+            }
+            remap[i] = res.first->second;
+        }
+
+        for (size_t i = 0; i < data.index.size(); i++) {
+            data.index[i] = remap[data.index[i]];
+        }
+        // The keys point into the old array, so only replace it at the end
+        data.vertex.swap(vertex);
+    }
+
+
+    void optimize_vertex_cache(std::vector<GLuint>& index, size_t num_vertices) {
+
+        size_t num_triangles = index.size() / 3;
+        if (num_triangles == 0) {
+            return;
+        }
+
+        // Triangles that use each vertex, packed in one array
+        std::vector<int> remaining(num_vertices, 0);
+        for (size_t i = 0; i < index.size(); i++) {
+            remaining[index[i]]++;
+        }
+        std::vector<size_t> offset(num_vertices + 1, 0);
+        for (size_t v = 0; v < num_vertices; v++) {
+            offset[v + 1] = offset[v] + remaining[v];
+        }
+        std::vector<GLuint> adjacency(index.size());
+        std::vector<size_t> fill(offset.begin(), offset.end() - 1);
+        for (size_t t = 0; t < num_triangles; t++) {
+            for (int k = 0; k < 3; k++) {
+                adjacency[fill[index[t * 3 + k]]++] = (GLuint) t;
+            }
+        }
+
+        // Initial scores; no vertex is in the cache yet
+        std::vector<int> cache_pos(num_vertices, -1);
+        std::vector<float> score(num_vertices);
+        for (size_t v = 0; v < num_vertices; v++) {
+            score[v] = vertex_score(-1, remaining[v]);
+        }
+        std::vector<bool> emitted(num_triangles, false);
+
+        // Vertices in the cache, most recent first. There is room for the
+        // three vertices pushed out by each new triangle
+        std::vector<GLuint> cache, new_cache;
+        cache.reserve(optimizer_cache_size + 3);
+        new_cache.reserve(optimizer_cache_size + 3);
+
+        std::vector<GLuint> result;
+        result.reserve(index.size());
+        size_t next_unemitted = 0;
+        long best = -1;
+
+        for (size_t n = 0; n < num_triangles; n++) {
+            // Without a candidate from the cache, start over from the next
+            // triangle not emitted yet
+            if (best < 0) {
+                while (emitted[next_unemitted]) {
+                    next_unemitted++;
+                }
+                best = (long) next_unemitted;
+            }
+
+            // Emit the triangle and remove it from its vertices
+            const GLuint *tri = &index[best * 3];
+            result.insert(result.end(), tri, tri + 3);
+            emitted[best] = true;
+            for (int k = 0; k < 3; k++) {
+                GLuint v = tri[k];
+                GLuint *begin = &adjacency[offset[v]];
+                GLuint *end = begin + remaining[v];
+                GLuint *it = std::find(begin, end, (GLuint) best);
+                *it = *(end - 1);
+                remaining[v]--;
+            }
+
+            // Move the vertices of the triangle to the front of the cache
+            new_cache.assign(tri, tri + 3);
+            for (size_t i = 0; i < cache.size(); i++) {
+                GLuint v = cache[i];
+                if ((v != tri[0]) && (v != tri[1]) && (v != tri[2])) {
+                    new_cache.push_back(v);
+                }
+            }
+            cache.swap(new_cache);
+
+            // Update the scores of the vertices that moved, including the
+            // ones that just fell out of the cache
+            for (size_t i = 0; i < cache.size(); i++) {
+                GLuint v = cache[i];
+                cache_pos[v] = (i < (size_t) optimizer_cache_size) ? (int) i : -1;
+                score[v] = vertex_score(cache_pos[v], remaining[v]);
+            }
+
+            // Pick the best triangle among those using cached vertices
+            best = -1;
+            float best_score = -1.0f;
+            for (size_t i = 0; i < cache.size(); i++) {
+                GLuint v = cache[i];
+                for (int j = 0; j < remaining[v]; j++) {
+                    GLuint t = adjacency[offset[v] + j];
+                    float s = score[index[t * 3]] + score[index[t * 3 + 1]] + score[index[t * 3 + 2]];
+                    if (s > best_score) {
+                        best_score = s;
+                        best = (long) t;
+                    }
+                }
+            }
+
+            if (cache.size() > (size_t) optimizer_cache_size) {
+                cache.resize(optimizer_cache_size);
+            }
+        }
+
+        index.swap(result);
+    }
+
+
+    void optimize_vertex_fetch(MeshData& data) {
+
+        size_t num_vertices = data.vertex.size() / mesh_vertex_att;
+        const GLuint unused = (GLuint) -1;
+
+        // Number the vertices in the order the index buffer reaches them
+        std::vector<GLuint> remap(num_vertices, unused);
+        GLuint next = 0;
+        for (size_t i = 0; i < data.index.size(); i++) {
+            GLuint &v = remap[data.index[i]];
+            if (v == unused) {
+                v = next++;
+            }
+            data.index[i] = v;
+        }
+
+        std::vector<GLfloat> vertex(next * mesh_vertex_att);
+        for (size_t i = 0; i < num_vertices; i++) {
+            if (remap[i] != unused) {
+                memcpy(&vertex[remap[i] * mesh_vertex_att], &data.vertex[i * mesh_vertex_att], mesh_vertex_att * sizeof(GLfloat));
+            }
+        }
+        data.vertex.swap(vertex);
+    }
+
+
+    float compute_acmr(const std::vector<GLuint>& index, size_t num_vertices) {
+
+        size_t num_triangles = index.size() / 3;
+        if (num_triangles == 0) {
+            return 0.0f;
+        }
+
+        // Simulate a FIFO cache; a vertex is in the cache if it was added
+        // less than acmr_cache_size misses ago
+        std::vector<size_t> added(num_vertices, 0);
+        size_t misses = 0;
+        for (size_t i = 0; i < index.size(); i++) {
+            GLuint v = index[i];
+            if ((added[v] == 0) || (misses - added[v] >= (size_t) acmr_cache_size)) {
+                misses++;
+                added[v] = misses;
+            }
+        }
+        return (float) misses / (float) num_triangles;
+    }
+
+
+    void optimize_mesh(MeshData& data, MeshOptimizeStats* stats) {
+
+        if (stats) {
+            stats->num_vertices_before = data.vertex.size() / mesh_vertex_att;
+            stats->acmr_before = compute_acmr(data.index, stats->num_vertices_before);
+            stats->bytes_before = data.vertex.size() * sizeof(GLfloat) + data.index.size() * sizeof(GLuint);
+        }
+
+        weld_vertices(data);
+        optimize_vertex_cache(data.index, data.vertex.size() / mesh_vertex_att);
+        optimize_vertex_fetch(data);
+
+        if (stats) {
+            stats->num_vertices_after = data.vertex.size() / mesh_vertex_att;
+            stats->acmr_after = compute_acmr(data.index, stats->num_vertices_after);
+            stats->bytes_after = data.vertex.size() * sizeof(GLfloat) + data.index.size() * sizeof(GLuint);
+        }
+    }
+
+} // namespace game
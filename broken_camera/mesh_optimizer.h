@@ -0,0 +1,46 @@
+#ifndef MESH_OPTIMIZER_H_
+#define MESH_OPTIMIZER_H_
+
+#include <vector>
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "model_loader.h"
+
+namespace game {
+
+    // Number of entries in the vertex cache that triangles are ordered for
+    const int optimizer_cache_size = 32;
+    // Number of entries in the FIFO cache used to measure the ACMR, closer
+    // to the post-transform cache of current hardware
+    const int acmr_cache_size = 16;
+
+    // Size and vertex cache efficiency of a mesh before and after
+    // optimization
+    struct MeshOptimizeStats {
+        size_t num_vertices_before;
+        size_t num_vertices_after;
+        float acmr_before; // Average vertices transformed per triangle
+        float acmr_after;
+        size_t bytes_before; // Size of the vertex and index buffers
+        size_t bytes_after;
+    };
+
+    // Merge vertices with identical attributes, so that triangles share
+    // them through the index buffer
+    void weld_vertices(MeshData& data);
+    // Reorder triangles so that vertices are reused while they are still in
+    // the post-transform cache (Forsyth's linear-speed algorithm)
+    void optimize_vertex_cache(std::vector<GLuint>& index, size_t num_vertices);
+    // Reorder vertices in the order the triangles first use them, dropping
+    // unused vertices
+    void optimize_vertex_fetch(MeshData& data);
+    // Average number of vertices transformed per triangle with a FIFO
+    // cache of acmr_cache_size entries; 3 means no reuse at all
+    float compute_acmr(const std::vector<GLuint>& index, size_t num_vertices);
+    // Run all of the steps above on a mesh. Stats may be NULL
+    void optimize_mesh(MeshData& data, MeshOptimizeStats* stats);
+
+} // namespace game
+
+#endif // MESH_OPTIMIZER_H_
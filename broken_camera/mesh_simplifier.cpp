@@ -0,0 +1,372 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
+
+#include "mesh_simplifier.h"
+#include "mesh_optimizer.h"
+
+namespace game {
+
+    namespace {
+
+        // Sum of squared distances to a set of planes, weighted by area.
+        // Dividing by the weight gives a mean squared distance
+        struct Quadric {
+            double a2, ab, ac, ad;
+            double b2, bc, bd;
+            double c2, cd;
+            double d2;
+            double weight;
+
+            Quadric(void) {
+                a2 = ab = ac = ad = b2 = bc = bd = c2 = cd = d2 = weight = 0.0;
+            }
+
+            // Add the plane n.x + d = 0 with the given weight; n has unit length
+            void AddPlane(const glm::dvec3 &n, double d, double w) {
+                a2 += w * n.x * n.x; ab += w * n.x * n.y; ac += w * n.x * n.z; ad += w * n.x * d;
+                b2 += w * n.y * n.y; bc += w * n.y * n.z; bd += w * n.y * d;
+                c2 += w * n.z * n.z; cd += w * n.z * d;
+                d2 += w * d * d;
+                weight += w;
+            }
+
+            void Add(const Quadric &q) {
+                a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+                b2 += q.b2; bc += q.bc; bd += q.bd;
+                c2 += q.c2; cd += q.cd;
+                d2 += q.d2;
+                weight += q.weight;
+            }
+
+            double Error(const glm::vec3 &p) const {
+                double x = p.x, y = p.y, z = p.z;
+                double e = a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x +
+                    b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y +
+                    c2 * z * z + 2.0 * cd * z + d2;
+                return (weight > 0.0) ? std::fabs(e) / weight : 0.0;
+            }
+        };
+
+
+        // An edge between two positions, collapsed from v0 onto v1
+        struct Collapse {
+            GLuint v0;
+            GLuint v1;
+            double error;
+
+            bool operator<(const Collapse &other) const {
+                return error < other.error;
+            }
+        };
+
+
+        struct PositionHash {
+            size_t operator()(const glm::vec3 &p) const {
+                uint32_t bits[3];
+                memcpy(bits, &p[0], sizeof(bits));
+                return (size_t) (bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+            }
+        };
+
+
+        inline uint64_t edge_key(GLuint a, GLuint b) {
+
+            return (a < b) ? (((uint64_t) a << 32) | b) : (((uint64_t) b << 32) | a);
+        }
+
+    } // namespace
+
+
+    float simplify_mesh(const MeshData& data, const std::vector<GLuint>& index, size_t target_count, float max_error, std::vector<GLuint>& result) {
+
+        size_t num_vertices = data.vertex.size() / mesh_vertex_att;
+        result = index;
+        if (result.size() <= target_count) {
+            return 0.0f;
+        }
+
+        // Vertices that differ only in normal or texture coordinates share a
+        // position; the simplifier works on positions
+        std::unordered_map<glm::vec3, GLuint, PositionHash> position_id;
+        std::vector<GLuint> pid(num_vertices);
+        std::vector<glm::vec3> position;
+        for (size_t v = 0; v < num_vertices; v++) {
+            const GLfloat *att = &data.vertex[v * mesh_vertex_att];
+            glm::vec3 p(att[0], att[1], att[2]);
+            std::pair<std::unordered_map<glm::vec3, GLuint, PositionHash>::iterator, bool> res = position_id.insert(std::make_pair(p, (GLuint) position.size()));
+            if (res.second) {
+                position.push_back(p);
+            }
+            pid[v] = res.first->second;
+        }
+        size_t num_positions = position.size();
+
+        // Vertices at each position, to pick attributes after a collapse
+        std::vector<std::vector<GLuint> > position_vertices(num_positions);
+        for (size_t v = 0; v < num_vertices; v++) {
+            position_vertices[pid[v]].push_back((GLuint) v);
+        }
+
+        // Count the triangles on each edge to find the borders of the mesh
+        std::unordered_map<uint64_t, int> edge_count;
+        edge_count.reserve(result.size());
+        for (size_t t = 0; t < result.size(); t += 3) {
+            for (int k = 0; k < 3; k++) {
+                GLuint a = pid[result[t + k]], b = pid[result[t + (k + 1) % 3]];
+                edge_count[edge_key(a, b)]++;
+            }
+        }
+
+        // Quadrics of the triangle planes, plus planes through the border
+        // edges so that borders keep their shape
+        std::vector<Quadric> quadric(num_positions);
+        std::vector<bool> border(num_positions, false);
+        for (size_t t = 0; t < result.size(); t += 3) {
+            glm::dvec3 p0 = glm::dvec3(position[pid[result[t]]]);
+            glm::dvec3 p1 = glm::dvec3(position[pid[result[t + 1]]]);
+            glm::dvec3 p2 = glm::dvec3(position[pid[result[t + 2]]]);
+            glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+            double area = glm::length(n);
+            if (area <= 0.0) {
+                continue;
+            }
+            n /= area;
+            for (int k = 0; k < 3; k++) {
+                quadric[pid[result[t + k]]].AddPlane(n, -glm::dot(n, p0), area * 0.5);
+            }
+
+            for (int k = 0; k < 3; k++) {
+                GLuint a = pid[result[t + k]], b = pid[result[t + (k + 1) % 3]];
+                if (edge_count[edge_key(a, b)] != 1) {
+                    continue;
+                }
+                border[a] = true;
+                border[b] = true;
+                glm::dvec3 edge = glm::dvec3(position[b]) - glm::dvec3(position[a]);
+                double length = glm::length(edge);
+                if (length <= 0.0) {
+                    continue;
+                }
+                glm::dvec3 side = glm::normalize(glm::cross(edge, n));
+                double w = length * length * 10.0;
+                quadric[a].AddPlane(side, -glm::dot(side, glm::dvec3(position[a])), w);
+                quadric[b].AddPlane(side, -glm::dot(side, glm::dvec3(position[a])), w);
+            }
+        }
+
+        std::vector<GLuint> remap(num_positions);
+        std::vector<bool> locked(num_positions);
+        std::vector<size_t> adjacency_offset(num_positions + 1);
+        std::vector<GLuint> adjacency;
+        std::vector<Collapse> collapses;
+        double max_error_sq = (double) max_error * (double) max_error;
+        double reached = 0.0;
+
+        // Collapse edges in passes. Each pass collapses the cheapest edges
+        // whose neighborhoods do not overlap, then rebuilds the triangles
+        while (result.size() > target_count) {
+
+            // Triangles around each position
+            size_t num_triangles = result.size() / 3;
+            std::fill(adjacency_offset.begin(), adjacency_offset.end(), 0);
+            for (size_t i = 0; i < result.size(); i++) {
+                adjacency_offset[pid[result[i]] + 1]++;
+            }
+            for (size_t p = 0; p < num_positions; p++) {
+                adjacency_offset[p + 1] += adjacency_offset[p];
+            }
+            adjacency.resize(result.size());
+            std::vector<size_t> fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+            for (size_t t = 0; t < num_triangles; t++) {
+                for (int k = 0; k < 3; k++) {
+                    adjacency[fill[pid[result[t * 3 + k]]]++] = (GLuint) t;
+                }
+            }
+
+            // Cheapest valid direction of each edge
+            collapses.clear();
+            for (size_t t = 0; t < num_triangles; t++) {
+                for (int k = 0; k < 3; k++) {
+                    GLuint a = pid[result[t * 3 + k]], b = pid[result[t * 3 + (k + 1) % 3]];
+                    bool border_edge = edge_count[edge_key(a, b)] == 1;
+                    // Consider inner edges once; the other triangle has them as b, a
+                    if ((a > b) && !border_edge) {
+                        continue;
+                    }
+                    Quadric q = quadric[a];
+                    q.Add(quadric[b]);
+                    Collapse c;
+                    c.error = -1.0;
+                    // Border positions may only slide along the border
+                    if (!border[a] || border_edge) {
+                        c.v0 = a;
+                        c.v1 = b;
+                        c.error = q.Error(position[b]);
+                    }
+                    if (!border[b] || border_edge) {
+                        double e = q.Error(position[a]);
+                        if ((c.error < 0.0) || (e < c.error)) {
+                            c.v0 = b;
+                            c.v1 = a;
+                            c.error = e;
+                        }
+                    }
+                    if (c.error >= 0.0) {
+                        collapses.push_back(c);
+                    }
+                }
+            }
+            std::sort(collapses.begin(), collapses.end());
+
+            // Pick collapses until enough triangles would be removed
+            for (size_t p = 0; p < num_positions; p++) {
+                remap[p] = (GLuint) p;
+                locked[p] = false;
+            }
+            size_t removed = 0;
+            size_t to_remove = (result.size() - target_count) / 3;
+            size_t num_collapsed = 0;
+            for (size_t i = 0; (i < collapses.size()) && (removed < to_remove); i++) {
+                const Collapse &c = collapses[i];
+                if (c.error > max_error_sq) {
+                    break;
+                }
+                if (locked[c.v0] || locked[c.v1]) {
+                    continue;
+                }
+
+                // Moving v0 onto v1 must not flip the triangles around v0
+                bool flips = false;
+                size_t shared = 0;
+                for (size_t j = adjacency_offset[c.v0]; j < adjacency_offset[c.v0 + 1]; j++) {
+                    const GLuint *tri = &result[adjacency[j] * 3];
+                    GLuint p0 = pid[tri[0]], p1 = pid[tri[1]], p2 = pid[tri[2]];
+                    if ((p0 == c.v1) || (p1 == c.v1) || (p2 == c.v1)) {
+                        shared++;
+                        continue;
+                    }
+                    glm::vec3 before = glm::cross(position[p1] - position[p0], position[p2] - position[p0]);
+                    glm::vec3 q0 = position[(p0 == c.v0) ? c.v1 : p0];
+                    glm::vec3 q1 = position[(p1 == c.v0) ? c.v1 : p1];
+                    glm::vec3 q2 = position[(p2 == c.v0) ? c.v1 : p2];
+                    glm::vec3 after = glm::cross(q1 - q0, q2 - q0);
+                    if (glm::dot(before, after) <= 0.0f) {
+                        flips = true;
+                        break;
+                    }
+                }
+                if (flips) {
+                    continue;
+                }
+
+                // Lock the neighborhood of v0, whose triangles change
+                for (size_t j = adjacency_offset[c.v0]; j < adjacency_offset[c.v0 + 1]; j++) {
+                    const GLuint *tri = &result[adjacency[j] * 3];
+                    locked[pid[tri[0]]] = true;
+                    locked[pid[tri[1]]] = true;
+                    locked[pid[tri[2]]] = true;
+                }
+                remap[c.v0] = c.v1;
+                quadric[c.v1].Add(quadric[c.v0]);
+                reached = std::max(reached, c.error);
+                removed += shared;
+                num_collapsed++;
+            }
+            if (num_collapsed == 0) {
+                break;
+            }
+
+            // Rebuild the triangles. Each corner that moved takes the vertex
+            // at its new position with the closest normal and texture
+            // coordinates
+            std::vector<GLuint> next;
+            next.reserve(result.size());
+            for (size_t t = 0; t < num_triangles; t++) {
+                GLuint tri[3];
+                for (int k = 0; k < 3; k++) {
+                    GLuint v = result[t * 3 + k];
+                    GLuint p = remap[pid[v]];
+                    tri[k] = v;
+                    if (p != pid[v]) {
+                        const GLfloat *att = &data.vertex[v * mesh_vertex_att];
+                        float best = -1.0f;
+                        const std::vector<GLuint> &candidates = position_vertices[p];
+                        for (size_t j = 0; j < candidates.size(); j++) {
+                            const GLfloat *other = &data.vertex[candidates[j] * mesh_vertex_att];
+                            float d = 0.0f;
+                            for (int m = 3; m < mesh_vertex_att; m++) {
+                                d += (att[m] - other[m]) * (att[m] - other[m]);
+                            }
+                            if ((best < 0.0f) || (d < best)) {
+                                best = d;
+                                tri[k] = candidates[j];
+                            }
+                        }
+                    }
+                }
+                if ((pid[tri[0]] == pid[tri[1]]) || (pid[tri[1]] == pid[tri[2]]) || (pid[tri[0]] == pid[tri[2]])) {
+                    continue;
+                }
+                next.insert(next.end(), tri, tri + 3);
+            }
+            result.swap(next);
+
+            // Border edges may have changed; recount them
+            edge_count.clear();
+            for (size_t t = 0; t < result.size(); t += 3) {
+                for (int k = 0; k < 3; k++) {
+                    edge_count[edge_key(pid[result[t + k]], pid[result[t + (k + 1) % 3]])]++;
+                }
+            }
+        }
+
+        return (float) sqrt(reached);
+    }
+
+
+    void build_mesh_lods(MeshData& data) {
+
+        // The full mesh is the first level
+        MeshLod full = { 0, (GLsizei) data.index.size(), 0.0f };
+        data.lod.assign(1, full);
+
+        size_t num_triangles = data.index.size() / 3;
+        if (num_triangles < lod_min_triangles) {
+            return;
+        }
+
+        // Limit the error of each level relative to the size of the mesh
+        float radius = glm::length(data.bounds_max - data.bounds_min) * 0.5f;
+        const float max_relative_error[mesh_max_lods] = { 0.0f, 0.01f, 0.025f, 0.06f };
+
+        std::vector<GLuint> previous(data.index.begin(), data.index.end());
+        float error = 0.0f;
+        for (int level = 1; level < mesh_max_lods; level++) {
+            // Each level starts from the one before, so its error adds to
+            // theirs. The cap of a level bounds that sum
+            float max_error = max_relative_error[level] * radius - error;
+            if (max_error <= 0.0f) {
+                break;
+            }
+            std::vector<GLuint> simplified;
+            size_t target = ((num_triangles >> level) * 3);
+            float level_error = simplify_mesh(data, previous, target, max_error, simplified);
+
+            // Stop when simplification no longer pays off
+            if (simplified.size() * 10 > previous.size() * 9) {
+                break;
+            }
+            optimize_vertex_cache(simplified, data.vertex.size() / mesh_vertex_att);
+
+            error += level_error;
+            MeshLod lod = { (GLuint) data.index.size(), (GLsizei) simplified.size(), error };
+            data.lod.push_back(lod);
+            data.index.insert(data.index.end(), simplified.begin(), simplified.end());
+            previous.swap(simplified);
+        }
+    }
+
+} // namespace game
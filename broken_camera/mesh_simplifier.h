@@ -0,0 +1,27 @@
+#ifndef MESH_SIMPLIFIER_H_
+#define MESH_SIMPLIFIER_H_
+
+#include <vector>
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "model_loader.h"
+
+namespace game {
+
+    // Meshes with fewer triangles than this only get the full level
+    const size_t lod_min_triangles = 512;
+
+    // Simplify the triangles in index to about target_count indices by
+    // collapsing edges in order of quadric error, without moving vertices
+    // past max_error (in model units). Collapses only move a vertex onto one
+    // of its neighbors, so the result indexes the same vertices as the input
+    // Returns the largest error of the collapses that were done
+    float simplify_mesh(const MeshData& data, const std::vector<GLuint>& index, size_t target_count, float max_error, std::vector<GLuint>& result);
+    // Append levels of detail with about 1/2, 1/4 and 1/8 of the triangles
+    // to the index buffer, and describe them in data.lod
+    void build_mesh_lods(MeshData& data);
+
+} // namespace game
+
+#endif // MESH_SIMPLIFIER_H_
@@ -11,6 +11,8 @@
 #include <glm/glm.hpp>
 #include <vector>
 
+#include "resource.h"
+
 namespace game {
 
     // Auxiliary definitions and functions for model loading
@@ -37,6 +39,21 @@ namespace game {
         std::vector<Face> face;
     };
 
+    // Number of floats per vertex in mesh buffers: position (3), normal (3),
+    // color (3) and texture coordinates (2)
+    const int mesh_vertex_att = 11;
+
+    // A mesh in the layout of the OpenGL buffers, with interleaved vertex
+    // attributes and triangle indices. The levels of detail are ranges of
+    // the index buffer, starting with the full mesh
+    struct MeshData {
+        std::vector<GLfloat> vertex;
+        std::vector<GLuint> index;
+        glm::vec3 bounds_min;
+        glm::vec3 bounds_max;
+        std::vector<MeshLod> lod;
+    };
+
     // Helper functions 
     // Trim any character in to_trim from the beginning and end of str
     void string_trim(std::string str, std::string to_trim);
@@ -46,11 +63,43 @@ namespace game {
     // split is performed when one separator character is found, rather than
     // a sequence of separators
     std::vector<std::string> string_split_once(std::string str, std::string separator);
+    // Convert an OBJ index into a 0-based one. Negative indices are relative
+    // to the count elements read so far
+    int obj_index(std::string str, size_t count);
     // Print a mesh stored internally
     void print_mesh(TriMesh& mesh);
+    // Parse an OBJ file into a mesh. The file is mapped into memory and
+    // tokenized in place, without allocating memory per line
+    void load_obj(const char* filename, TriMesh& mesh);
+    // Parse an OBJ file line by line with string_split. This is the
+    // original loader, kept as a reference to check load_obj against
+    void load_obj_legacy(const char* filename, TriMesh& mesh);
+    // Compute vertex normals by averaging the normals of adjacent faces
+    void compute_vertex_normals(TriMesh& mesh);
+    // Create the buffer layout of a mesh. If vertex_normals is set, normals
+    // are indexed by vertex rather than by face corner
+    void build_mesh_data(const TriMesh& mesh, bool vertex_normals, MeshData& data);
+    // Check that two meshes are the same; on mismatch, diff describes the
+    // first difference found
+    bool compare_meshes(const TriMesh& a, const TriMesh& b, std::string& diff);
     // Conversion between strings and numbers
-    template <typename T> std::string num_to_str(T num);
-    template <typename T> T str_to_num(const std::string& str);
+    template <typename T> std::string num_to_str(T num) {
+
+        std::ostringstream ss;
+        ss << num;
+        return ss.str();
+    }
+
+    template <typename T> T str_to_num(const std::string& str) {
+
+        std::istringstream ss(str);
+        T result;
+        ss >> result;
+        if (ss.fail()) {
+            throw(std::ios_base::failure(std::string("Invalid number: ") + str));
+        }
+        return result;
+    }
 
 } // namespace game;
 
@@ -0,0 +1,50 @@
+#include <iostream>
+
+#include "node_pool.h"
+
+namespace game {
+
+    std::vector<NodePoolBase *> NodePool::pool_;
+    NodePoolStats NodePool::stats_ = { 0, 0, 0, 0, 0 };
+    bool NodePool::clearing_ = false;
+
+
+    void NodePool::Destroy(SceneNode *node) {
+
+        // Clear destroys every node itself, parents and children alike
+        if ((node == NULL) || clearing_) {
+            return;
+        }
+        if (node->pool_ == NULL) {
+            delete node;
+            return;
+        }
+        node->pool_->Free(node);
+        stats_.num_live--;
+    }
+
+
+    void NodePool::Clear(void) {
+
+        clearing_ = true;
+        for (size_t i = 0; i < pool_.size(); i++) {
+            pool_[i]->Release();
+        }
+        clearing_ = false;
+    }
+
+
+    const NodePoolStats &NodePool::GetStats(void) {
+
+        return stats_;
+    }
+
+
+    void NodePool::PrintStats(void) {
+
+        std::cout << "Scene nodes: " << stats_.num_live << " alive, " << stats_.peak_live << " at most, " <<
+            stats_.num_created << " created; " << stats_.num_blocks << " blocks held, " <<
+            stats_.num_block_allocations << " allocated" << std::endl;
+    }
+
+} // namespace game
@@ -0,0 +1,186 @@
+#ifndef NODE_POOL_H_
+#define NODE_POOL_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "scene_node.h"
+#include "render_stats.h"
+
+namespace game {
+
+    // Objects held by the node pools
+    struct NodePoolStats {
+        size_t num_live; // Created and not destroyed yet
+        size_t peak_live;
+        size_t num_created; // Since the start, including reused slots
+        size_t num_blocks; // Blocks of slots held
+        size_t num_block_allocations; // Since the start
+    };
+
+    // Storage of the scene objects of one type
+    class NodePoolBase {
+
+        public:
+            virtual ~NodePoolBase() {}
+            // Destroy an object of the pool and put its slot on the free
+            // list
+            virtual void Free(SceneNode *node) = 0;
+            // Destroy the objects still alive and release the blocks
+            virtual void Release(void) = 0;
+
+    }; // class NodePoolBase
+
+
+    // Objects of type T in blocks of contiguous slots. Freed slots go on a
+    // list and are reused first
+    template <typename T> class TypedNodePool : public NodePoolBase {
+
+        public:
+            TypedNodePool(void) : free_(NULL) {}
+
+            // Construct an object in a free slot, adding a block if there
+            // is none
+            template <typename... Args> T *Allocate(Args&&... args);
+            void Free(SceneNode *node);
+            void Release(void);
+
+        private:
+            // The object comes first, so that its address is that of the
+            // slot
+            struct Slot {
+                typename std::aligned_storage<sizeof(T), alignof(T)>::type object;
+                Slot *next; // Next free slot
+                bool live;
+            };
+            static const size_t block_size_ = 64;
+
+            std::vector<Slot *> block_;
+            Slot *free_;
+
+            void AddBlock(void);
+
+    }; // class TypedNodePool
+
+
+    // Creates and destroys every scene node, from one pool per type.
+    // Ownership is as follows: the scene graph owns the nodes added to it,
+    // and its sky box, and destroys them when they are removed or when it
+    // is cleared. A node owns its children. Anything else, like the screens
+    // of the user interface, belongs to whoever created it and must be
+    // passed to Destroy. Clear ends all of them at once when the world is
+    // torn down. Only used from the main thread
+    class NodePool {
+
+        public:
+            // Construct a node of type T, which derives from SceneNode
+            template <typename T, typename... Args> static T *Create(Args&&... args);
+            // Destroy a node and its children. Nodes made with new are
+            // deleted
+            static void Destroy(SceneNode *node);
+            // Destroy the nodes still alive and release all blocks
+            static void Clear(void);
+
+            static const NodePoolStats &GetStats(void);
+            static void PrintStats(void);
+
+        private:
+            template <typename T> friend class TypedNodePool;
+
+            static std::vector<NodePoolBase *> pool_;
+            static NodePoolStats stats_;
+            static bool clearing_; // Destroy does nothing while set
+
+            template <typename T> static TypedNodePool<T> &GetPool(void);
+
+    }; // class NodePool
+
+
+    template <typename T> template <typename... Args> T *TypedNodePool<T>::Allocate(Args&&... args) {
+
+        if (free_ == NULL) {
+            AddBlock();
+        }
+        Slot *slot = free_;
+        T *object = new (&slot->object) T(std::forward<Args>(args)...);
+        free_ = slot->next;
+        slot->live = true;
+        return object;
+    }
+
+
+    template <typename T> void TypedNodePool<T>::Free(SceneNode *node) {
+
+        T *object = static_cast<T *>(node);
+        object->~T();
+        Slot *slot = reinterpret_cast<Slot *>(object);
+        slot->live = false;
+        slot->next = free_;
+        free_ = slot;
+    }
+
+
+    template <typename T> void TypedNodePool<T>::Release(void) {
+
+        for (size_t i = 0; i < block_.size(); i++) {
+            for (size_t j = 0; j < block_size_; j++) {
+                if (block_[i][j].live) {
+                    reinterpret_cast<T *>(&block_[i][j].object)->~T();
+                    NodePool::stats_.num_live--;
+                }
+            }
+            delete [] block_[i];
+        }
+        NodePool::stats_.num_blocks -= block_.size();
+        block_.clear();
+        free_ = NULL;
+    }
+
+
+    template <typename T> void TypedNodePool<T>::AddBlock(void) {
+
+        Slot *block = new Slot[block_size_];
+        for (size_t j = 0; j < block_size_; j++) {
+            block[j].live = false;
+            block[j].next = (j + 1 < block_size_) ? &block[j + 1] : free_;
+        }
+        free_ = block;
+        block_.push_back(block);
+        NodePool::stats_.num_blocks++;
+        NodePool::stats_.num_block_allocations++;
+        RenderStats::AddPoolBlock();
+    }
+
+
+    template <typename T, typename... Args> T *NodePool::Create(Args&&... args) {
+
+        TypedNodePool<T> &pool = GetPool<T>();
+        T *node = pool.Allocate(std::forward<Args>(args)...);
+        static_cast<SceneNode *>(node)->pool_ = &pool;
+        stats_.num_created++;
+        stats_.num_live++;
+        if (stats_.num_live > stats_.peak_live) {
+            stats_.peak_live = stats_.num_live;
+        }
+        RenderStats::AddNodeCreated();
+        return node;
+    }
+
+
+    template <typename T> TypedNodePool<T> &NodePool::GetPool(void) {
+
+        // Made on first use and kept, so that Clear can reach it
+        static TypedNodePool<T> *pool = NULL;
+        if (pool == NULL) {
+            pool = new TypedNodePool<T>();
+            pool_.push_back(pool);
+        }
+        return *pool;
+    }
+
+} // namespace game
+
+#endif // NODE_POOL_H_
@@ -1,4 +1,5 @@
 #version 130
+#extension GL_ARB_uniform_buffer_object : require
 
 // Vertex buffer
 in vec3 vertex;
@@ -6,11 +7,21 @@ in vec3 normal;
 in vec3 color;
 in vec2 uv;
 
-// Uniform (global) buffer
-uniform mat4 world_mat;
-uniform mat4 view_mat;
-uniform mat4 projection_mat;
-uniform mat4 normal_mat;
+// Transforms of the node being drawn, from the per-draw ring buffer
+layout(std140) uniform PerDraw {
+    mat4 world_mat;
+    mat4 normal_mat;
+};
+
+// Per-frame data shared by all materials, filled once per frame
+layout(std140) uniform PerFrame {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 light_position;
+    vec4 light_color;
+    float timer;
+    int spec_power;
+};
 
 // Attributes forwarded to the fragment shader
 out vec3 vertex_position;
@@ -18,10 +29,6 @@ out vec2 vertex_uv;
 out mat3 TBN_mat;
 out vec3 light_pos;
 
-// Material attributes (constants)
-uniform vec3 light_position = vec3(0, 200, 800);
-
-
 void main()
 {
     gl_Position = projection_mat * view_mat * world_mat * vec4(vertex, 1.0);
@@ -40,7 +47,7 @@ void main()
     TBN_mat = transpose(mat3(vertex_tangent_ts, vertex_bitangent_ts, vertex_normal));
 
     // Transform light
-    light_pos = vec3(view_mat * vec4(light_position, 1.0));
+    light_pos = vec3(view_mat * vec4(light_position.xyz, 1.0));
 
     // Send texture coordinates
     vertex_uv = uv; 
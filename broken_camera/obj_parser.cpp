@@ -0,0 +1,327 @@
+#include <charconv>
+#include <cstring>
+#include <ios>
+#include <string>
+
+#include "model_loader.h"
+#include "mapped_file.h"
+
+namespace game {
+
+    // Helpers for tokenizing the mapped file in place. A token is a
+    // [begin, end) range of characters inside the mapping
+    namespace {
+
+        inline bool is_separator(char c) {
+
+            return (c == ' ') || (c == '\t') || (c == '\r');
+        }
+
+
+        // Find the next token in [p, end), advancing p past it
+        // Returns false when the line has no more tokens
+        inline bool next_token(const char *&p, const char *end, const char *&token, const char *&token_end) {
+
+            while ((p < end) && is_separator(*p)) {
+                p++;
+            }
+            if (p >= end) {
+                return false;
+            }
+            token = p;
+            while ((p < end) && !is_separator(*p)) {
+                p++;
+            }
+            token_end = p;
+            return true;
+        }
+
+
+        inline bool token_is(const char *token, const char *token_end, const char *keyword) {
+
+            size_t len = token_end - token;
+            return (strlen(keyword) == len) && (memcmp(token, keyword, len) == 0);
+        }
+
+
+        void invalid_number(const char *token, const char *token_end) {
+
+            throw(std::ios_base::failure(std::string("Invalid number: ") + std::string(token, token_end)));
+        }
+
+
+        inline float parse_float(const char *token, const char *token_end) {
+
+            // from_chars does not accept an explicit plus sign
+            if ((token < token_end) && (*token == '+')) {
+                token++;
+            }
+            float value = 0.0f;
+            std::from_chars_result res = std::from_chars(token, token_end, value);
+            if (res.ec != std::errc()) {
+                invalid_number(token, token_end);
+            }
+            return value;
+        }
+
+
+        // Convert a one-based (or negative, relative) OBJ index into a
+        // zero-based index
+        inline int parse_index(const char *token, const char *token_end, size_t count) {
+
+            if ((token < token_end) && (*token == '+')) {
+                token++;
+            }
+            int value = 0;
+            std::from_chars_result res = std::from_chars(token, token_end, value);
+            if (res.ec != std::errc()) {
+                invalid_number(token, token_end);
+            }
+            if (value < 0) {
+                return (int) count + value;
+            }
+            return value - 1;
+        }
+
+
+        // Parse one face corner of the form i, i/t, i//n or i/t/n
+        void parse_corner(const char *token, const char *token_end, const TriMesh &mesh, int &i, int &t, int &n) {
+
+            // Split the corner on single slashes
+            const char *field[3];
+            const char *field_end[3];
+            int num_fields = 0;
+            const char *p = token;
+            while (true) {
+                if (num_fields == 3) {
+                    throw(std::ios_base::failure(std::string("Error: f parameter should have 1, 2, or 3 parameters separated by '/'")));
+                }
+                const char *slash = (const char *) memchr(p, '/', token_end - p);
+                field[num_fields] = p;
+                field_end[num_fields] = slash ? slash : token_end;
+                num_fields++;
+                if (!slash) {
+                    break;
+                }
+                p = slash + 1;
+            }
+
+            i = parse_index(field[0], field_end[0], mesh.position.size());
+            t = -1;
+            n = -1;
+            if (num_fields == 2) {
+                t = parse_index(field[1], field_end[1], mesh.tex_coord.size());
+            }
+            else if (num_fields == 3) {
+                if (field[1] != field_end[1]) {
+                    t = parse_index(field[1], field_end[1], mesh.tex_coord.size());
+                }
+                n = parse_index(field[2], field_end[2], mesh.normal.size());
+            }
+        }
+
+
+        // Count the commands of each type so that the mesh arrays are
+        // allocated once
+        void reserve_mesh(const char *data, const char *end, TriMesh &mesh) {
+
+            size_t num_v = 0, num_vn = 0, num_vt = 0, num_f = 0;
+            const char *p = data;
+            while (p < end) {
+                const char *eol = (const char *) memchr(p, '\n', end - p);
+                if (!eol) {
+                    eol = end;
+                }
+                if ((eol - p >= 2) && (p[0] == 'v')) {
+                    if (is_separator(p[1])) {
+                        num_v++;
+                    }
+                    else if (p[1] == 'n') {
+                        num_vn++;
+                    }
+                    else if (p[1] == 't') {
+                        num_vt++;
+                    }
+                }
+                else if ((eol - p >= 2) && (p[0] == 'f') && is_separator(p[1])) {
+                    num_f++;
+                }
+                p = eol + 1;
+            }
+
+            mesh.position.reserve(num_v);
+            mesh.normal.reserve(num_vn);
+            mesh.tex_coord.reserve(num_vt);
+            mesh.face.reserve(num_f);
+        }
+
+    } // namespace
+
+
+    void load_obj(const char *filename, TriMesh &mesh) {
+
+        MappedFile file;
+        file.Open(filename);
+
+        const char *p = file.GetData();
+        const char *end = p + file.GetSize();
+
+        mesh = TriMesh();
+        reserve_mesh(p, end, mesh);
+
+        // Parse lines
+        const char *token, *token_end;
+        while (p < end) {
+            const char *eol = (const char *) memchr(p, '\n', end - p);
+            if (!eol) {
+                eol = end;
+            }
+            const char *cur = p;
+            p = eol + 1;
+
+            // Ignore empty lines and comments
+            if (!next_token(cur, eol, token, token_end) || (*token == '#')) {
+                continue;
+            }
+
+            // Check commands
+            if (token_is(token, token_end, "v")) {
+                float v[3];
+                for (int k = 0; k < 3; k++) {
+                    if (!next_token(cur, eol, token, token_end)) {
+                        throw(std::ios_base::failure(std::string("Error: v command should have exactly 3 parameters")));
+                    }
+                    v[k] = parse_float(token, token_end);
+                }
+                mesh.position.push_back(glm::vec3(v[0], v[1], v[2]));
+            }
+            else if (token_is(token, token_end, "vn")) {
+                float v[3];
+                for (int k = 0; k < 3; k++) {
+                    if (!next_token(cur, eol, token, token_end)) {
+                        throw(std::ios_base::failure(std::string("Error: vn command should have exactly 3 parameters")));
+                    }
+                    v[k] = parse_float(token, token_end);
+                }
+                mesh.normal.push_back(glm::vec3(v[0], v[1], v[2]));
+            }
+            else if (token_is(token, token_end, "vt")) {
+                float v[2];
+                for (int k = 0; k < 2; k++) {
+                    if (!next_token(cur, eol, token, token_end)) {
+                        throw(std::ios_base::failure(std::string("Error: vt command should have exactly 2 parameters")));
+                    }
+                    v[k] = parse_float(token, token_end);
+                }
+                mesh.tex_coord.push_back(glm::vec2(v[0], v[1]));
+            }
+            else if (token_is(token, token_end, "f")) {
+                // Collect the corners before parsing them, so that the
+                // number of vertices is checked first
+                const char *corner[5];
+                const char *corner_end[5];
+                int num_corners = 0;
+                while ((num_corners < 5) && next_token(cur, eol, corner[num_corners], corner_end[num_corners])) {
+                    num_corners++;
+                }
+                if (num_corners > 4) {
+                    throw(std::ios_base::failure(std::string("Error: f commands with more than 4 vertices not supported")));
+                }
+                if (num_corners < 3) {
+                    throw(std::ios_base::failure(std::string("Error: f command should have 3 or 4 parameters")));
+                }
+
+                Quad quad;
+                for (int k = 0; k < num_corners; k++) {
+                    parse_corner(corner[k], corner_end[k], mesh, quad.i[k], quad.t[k], quad.n[k]);
+                }
+
+                // Add the first triangle, and break a quad into two
+                Face face;
+                for (int k = 0; k < 3; k++) {
+                    face.i[k] = quad.i[k];
+                    face.n[k] = quad.n[k];
+                    face.t[k] = quad.t[k];
+                }
+                mesh.face.push_back(face);
+                if (num_corners == 4) {
+                    face.i[0] = quad.i[0]; face.i[1] = quad.i[2]; face.i[2] = quad.i[3];
+                    face.n[0] = quad.n[0]; face.n[1] = quad.n[2]; face.n[2] = quad.n[3];
+                    face.t[0] = quad.t[0]; face.t[1] = quad.t[2]; face.t[2] = quad.t[3];
+                    mesh.face.push_back(face);
+                }
+            }
+            // Ignore other commands
+        }
+
+        // Check that normal and texture references are correct; vertex
+        // references are checked by the caller
+        for (size_t i = 0; i < mesh.face.size(); i++) {
+            for (int j = 0; j < 3; j++) {
+                if ((mesh.face[i].n[j] >= (int) mesh.normal.size()) ||
+                    (mesh.face[i].t[j] >= (int) mesh.tex_coord.size())) {
+                    throw(std::ios_base::failure(std::string("Error: attribute index for triangle ") + num_to_str<size_t>(i) + std::string(" is out of bounds")));
+                }
+            }
+        }
+    }
+
+
+    bool compare_meshes(const TriMesh &a, const TriMesh &b, std::string &diff) {
+
+        // Both parsers round decimal numbers to the nearest float, so the
+        // values must match exactly
+        if (a.position.size() != b.position.size()) {
+            diff = "position count " + num_to_str<size_t>(a.position.size()) + " vs " + num_to_str<size_t>(b.position.size());
+            return false;
+        }
+        if (a.normal.size() != b.normal.size()) {
+            diff = "normal count " + num_to_str<size_t>(a.normal.size()) + " vs " + num_to_str<size_t>(b.normal.size());
+            return false;
+        }
+        if (a.tex_coord.size() != b.tex_coord.size()) {
+            diff = "texture coordinate count " + num_to_str<size_t>(a.tex_coord.size()) + " vs " + num_to_str<size_t>(b.tex_coord.size());
+            return false;
+        }
+        if (a.face.size() != b.face.size()) {
+            diff = "face count " + num_to_str<size_t>(a.face.size()) + " vs " + num_to_str<size_t>(b.face.size());
+            return false;
+        }
+        for (size_t i = 0; i < a.position.size(); i++) {
+            for (int k = 0; k < 3; k++) {
+                if (a.position[i][k] != b.position[i][k]) {
+                    diff = "position " + num_to_str<size_t>(i);
+                    return false;
+                }
+            }
+        }
+        for (size_t i = 0; i < a.normal.size(); i++) {
+            for (int k = 0; k < 3; k++) {
+                if (a.normal[i][k] != b.normal[i][k]) {
+                    diff = "normal " + num_to_str<size_t>(i);
+                    return false;
+                }
+            }
+        }
+        for (size_t i = 0; i < a.tex_coord.size(); i++) {
+            for (int k = 0; k < 2; k++) {
+                if (a.tex_coord[i][k] != b.tex_coord[i][k]) {
+                    diff = "texture coordinate " + num_to_str<size_t>(i);
+                    return false;
+                }
+            }
+        }
+        for (size_t i = 0; i < a.face.size(); i++) {
+            for (int k = 0; k < 3; k++) {
+                if ((a.face[i].i[k] != b.face[i].i[k]) ||
+                    (a.face[i].n[k] != b.face[i].n[k]) ||
+                    (a.face[i].t[k] != b.face[i].t[k])) {
+                    diff = "face " + num_to_str<size_t>(i);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+} // namespace game
@@ -0,0 +1,134 @@
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "program_cache.h"
+
+namespace game {
+
+    namespace {
+
+        const char program_cache_magic[4] = { 'P', 'R', 'G', 'C' };
+        const uint32_t program_cache_version = 1;
+
+
+        // 64-bit FNV-1a hash, continued from a previous value. The
+        // terminating null is hashed too, so that sources cannot run into
+        // each other
+        uint64_t hash_string(uint64_t hash, const char *str) {
+
+            const unsigned char *c = (const unsigned char *) (str ? str : "");
+            do {
+                hash ^= *c;
+                hash *= 1099511628211ULL;
+            } while (*c++);
+            return hash;
+        }
+
+    } // namespace
+
+
+    bool ProgramCache::IsSupported(void) {
+
+        if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary) {
+            return false;
+        }
+        GLint num_formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+        return num_formats > 0;
+    }
+
+
+    uint64_t ProgramCache::GetKey(const std::string &vp, const std::string &fp, const std::string &gp) {
+
+        uint64_t hash = 14695981039346656037ULL;
+        hash = hash_string(hash, vp.c_str());
+        hash = hash_string(hash, fp.c_str());
+        hash = hash_string(hash, gp.c_str());
+        hash = hash_string(hash, (const char *) glGetString(GL_VENDOR));
+        hash = hash_string(hash, (const char *) glGetString(GL_RENDERER));
+        hash = hash_string(hash, (const char *) glGetString(GL_VERSION));
+        return hash;
+    }
+
+
+    GLuint ProgramCache::Load(const char *prefix, uint64_t key) {
+
+        // A missing cache is not an error
+        std::ifstream f;
+        f.open(GetCacheFilename(prefix).c_str(), std::ios::in | std::ios::binary);
+        if (f.fail()) {
+            return 0;
+        }
+
+        ProgramCacheHeader header;
+        f.read((char *) &header, sizeof(header));
+        if (f.fail() ||
+            (memcmp(header.magic, program_cache_magic, sizeof(program_cache_magic)) != 0) ||
+            (header.version != program_cache_version) ||
+            (header.key != key) ||
+            (header.binary_bytes == 0)) {
+            return 0;
+        }
+        std::vector<char> binary(header.binary_bytes);
+        f.read(binary.data(), binary.size());
+        if (f.fail()) {
+            return 0;
+        }
+
+        // The driver may still refuse the binary, for instance after an
+        // update that kept the version string
+        GLuint program = glCreateProgram();
+        glProgramBinary(program, header.binary_format, binary.data(), (GLsizei) binary.size());
+        GLint status;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        if (status != GL_TRUE) {
+            glDeleteProgram(program);
+            return 0;
+        }
+        return program;
+    }
+
+
+    bool ProgramCache::Write(const char *prefix, uint64_t key, GLuint program) {
+
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) {
+            return false;
+        }
+        std::vector<char> binary(length);
+        GLenum format;
+        glGetProgramBinary(program, length, &length, &format, binary.data());
+        if (length <= 0) {
+            return false;
+        }
+
+        ProgramCacheHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, program_cache_magic, sizeof(program_cache_magic));
+        header.version = program_cache_version;
+        header.key = key;
+        header.binary_format = format;
+        header.binary_bytes = (uint32_t) length;
+
+        std::ofstream f;
+        f.open(GetCacheFilename(prefix).c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (f.fail()) {
+            return false;
+        }
+        f.write((const char *) &header, sizeof(header));
+        f.write(binary.data(), length);
+        f.close();
+
+        // A partial file fails to read when it is loaded
+        return !f.fail();
+    }
+
+
+    std::string ProgramCache::GetCacheFilename(const char *prefix) {
+
+        return std::string(prefix) + std::string(PROGRAM_CACHE_EXTENSION);
+    }
+
+} // namespace game
@@ -0,0 +1,54 @@
+#ifndef PROGRAM_CACHE_H_
+#define PROGRAM_CACHE_H_
+
+#include <string>
+#include <cstdint>
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+// Extension added to the prefix of a material to get the name of its cache
+#define PROGRAM_CACHE_EXTENSION ".progcache"
+
+namespace game {
+
+    // Header at the start of a program cache file. The binary returned by
+    // glGetProgramBinary follows the header
+    struct ProgramCacheHeader {
+        char magic[4]; // "PRGC"
+        uint32_t version; // Bumped whenever the layout changes
+        uint64_t key; // Hash of the shader sources and of the driver
+        uint32_t binary_format; // Format reported by the driver
+        uint32_t binary_bytes;
+    };
+
+    // Linked shader programs saved in the format of the driver, stored next
+    // to the shader files they were built from. A binary only works with
+    // the driver that made it, so the key covers the vendor, renderer and
+    // version strings along with the sources
+    class ProgramCache {
+
+        public:
+            // Check if the driver can save and load program binaries
+            static bool IsSupported(void);
+
+            // Hash the sources of a program with the strings of the current
+            // driver. Must be called with an OpenGL context
+            static uint64_t GetKey(const std::string &vp, const std::string &fp, const std::string &gp);
+
+            // Create a program from the cache of a material. Returns 0 if
+            // the cache is missing, was made from other sources or by
+            // another driver, or if the driver rejects the binary
+            static GLuint Load(const char *prefix, uint64_t key);
+
+            // Save a linked program. The program must have been linked with
+            // GL_PROGRAM_BINARY_RETRIEVABLE_HINT set. Returns false if the
+            // cache could not be written, which only means the program is
+            // compiled again next run
+            static bool Write(const char *prefix, uint64_t key, GLuint program);
+            static std::string GetCacheFilename(const char *prefix);
+
+    }; // class ProgramCache
+
+} // namespace game
+
+#endif // PROGRAM_CACHE_H_
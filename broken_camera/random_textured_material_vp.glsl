@@ -6,11 +6,20 @@ in vec3 normal;
 in vec3 color;
 in vec2 uv;
 
-// Uniform (global) buffer
-uniform mat4 world_mat;
-uniform mat4 view_mat;
-uniform mat4 projection_mat;
-uniform mat4 normal_mat;
+// Transforms of the node being drawn, one per instance, read from the
+// draw ring
+in mat4 world_mat;
+in mat4 normal_mat;
+
+// Per-frame data shared by all materials, filled once per frame
+layout(std140) uniform PerFrame {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 light_position;
+    vec4 light_color;
+    float timer;
+    int spec_power;
+};
 
 // Attributes forwarded to the fragment shader
 out vec3 position_interp;
@@ -19,10 +28,6 @@ out vec4 color_interp;
 out vec2 uv_interp;
 out vec3 light_pos;
 
-// Material attributes (constants)
-uniform vec3 light_position = vec3(-0.5, -0.5, 1.5);
-
-
 void main()
 {
     gl_Position = projection_mat * view_mat * world_mat * vec4(vertex, 1.0);
@@ -35,5 +40,5 @@ void main()
 
     uv_interp = uv;
 
-    light_pos = vec3(view_mat * vec4(light_position, 1.0));
+    light_pos = vec3(view_mat * vec4(light_position.xyz, 1.0));
 }
@@ -0,0 +1,162 @@
+#include <cstring>
+
+#include "render_queue.h"
+#include "render_stats.h"
+#include "gl_state.h"
+
+namespace game {
+
+    RenderQueue::RenderQueue(void) {
+    }
+
+
+    void RenderQueue::Clear(void) {
+
+        item_.clear();
+    }
+
+
+    void RenderQueue::Add(SceneNode *node, Camera *camera, const Frustum &frustum, RenderPass pass) {
+
+        // The bounds of a node hold those of its children, so a node
+        // outside the frustum is skipped with all of them
+        if (!frustum.Intersects(node->GetSubtreeBounds())) {
+            RenderStats::AddCulledNodes(node->GetSubtreeSize());
+            return;
+        }
+
+        // Children may still be in view when their parent is not
+        if (frustum.Intersects(node->GetBounds())) {
+            glm::vec3 position = glm::vec3(node->GetTransf()[3]);
+            DrawItem item;
+            item.key = MakeKey(node, pass, glm::length(position - camera->GetPosition()));
+            item.node = node;
+            item_.push_back(item);
+            RenderStats::AddVisibleNode();
+        }
+        else {
+            RenderStats::AddCulledNodes(1);
+        }
+
+        const std::vector<SceneNode *> &children = node->GetChildren();
+        for (int i = 0; i < children.size(); i++) {
+            Add(children[i], camera, frustum, pass);
+        }
+    }
+
+
+    uint64_t RenderQueue::MakeKey(const SceneNode *node, RenderPass pass, float distance) {
+
+        // The bits of a positive float sort like its value; the top 24
+        // bits after the sign keep the exponent and most of the mantissa
+        GLuint bits;
+        distance = (distance > 0.0f) ? distance : 0.0f;
+        memcpy(&bits, &distance, sizeof(bits));
+        uint64_t depth = (bits >> 7) & 0xFFFFFF;
+
+        // Object names are small integers, so their low bits identify them.
+        // Meshes in a pool share buffers and differ by base vertex. Two
+        // that share the bits only cost a bind that is not skipped
+        uint64_t program = node->GetMaterial() & 0xFFF;
+        uint64_t texture = node->GetTexture() & 0xFFF;
+        uint64_t mesh = (node->GetArrayBuffer() * 31 + node->GetBaseVertex()) & 0xFFF;
+        uint64_t cull = node->GetCullFace() ? 1 : 0;
+
+        uint64_t key = (uint64_t) pass << 62;
+        if (pass == BlendedPass) {
+            key |= (0xFFFFFF - depth) << 38;
+            key |= program << 26;
+            key |= texture << 14;
+            key |= mesh << 2;
+        }
+        else {
+            key |= cull << 61;
+            key |= program << 49;
+            key |= texture << 37;
+            key |= mesh << 25;
+            key |= depth << 1;
+        }
+        return key;
+    }
+
+
+    void RenderQueue::Sort(void) {
+
+        // Least significant digit radix sort on bytes of the key. Passes
+        // where all keys have the same byte are skipped, which is most of
+        // them with the few materials and textures of a scene
+        scratch_.resize(item_.size());
+        for (int shift = 0; shift < 64; shift += 8) {
+            size_t count[256] = { 0 };
+            for (size_t i = 0; i < item_.size(); i++) {
+                count[(item_[i].key >> shift) & 0xFF]++;
+            }
+            if ((item_.size() == 0) || (count[(item_[0].key >> shift) & 0xFF] == item_.size())) {
+                continue;
+            }
+            size_t offset = 0;
+            for (int b = 0; b < 256; b++) {
+                size_t c = count[b];
+                count[b] = offset;
+                offset += c;
+            }
+            for (size_t i = 0; i < item_.size(); i++) {
+                scratch_[count[(item_[i].key >> shift) & 0xFF]++] = item_[i];
+            }
+            item_.swap(scratch_);
+        }
+    }
+
+
+    void RenderQueue::Submit(Camera *camera) {
+
+        size_t i = 0;
+        while (i < item_.size()) {
+            SceneNode *node = item_[i].node;
+            if (!node->CanBatchWith(node)) {
+                node->Submit(camera);
+                i++;
+                continue;
+            }
+
+            // Nodes that share program, buffers and textures are next to
+            // each other after the sort. Each mesh and level of detail is a
+            // command; instanced nodes of the mesh add instances to it
+            instance_.clear();
+            command_.clear();
+            SceneNode *last = NULL;
+            int last_lod = -1;
+            size_t j = i;
+            while ((j < item_.size()) && (instance_.size() < max_draw_instances) && node->CanBatchWith(item_[j].node)) {
+                SceneNode *other = item_[j].node;
+                int lod = other->SelectLod(camera);
+                if (last && (lod == last_lod) && last->CanInstanceWith(other)) {
+                    command_.back().instance_count++;
+                }
+                else {
+                    DrawElementsCommand command;
+                    other->GetDrawCommand(lod, &command);
+                    command.base_instance = (GLuint) instance_.size();
+                    command_.push_back(command);
+                }
+                instance_.resize(instance_.size() + 1);
+                other->GetDrawUniforms(&instance_.back());
+                last = other;
+                last_lod = lod;
+                j++;
+            }
+            node->SubmitCommands(instance_.data(), (GLuint) instance_.size(), command_.data(), (GLuint) command_.size());
+            i = j;
+        }
+
+        // Buffers bound elsewhere must not change the vertex array
+        GLState::BindVertexArray(0);
+    }
+
+
+    size_t RenderQueue::GetSize(void) const {
+
+        return item_.size();
+    }
+
+} // namespace game
@@ -0,0 +1,64 @@
+#ifndef RENDER_QUEUE_H_
+#define RENDER_QUEUE_H_
+
+#include <vector>
+#include <stdint.h>
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "scene_node.h"
+#include "camera.h"
+#include "draw_ring.h"
+#include "frustum.h"
+
+namespace game {
+
+    // Passes of the render queue, drawn in this order. Opaque items are
+    // grouped by state and then drawn front to back; blended items are
+    // drawn back to front
+    typedef enum { OpaquePass, BlendedPass } RenderPass;
+
+    // One node to draw, with the key it is sorted on
+    typedef struct {
+        uint64_t key;
+        SceneNode *node;
+    } DrawItem;
+
+    // Nodes of one pass, flattened out of the scene hierarchy and sorted
+    // to minimize state changes. Keys pack, from the most significant
+    // bits: pass, face culling, program, texture and mesh, then the
+    // distance to the camera. Blended items put the distance, reversed,
+    // right after the pass so that the order is correct before it is cheap
+    class RenderQueue {
+
+        public:
+            RenderQueue(void);
+
+            // Remove all items; the memory is kept for the next frame
+            void Clear(void);
+            // Add a node and all its children that are in the frustum. The
+            // bounds of the nodes must be up to date
+            void Add(SceneNode *node, Camera *camera, const Frustum &frustum, RenderPass pass);
+            // Sort the items on their keys
+            void Sort(void);
+            // Draw the items in order. Runs of nodes that share their
+            // program, buffers and textures are drawn with one indirect
+            // call, and instanced nodes of one mesh with one command
+            void Submit(Camera *camera);
+            // Number of items in the queue
+            size_t GetSize(void) const;
+
+        private:
+            std::vector<DrawItem> item_;
+            std::vector<DrawItem> scratch_; // Second buffer of the radix sort
+            std::vector<DrawUniforms> instance_; // Transforms of one batch
+            std::vector<DrawElementsCommand> command_; // Commands of one batch
+
+            // Key of a node drawn at some distance from the camera
+            static uint64_t MakeKey(const SceneNode *node, RenderPass pass, float distance);
+
+    }; // class RenderQueue
+
+} // namespace game
+
+#endif // RENDER_QUEUE_H_
@@ -0,0 +1,265 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#include "render_stats.h"
+
+#if defined(TRACK_HEAP_ALLOCATIONS)
+// Count every allocation of the program, to check that frames make none
+static std::atomic<unsigned long> num_heap_allocations(0);
+
+
+void *operator new(std::size_t size) {
+
+    num_heap_allocations++;
+    void *p = std::malloc((size > 0) ? size : 1);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+
+void operator delete(void *p) noexcept {
+
+    std::free(p);
+}
+
+
+void operator delete(void *p, std::size_t) noexcept {
+
+    std::free(p);
+}
+
+
+static unsigned long get_heap_allocations(void) {
+
+    return num_heap_allocations.load();
+}
+#else
+static unsigned long get_heap_allocations(void) {
+
+    return 0;
+}
+#endif
+
+namespace game {
+
+    FrameStats RenderStats::current_ = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0.0f, 0.0f };
+    FrameStats RenderStats::last_ = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0.0f, 0.0f };
+    GLuint RenderStats::query_[RenderStats::num_queries_] = { 0 };
+    bool RenderStats::query_used_[RenderStats::num_queries_] = { false };
+    int RenderStats::query_index_ = 0;
+    bool RenderStats::timing_ = false;
+    std::chrono::steady_clock::time_point RenderStats::frame_start_;
+    float RenderStats::gpu_ms_ = 0.0f;
+    double RenderStats::total_frame_ms_ = 0.0;
+    double RenderStats::total_gpu_ms_ = 0.0;
+    unsigned int RenderStats::num_frames_ = 0;
+    unsigned int RenderStats::num_gpu_frames_ = 0;
+    unsigned long RenderStats::heap_allocations_ = 0;
+
+
+    void RenderStats::AddDraw(GLenum mode, GLsizei count) {
+
+        current_.draw_calls++;
+        if (mode == GL_TRIANGLES) {
+            current_.triangles += count / 3;
+        }
+        else if (mode == GL_POINTS) {
+            current_.points += count;
+        }
+    }
+
+
+    void RenderStats::AddGLCall(void) {
+
+        current_.gl_calls++;
+    }
+
+
+    void RenderStats::AddRingWrite(unsigned int bytes) {
+
+        current_.ring_bytes += bytes;
+    }
+
+
+    void RenderStats::AddRingWait(void) {
+
+        current_.ring_waits++;
+    }
+
+
+    void RenderStats::AddProgramBind(void) {
+
+        current_.program_binds++;
+    }
+
+
+    void RenderStats::AddVertexArrayBind(void) {
+
+        current_.vertex_array_binds++;
+    }
+
+
+    void RenderStats::AddTextureBind(void) {
+
+        current_.texture_binds++;
+    }
+
+
+    void RenderStats::AddElidedCall(void) {
+
+        current_.elided_calls++;
+    }
+
+
+    void RenderStats::AddVisibleNode(void) {
+
+        current_.visible_nodes++;
+    }
+
+
+    void RenderStats::AddCulledNodes(unsigned int count) {
+
+        current_.culled_nodes += count;
+    }
+
+
+    void RenderStats::AddNodeCreated(void) {
+
+        current_.nodes_created++;
+    }
+
+
+    void RenderStats::AddPoolBlock(void) {
+
+        current_.pool_blocks++;
+    }
+
+
+    void RenderStats::BeginFrame(void) {
+
+        if (timing_) {
+            return;
+        }
+        timing_ = true;
+        frame_start_ = std::chrono::steady_clock::now();
+
+        if (!(GLEW_VERSION_3_3 || GLEW_ARB_timer_query)) {
+            return;
+        }
+        if (query_[0] == 0) {
+            glGenQueries(num_queries_, query_);
+        }
+
+        // The query was last used num_queries_ frames ago. If the GPU is
+        // even further behind, that result is dropped
+        GLuint query = query_[query_index_];
+        if (query_used_[query_index_]) {
+            GLint available = 0;
+            glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint64 elapsed = 0;
+                glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+                gpu_ms_ = (float) (elapsed / 1.0e6);
+                total_gpu_ms_ += gpu_ms_;
+                num_gpu_frames_++;
+            }
+        }
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        query_used_[query_index_] = true;
+    }
+
+
+    void RenderStats::EndFrame(void) {
+
+        if (timing_) {
+            if (query_[0] != 0) {
+                glEndQuery(GL_TIME_ELAPSED);
+                query_index_ = (query_index_ + 1) % num_queries_;
+            }
+            current_.frame_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frame_start_).count();
+            current_.gpu_ms = gpu_ms_;
+            total_frame_ms_ += current_.frame_ms;
+            num_frames_++;
+            timing_ = false;
+        }
+
+        unsigned long heap_allocations = get_heap_allocations();
+        current_.heap_allocations = (unsigned int) (heap_allocations - heap_allocations_);
+        heap_allocations_ = heap_allocations;
+
+        last_ = current_;
+        current_.draw_calls = 0;
+        current_.triangles = 0;
+        current_.points = 0;
+        current_.gl_calls = 0;
+        current_.ring_bytes = 0;
+        current_.ring_waits = 0;
+        current_.program_binds = 0;
+        current_.vertex_array_binds = 0;
+        current_.texture_binds = 0;
+        current_.elided_calls = 0;
+        current_.visible_nodes = 0;
+        current_.culled_nodes = 0;
+        current_.nodes_created = 0;
+        current_.pool_blocks = 0;
+        current_.heap_allocations = 0;
+        current_.frame_ms = 0.0f;
+        current_.gpu_ms = 0.0f;
+    }
+
+
+    const FrameStats &RenderStats::GetLastFrame(void) {
+
+        return last_;
+    }
+
+
+    void RenderStats::Print(void) {
+
+        std::cout << "Frame: " << last_.draw_calls << " draw calls, " <<
+            last_.triangles << " triangles, " << last_.points << " points, " <<
+            last_.gl_calls << " GL calls, " << last_.ring_bytes << " bytes to the draw ring, " <<
+            last_.ring_waits << " draw ring waits" << std::endl;
+        std::cout << "State changes: " << last_.program_binds << " programs, " <<
+            last_.vertex_array_binds << " vertex arrays, " << last_.texture_binds << " textures, " <<
+            last_.elided_calls << " redundant calls skipped" << std::endl;
+        std::cout << "Culling: " << last_.visible_nodes << " nodes drawn, " << last_.culled_nodes << " culled" << std::endl;
+        std::cout << "Allocations: " << last_.nodes_created << " scene nodes, " << last_.pool_blocks << " pool blocks";
+#if defined(TRACK_HEAP_ALLOCATIONS)
+        std::cout << ", " << last_.heap_allocations << " heap allocations";
+#endif
+        std::cout << std::endl;
+
+        // Averages over the frames since the last print, so that two
+        // prints bracket a capture
+        std::cout << "Frame time: " << last_.frame_ms << " ms CPU, " << last_.gpu_ms << " ms GPU; average of " <<
+            num_frames_ << " frames " << ((num_frames_ > 0) ? total_frame_ms_ / num_frames_ : 0.0) << " ms CPU, " <<
+            ((num_gpu_frames_ > 0) ? total_gpu_ms_ / num_gpu_frames_ : 0.0) << " ms GPU" << std::endl;
+        total_frame_ms_ = 0.0;
+        total_gpu_ms_ = 0.0;
+        num_frames_ = 0;
+        num_gpu_frames_ = 0;
+    }
+
+
+    void RenderStats::Clear(void) {
+
+        if (query_[0] != 0) {
+            if (timing_) {
+                glEndQuery(GL_TIME_ELAPSED);
+            }
+            glDeleteQueries(num_queries_, query_);
+        }
+        for (int i = 0; i < num_queries_; i++) {
+            query_[i] = 0;
+            query_used_[i] = false;
+        }
+        query_index_ = 0;
+        timing_ = false;
+    }
+
+} // namespace game
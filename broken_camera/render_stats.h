@@ -0,0 +1,97 @@
+#ifndef RENDER_STATS_H_
+#define RENDER_STATS_H_
+
+#include <chrono>
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+// Count an OpenGL call on the draw path, then make it
+#define GL_COUNT(call) (RenderStats::AddGLCall(), call)
+
+namespace game {
+
+    // Work submitted to OpenGL in one frame
+    struct FrameStats {
+        unsigned int draw_calls;
+        unsigned int triangles;
+        unsigned int points;
+        unsigned int gl_calls; // OpenGL calls made while drawing nodes
+        unsigned int ring_bytes; // Per-draw data written to the draw ring
+        unsigned int ring_waits; // Times the draw ring waited for the GPU
+        unsigned int program_binds; // State changes between draws
+        unsigned int vertex_array_binds;
+        unsigned int texture_binds;
+        unsigned int elided_calls; // State changes skipped by GLState
+        unsigned int visible_nodes; // Nodes queued to draw after culling
+        unsigned int culled_nodes; // Nodes outside the view frustum
+        unsigned int nodes_created; // Scene nodes taken from the node pools
+        unsigned int pool_blocks; // Blocks the node pools allocated
+        unsigned int heap_allocations; // With TRACK_HEAP_ALLOCATIONS only
+        float frame_ms; // From BeginFrame to EndFrame, on the CPU
+        float gpu_ms; // Of a frame a few frames back, or 0 if not known
+    };
+
+    // Counts the draw calls of each frame. Draws are only issued from the
+    // main thread, so the counters are not synchronized
+    class RenderStats {
+
+        public:
+            // Count one draw call of count vertices in the given mode
+            static void AddDraw(GLenum mode, GLsizei count);
+            // Count one OpenGL call; see GL_COUNT
+            static void AddGLCall(void);
+            // Count bytes written to the draw ring, and waits on the GPU
+            // before the ring could be written
+            static void AddRingWrite(unsigned int bytes);
+            static void AddRingWait(void);
+            // Count changes of program, vertex array and texture
+            static void AddProgramBind(void);
+            static void AddVertexArrayBind(void);
+            static void AddTextureBind(void);
+            // Count a state change that was already set
+            static void AddElidedCall(void);
+            // Count nodes that passed or failed frustum culling
+            static void AddVisibleNode(void);
+            static void AddCulledNodes(unsigned int count);
+            // Count scene nodes created, and blocks allocated for them
+            static void AddNodeCreated(void);
+            static void AddPoolBlock(void);
+            // Start timing a frame. The GPU time is measured with a timer
+            // query and read a few frames later, once it is available, so
+            // that the CPU never waits for it. Nothing happens if a frame is
+            // already being timed
+            static void BeginFrame(void);
+            // Finish the current frame and start counting the next. The
+            // allocations of a frame are those since the last EndFrame,
+            // so they include the updates before BeginFrame
+            static void EndFrame(void);
+            // Counters of the last finished frame
+            static const FrameStats &GetLastFrame(void);
+            // Print the counters of the last finished frame, and the
+            // average frame times since the last print
+            static void Print(void);
+            // Delete the timer queries
+            static void Clear(void);
+
+        private:
+            static FrameStats current_;
+            static FrameStats last_;
+
+            static const int num_queries_ = 3; // Frames timed at once
+            static GLuint query_[num_queries_];
+            static bool query_used_[num_queries_]; // Has a result to read
+            static int query_index_; // Query of the current frame
+            static bool timing_; // Whether a frame is being timed
+            static std::chrono::steady_clock::time_point frame_start_;
+            static float gpu_ms_; // Last GPU time read
+            static double total_frame_ms_; // Sums since the last print
+            static double total_gpu_ms_;
+            static unsigned int num_frames_;
+            static unsigned int num_gpu_frames_;
+            static unsigned long heap_allocations_; // At the last EndFrame
+
+    }; // class RenderStats
+
+} // namespace game
+
+#endif // RENDER_STATS_H_
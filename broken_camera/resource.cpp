@@ -4,11 +4,59 @@
 
 namespace game {
 
+const char *program_uniform_name[num_program_uniforms] = {
+    "projection_mat",
+    "texture_map", "normal_map", "timer",
+    "num_collected", "progress"
+};
+
+const char *program_attrib_name[num_program_attribs] = {
+    "vertex", "normal", "color", "uv", "position",
+    "world_mat", "normal_mat"
+};
+
+
+VertexLayout float_vertex_layout(void){
+
+    VertexLayout layout;
+    layout.stride = 11 * sizeof(GLfloat);
+    layout.position = { 3, GL_FLOAT, GL_FALSE, 0 };
+    layout.normal = { 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat) };
+    layout.color = { 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat) };
+    layout.uv = { 2, GL_FLOAT, GL_FALSE, 9 * sizeof(GLfloat) };
+    layout.index_type = GL_UNSIGNED_INT;
+    layout.position_offset = glm::vec3(0.0);
+    layout.position_scale = glm::vec3(1.0);
+    return layout;
+}
+
+
 Resource::Resource(ResourceType type, std::string name, GLuint resource, GLsizei size){
     type_ = type;
     name_ = name;
     resource_ = resource;
     size_ = size;
+    bounds_min_ = glm::vec3(0.0);
+    bounds_max_ = glm::vec3(0.0);
+    layout_ = float_vertex_layout();
+    vertex_format_ = FloatVertexFormat;
+    SetLods(NULL, 0);
+    range_.base_vertex = 0;
+    range_.num_vertices = 0;
+    range_.first_index = 0;
+    range_.num_indices = 0;
+    target_ = GL_TEXTURE_2D;
+    layer_ = -1;
+    for (int i = 0; i < num_program_uniforms; i++){
+        locations_.uniform[i] = -1;
+    }
+    for (int i = 0; i < num_program_attribs; i++){
+        locations_.attrib[i] = -1;
+    }
+    ref_count_ = 0;
+    bytes_ = 0;
+    resident_ = true;
+    last_use_ = 0;
 }
 
 
@@ -18,6 +66,27 @@ Resource::Resource(ResourceType type, std::string name, GLuint array_buffer, GLu
     array_buffer_ = array_buffer;
     element_array_buffer_ = element_array_buffer;
     size_ = size;
+    bounds_min_ = glm::vec3(0.0);
+    bounds_max_ = glm::vec3(0.0);
+    layout_ = float_vertex_layout();
+    vertex_format_ = FloatVertexFormat;
+    SetLods(NULL, 0);
+    range_.base_vertex = 0;
+    range_.num_vertices = 0;
+    range_.first_index = 0;
+    range_.num_indices = 0;
+    target_ = GL_TEXTURE_2D;
+    layer_ = -1;
+    for (int i = 0; i < num_program_uniforms; i++){
+        locations_.uniform[i] = -1;
+    }
+    for (int i = 0; i < num_program_attribs; i++){
+        locations_.attrib[i] = -1;
+    }
+    ref_count_ = 0;
+    bytes_ = 0;
+    resident_ = true;
+    last_use_ = 0;
 }
 
 
@@ -61,4 +130,201 @@ GLsizei Resource::GetSize(void) const {
     return size_;
 }
 
+
+const glm::vec3 &Resource::GetBoundsMin(void) const {
+
+    return bounds_min_;
+}
+
+
+const glm::vec3 &Resource::GetBoundsMax(void) const {
+
+    return bounds_max_;
+}
+
+
+void Resource::SetBounds(const glm::vec3 &bounds_min, const glm::vec3 &bounds_max){
+
+    bounds_min_ = bounds_min;
+    bounds_max_ = bounds_max;
+}
+
+
+const VertexLayout &Resource::GetLayout(void) const {
+
+    return layout_;
+}
+
+
+void Resource::SetLayout(const VertexLayout &layout){
+
+    layout_ = layout;
+}
+
+
+VertexFormat Resource::GetVertexFormat(void) const {
+
+    return vertex_format_;
+}
+
+
+void Resource::SetVertexFormat(VertexFormat format){
+
+    vertex_format_ = format;
+}
+
+
+int Resource::GetNumLods(void) const {
+
+    return num_lods_;
+}
+
+
+const MeshLod &Resource::GetLod(int level) const {
+
+    return lod_[level];
+}
+
+
+void Resource::SetLods(const MeshLod *lod, int num_lods){
+
+    // Without levels, the whole index buffer is the only level
+    if (num_lods <= 0){
+        lod_[0].first_index = 0;
+        lod_[0].num_indices = size_;
+        lod_[0].error = 0.0f;
+        num_lods_ = 1;
+        return;
+    }
+    num_lods_ = (num_lods < mesh_max_lods) ? num_lods : mesh_max_lods;
+    for (int i = 0; i < num_lods_; i++){
+        lod_[i] = lod[i];
+    }
+}
+
+
+const GeometryRange &Resource::GetRange(void) const {
+
+    return range_;
+}
+
+
+void Resource::SetRange(const GeometryRange &range){
+
+    range_ = range;
+}
+
+
+GLenum Resource::GetTarget(void) const {
+
+    return target_;
+}
+
+
+GLint Resource::GetLayer(void) const {
+
+    return layer_;
+}
+
+
+void Resource::SetTarget(GLenum target, GLint layer){
+
+    target_ = target;
+    layer_ = layer;
+}
+
+
+const ProgramLocations &Resource::GetLocations(void) const {
+
+    return locations_;
+}
+
+
+void Resource::SetLocations(const ProgramLocations &locations){
+
+    locations_ = locations;
+}
+
+
+void Resource::AddRef(void) const {
+
+    ref_count_++;
+}
+
+
+void Resource::Release(void) const {
+
+    if (ref_count_ > 0){
+        ref_count_--;
+    }
+}
+
+
+int Resource::GetRefCount(void) const {
+
+    return ref_count_;
+}
+
+
+const std::string &Resource::GetSource(void) const {
+
+    return source_;
+}
+
+
+void Resource::SetSource(const std::string &source){
+
+    source_ = source;
+}
+
+
+size_t Resource::GetBytes(void) const {
+
+    return bytes_;
+}
+
+
+void Resource::SetBytes(size_t bytes){
+
+    bytes_ = bytes;
+}
+
+
+bool Resource::IsResident(void) const {
+
+    return resident_;
+}
+
+
+void Resource::SetResident(bool resident){
+
+    resident_ = resident;
+}
+
+
+unsigned long Resource::GetLastUse(void) const {
+
+    return last_use_;
+}
+
+
+void Resource::SetLastUse(unsigned long time){
+
+    last_use_ = time;
+}
+
+
+void Resource::SetResource(GLuint resource){
+
+    resource_ = resource;
+}
+
+
+void Resource::SetBuffers(GLuint array_buffer, GLuint element_array_buffer, GLsizei size){
+
+    array_buffer_ = array_buffer;
+    element_array_buffer_ = element_array_buffer;
+    size_ = size;
+}
+
 } // namespace game
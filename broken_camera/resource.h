@@ -5,11 +5,13 @@
 #define GLEW_STATIC
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
 
 namespace game {
 
     // Possible resource types
     typedef enum Type { Material, PointSet, Mesh, Texture} ResourceType;
+    const int num_resource_types = 4;
 
     typedef struct {
         unsigned char* hmap;
@@ -18,6 +20,92 @@ namespace game {
         float max_height;
     } HeightMap;
 
+    // Storage of one vertex attribute in an array buffer
+    typedef struct {
+        GLint size; // Number of components
+        GLenum type;
+        GLboolean normalized;
+        GLuint offset; // Bytes from the start of the vertex
+    } VertexAttrib;
+
+    // Ways of storing the vertices of loaded geometry
+    typedef enum VertexFormat {
+        // 11 floats per vertex and 32-bit indices
+        FloatVertexFormat,
+        // Meshes: snorm16 positions relative to the bounds, 10-bit signed
+        // normals and tangents, 16-bit texture coordinates and 16-bit
+        // indices when possible. Point sets: half floats
+        PackedVertexFormat
+    } VertexFormat;
+
+    // How the vertices and indices of a geometry are stored. Positions may
+    // be quantized; they are mapped back to model space by
+    // position_offset + position * position_scale
+    typedef struct {
+        GLsizei stride;
+        VertexAttrib position;
+        VertexAttrib normal;
+        VertexAttrib color; // Holds tangents for normal-mapped geometry
+        VertexAttrib uv;
+        GLenum index_type;
+        glm::vec3 position_offset;
+        glm::vec3 position_scale;
+    } VertexLayout;
+
+    // Layout of the 11-float vertices: position (3), normal (3), color (3)
+    // and texture coordinates (2), with 32-bit indices
+    VertexLayout float_vertex_layout(void);
+
+    // Most levels of detail stored for one mesh
+    const int mesh_max_lods = 4;
+
+    // One level of detail of a mesh: a range of its index buffer, and how
+    // far (in model units) its surface may be from the full mesh
+    typedef struct {
+        GLuint first_index;
+        GLsizei num_indices;
+        float error;
+    } MeshLod;
+
+    // Where the vertices and indices of a mesh are in its buffers. Meshes
+    // in a shared pool start at a base vertex and first index; meshes with
+    // buffers of their own start at 0
+    typedef struct {
+        GLint base_vertex;
+        GLuint num_vertices;
+        GLuint first_index;
+        GLuint num_indices;
+    } GeometryRange;
+
+    // Uniforms and attributes that the game sets in its shader programs.
+    // Data shared by all materials is in the PerFrame uniform block, and
+    // the transforms of each node in the PerDraw block, instead. Programs
+    // that can draw instances read the transforms as attributes
+    typedef enum {
+        ProjectionMatUniform,
+        TextureMapUniform, NormalMapUniform, TimerUniform,
+        NumCollectedUniform, ProgressUniform, num_program_uniforms
+    } ProgramUniform;
+    typedef enum {
+        VertexAttribute, NormalAttribute, ColorAttribute, UvAttribute, PositionAttribute,
+        WorldMatAttribute, NormalMatAttribute, num_program_attribs
+    } ProgramAttrib;
+
+    // Locations of the uniforms and attributes of a shader program, found
+    // once when the program is loaded. Inputs that the program does not use
+    // are at location -1
+    typedef struct {
+        GLint uniform[num_program_uniforms];
+        GLint attrib[num_program_attribs];
+    } ProgramLocations;
+
+    // Binding point of the PerFrame uniform block that all materials share
+    const GLuint frame_uniforms_binding = 0;
+
+    // Names of the uniforms and attributes in the shader sources
+    extern const char *program_uniform_name[num_program_uniforms];
+    extern const char *program_attrib_name[num_program_attribs];
+
     // Class that holds one resource
     class Resource {
 
@@ -34,6 +122,21 @@ namespace game {
                 };
             };
             GLsizei size_; // Number of primitives in geometry
+            glm::vec3 bounds_min_; // Bounding box of geometry, in model space
+            glm::vec3 bounds_max_;
+            VertexLayout layout_; // Layout of geometry
+            VertexFormat vertex_format_; // Format the geometry was loaded in
+            MeshLod lod_[mesh_max_lods]; // Levels of detail, finest first
+            int num_lods_;
+            GeometryRange range_; // Part of the buffers that holds the mesh
+            GLenum target_; // Texture target
+            GLint layer_; // Layer of a texture array, or -1
+            ProgramLocations locations_; // Inputs of a material
+            mutable int ref_count_; // Number of scene nodes using the resource
+            std::string source_; // File to reload from after eviction, if any
+            size_t bytes_; // GPU memory of the OpenGL objects
+            bool resident_; // False while the OpenGL objects are evicted
+            unsigned long last_use_; // Time of the last lookup, for eviction
 
         public:
             Resource(ResourceType type, std::string name, GLuint resource, GLsizei size);
@@ -45,9 +148,68 @@ namespace game {
             GLuint GetArrayBuffer(void) const;
             GLuint GetElementArrayBuffer(void) const;
             GLsizei GetSize(void) const;
+            const glm::vec3 &GetBoundsMin(void) const;
+            const glm::vec3 &GetBoundsMax(void) const;
+            void SetBounds(const glm::vec3 &bounds_min, const glm::vec3 &bounds_max);
+            const VertexLayout &GetLayout(void) const;
+            void SetLayout(const VertexLayout &layout);
+            VertexFormat GetVertexFormat(void) const;
+            void SetVertexFormat(VertexFormat format);
+            int GetNumLods(void) const;
+            const MeshLod &GetLod(int level) const;
+            void SetLods(const MeshLod *lod, int num_lods);
+            const GeometryRange &GetRange(void) const;
+            void SetRange(const GeometryRange &range);
+            // Textures packed into an array hold the array and their layer
+            // in it. The array itself, like a 2D texture, has layer -1
+            GLenum GetTarget(void) const;
+            GLint GetLayer(void) const;
+            void SetTarget(GLenum target, GLint layer);
+            // Locations of the inputs of a shader program
+            const ProgramLocations &GetLocations(void) const;
+            void SetLocations(const ProgramLocations &locations);
+
+            // References held by users of the OpenGL objects. Referenced
+            // resources are never evicted
+            void AddRef(void) const;
+            void Release(void) const;
+            int GetRefCount(void) const;
+
+            // State kept by the ResourceManager to evict and reload the
+            // OpenGL objects
+            const std::string &GetSource(void) const;
+            void SetSource(const std::string &source);
+            size_t GetBytes(void) const;
+            void SetBytes(size_t bytes);
+            bool IsResident(void) const;
+            void SetResident(bool resident);
+            unsigned long GetLastUse(void) const;
+            void SetLastUse(unsigned long time);
+            void SetResource(GLuint resource);
+            void SetBuffers(GLuint array_buffer, GLuint element_array_buffer, GLsizei size);
 
     }; // class Resource
 
+    // Reference to a resource held by the ResourceManager. A handle stays
+    // cheap to resolve, and the generation must match that of the slot, so
+    // a handle to a freed resource does not reach whatever replaced it.
+    // The tag keeps mesh, material and texture handles apart
+    template <typename Tag> struct ResourceHandle {
+        unsigned int index;
+        unsigned int generation; // 0 for a null handle
+
+        ResourceHandle(void) : index(0), generation(0) {}
+        ResourceHandle(unsigned int i, unsigned int g) : index(i), generation(g) {}
+        bool IsNull(void) const { return generation == 0; }
+    };
+
+    struct MeshTag {}; // Meshes and point sets
+    struct MaterialTag {};
+    struct TextureTag {};
+    typedef ResourceHandle<MeshTag> MeshHandle;
+    typedef ResourceHandle<MaterialTag> MaterialHandle;
+    typedef ResourceHandle<TextureTag> TextureHandle;
+
 } // namespace game
 
 #endif // RESOURCE_H_
@@ -1,22 +1,96 @@
 
+#include <algorithm>
+#include <cstring>
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 #include <stdexcept>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <chrono>
 #include <SOIL/SOIL.h>
 
 #include "resource_manager.h"
 #include "model_loader.h"
+#include "mesh_cache.h"
+#include "mesh_simplifier.h"
+#include "program_cache.h"
+#include "vertex_array_cache.h"
+#include "draw_ring.h"
+#include "gl_state.h"
 
 namespace game {
 
     ResourceManager::ResourceManager(void) {
+
+        mesh_stats_.num_cached = 0;
+        mesh_stats_.num_parsed = 0;
+        mesh_stats_.cached_ms = 0.0;
+        mesh_stats_.parsed_ms = 0.0;
+        program_stats_.num_cached = 0;
+        program_stats_.num_compiled = 0;
+        program_stats_.cached_ms = 0.0;
+        program_stats_.compiled_ms = 0.0;
+        vertex_format_ = PackedVertexFormat;
+        for (int i = 0; i < num_resource_types; i++) {
+            resident_bytes_[i] = 0;
+        }
+        memory_budget_ = 0;
+        use_clock_ = 0;
+        num_evicted_ = 0;
+        num_reloaded_ = 0;
     }
 
 
     ResourceManager::~ResourceManager() {
+
+        Clear();
+    }
+
+
+    GeometryPool *ResourceManager::FindPool(GLuint array_buffer) const {
+
+        for (size_t i = 0; i < geometry_pool_.size(); i++) {
+            if (geometry_pool_[i]->GetArrayBuffer() == array_buffer) {
+                return geometry_pool_[i];
+            }
+        }
+        return NULL;
+    }
+
+
+    // Size of the data store of a buffer object
+    static size_t buffer_bytes(GLenum target, GLuint buffer) {
+
+        if (buffer == 0) {
+            return 0;
+        }
+        GLint size = 0;
+        GLState::BindBuffer(target, buffer);
+        glGetBufferParameteriv(target, GL_BUFFER_SIZE, &size);
+        return (size_t) size;
+    }
+
+
+    // Size of a texture made from an image; the mipmaps add a third of the
+    // base level
+    static size_t texture_bytes(const TextureImage &image) {
+
+        return (size_t) image.width * image.height * image.channels * 4 / 3;
+    }
+
+
+    // Bounding box of the positions of vertices of some number of floats,
+    // which start with the position
+    static void vertex_bounds(const GLfloat *vertex, int num_vertices, int vertex_att, glm::vec3 &bounds_min, glm::vec3 &bounds_max) {
+
+        bounds_min = glm::vec3(vertex[0], vertex[1], vertex[2]);
+        bounds_max = bounds_min;
+        for (int i = 1; i < num_vertices; i++) {
+            glm::vec3 position(vertex[i * vertex_att], vertex[i * vertex_att + 1], vertex[i * vertex_att + 2]);
+            bounds_min = glm::min(bounds_min, position);
+            bounds_max = glm::max(bounds_max, position);
+        }
     }
 
 
@@ -26,22 +100,30 @@ namespace game {
 
         res = new Resource(type, name, resource, size);
 
-        resource_.push_back(res);
+        InsertResource(res);
     }
 
 
-    void ResourceManager::AddResource(ResourceType type, const std::string name, GLuint array_buffer, GLuint element_array_buffer, GLsizei size) {
+    Resource *ResourceManager::AddResource(ResourceType type, const std::string name, GLuint array_buffer, GLuint element_array_buffer, GLsizei size) {
 
         Resource* res;
 
         res = new Resource(type, name, array_buffer, element_array_buffer, size);
 
-        resource_.push_back(res);
+        InsertResource(res);
+        SetResidentBytes(res, buffer_bytes(GL_ARRAY_BUFFER, array_buffer) + buffer_bytes(GL_ELEMENT_ARRAY_BUFFER, element_array_buffer));
+        return res;
     }
 
 
     void ResourceManager::LoadResource(ResourceType type, const std::string name, const char* filename) {
 
+        // Resources are found by the first name they were added with, so
+        // loading a name again would only leak the OpenGL objects
+        if (name_index_.find(name) != name_index_.end()) {
+            return;
+        }
+
         // Call appropriate method depending on type of resource
         if (type == Material) {
             LoadMaterial(name, filename);
@@ -56,200 +138,355 @@ namespace game {
     }
 
 
-    Resource* ResourceManager::GetResource(const std::string name) const {
+    Resource* ResourceManager::GetResource(const std::string name) {
 
         // Find resource with the specified name
-        for (int i = 0; i < resource_.size(); i++) {
-            if (resource_[i]->GetName().compare( name) == 0) {
-                return resource_[i];
-            }
+        std::unordered_map<std::string, unsigned int>::const_iterator it = name_index_.find(name);
+        if (it == name_index_.end()) {
+            return NULL;
         }
-        return NULL;
+        return Touch(resource_[it->second]);
     }
 
-    void ResourceManager::LoadMesh(const std::string name, const char* filename) {
 
-        // First load model into memory. If that goes well, we transfer the
-        // mesh to an OpenGL buffer
-        TriMesh mesh;
+    MeshHandle ResourceManager::GetMesh(const std::string name) const {
 
-        // Parse file
-        // Open file
-        std::ifstream f;
-        f.open(filename);
-        if (f.fail()) {
-            throw(std::ios_base::failure(std::string("Error opening file ") + std::string(filename)));
+        unsigned int index;
+        if (!FindSlot(name, Mesh, PointSet, index)) {
+            return MeshHandle();
         }
+        return MeshHandle(index, generation_[index]);
+    }
 
-        // Parse lines
-        std::string line;
-        std::string ignore(" \t\r\n");
-        std::string part_separator(" \t");
-        std::string face_separator("/");
-        bool added_normal = false;
-        while (std::getline(f, line)) {
-            // Clean extremities of the string
-            string_trim(line, ignore);
-            // Ignore comments
-            if ((line.size() <= 0) ||
-                (line[0] == '#')) {
-                continue;
+
+    MaterialHandle ResourceManager::GetMaterial(const std::string name) const {
+
+        unsigned int index;
+        if (!FindSlot(name, Material, Material, index)) {
+            return MaterialHandle();
+        }
+        return MaterialHandle(index, generation_[index]);
+    }
+
+
+    TextureHandle ResourceManager::GetTexture(const std::string name) const {
+
+        unsigned int index;
+        if (!FindSlot(name, Texture, Texture, index)) {
+            return TextureHandle();
+        }
+        return TextureHandle(index, generation_[index]);
+    }
+
+
+    Resource* ResourceManager::GetResource(MeshHandle handle) {
+
+        return Touch(GetSlot(handle.index, handle.generation));
+    }
+
+
+    Resource* ResourceManager::GetResource(MaterialHandle handle) {
+
+        return Touch(GetSlot(handle.index, handle.generation));
+    }
+
+
+    Resource* ResourceManager::GetResource(TextureHandle handle) {
+
+        return Touch(GetSlot(handle.index, handle.generation));
+    }
+
+
+    void ResourceManager::InsertResource(Resource *res) {
+
+        // Generations start at 1, so that a zeroed handle is null. A slot
+        // freed by Clear keeps its generation, bumped, when it is reused.
+        // Lookups by name keep finding the first resource added under a name
+        unsigned int index = (unsigned int) resource_.size();
+        resource_.push_back(res);
+        if (index == generation_.size()) {
+            generation_.push_back(1);
+        }
+        name_index_.insert(std::make_pair(res->GetName(), index));
+    }
+
+
+    bool ResourceManager::FindSlot(const std::string &name, ResourceType type, ResourceType alt_type, unsigned int &index) const {
+
+        std::unordered_map<std::string, unsigned int>::const_iterator it = name_index_.find(name);
+        if (it == name_index_.end()) {
+            return false;
+        }
+        ResourceType found = resource_[it->second]->GetType();
+        if ((found != type) && (found != alt_type)) {
+            return false;
+        }
+        index = it->second;
+        return true;
+    }
+
+
+    Resource* ResourceManager::GetSlot(unsigned int index, unsigned int generation) const {
+
+        if ((generation == 0) || (index >= resource_.size()) || (generation_[index] != generation)) {
+            return NULL;
+        }
+        return resource_[index];
+    }
+
+
+    void ResourceManager::SetResidentBytes(Resource *res, size_t bytes) {
+
+        res->SetBytes(bytes);
+        resident_bytes_[res->GetType()] += bytes;
+    }
+
+
+    Resource* ResourceManager::Touch(Resource *res) {
+
+        if (!res) {
+            return NULL;
+        }
+        res->SetLastUse(++use_clock_);
+        if (!res->IsResident()) {
+            Reload(res);
+            Trim();
+        }
+        return res;
+    }
+
+
+    void ResourceManager::DeleteObjects(Resource *res) {
+
+        // Resources made up for tests have no OpenGL objects, and may be
+        // freed without a context
+        if (res->GetType() == Material) {
+            if (res->GetResource() != 0) {
+                VertexArrayCache::ForgetProgram(res->GetResource());
+                GLState::ForgetProgram(res->GetResource());
+                glDeleteProgram(res->GetResource());
             }
-            // Parse string
-            std::vector<std::string> part = string_split(line, part_separator);
-            // Check commands
-            if (!part[0].compare(std::string("v"))) {
-                if (part.size() >= 4) {
-                    glm::vec3 position(str_to_num<float>(part[1].c_str()), str_to_num<float>(part[2].c_str()), str_to_num<float>(part[3].c_str()));
-                    mesh.position.push_back(position);
-                }
-                else {
-                    throw(std::ios_base::failure(std::string("Error: v command should have exactly 3 parameters")));
-                }
+        }
+        else if (res->GetType() == Texture) {
+            // A layer of an array does not own the array
+            GLuint texture = res->GetResource();
+            if ((texture != 0) && (res->GetLayer() < 0)) {
+                GLState::ForgetTexture(texture);
+                glDeleteTextures(1, &texture);
             }
-            else if (!part[0].compare(std::string("vn"))) {
-                if (part.size() >= 4) {
-                    glm::vec3 normal(str_to_num<float>(part[1].c_str()), str_to_num<float>(part[2].c_str()), str_to_num<float>(part[3].c_str()));
-                    mesh.normal.push_back(normal);
-                    added_normal = true;
-                }
-                else {
-                    throw(std::ios_base::failure(std::string("Error: vn command should have exactly 3 parameters")));
-                }
+        }
+        else {
+            // Pooled meshes only give their space back; the vertex arrays
+            // of the pool stay valid for the other meshes
+            GeometryPool *pool = FindPool(res->GetArrayBuffer());
+            if (pool) {
+                pool->Free(res->GetRange());
+                return;
             }
-            else if (!part[0].compare(std::string("vt"))) {
-                if (part.size() >= 3) {
-                    glm::vec2 tex_coord(str_to_num<float>(part[1].c_str()), str_to_num<float>(part[2].c_str()));
-                    mesh.tex_coord.push_back(tex_coord);
-                }
-                else {
-                    throw(std::ios_base::failure(std::string("Error: vt command should have exactly 2 parameters")));
+            GLuint buffer[2] = { res->GetArrayBuffer(), res->GetElementArrayBuffer() };
+            for (int i = 0; i < 2; i++) {
+                if (buffer[i] != 0) {
+                    VertexArrayCache::ForgetBuffer(buffer[i]);
+                    GLState::ForgetBuffer(buffer[i]);
+                    glDeleteBuffers(1, &buffer[i]);
                 }
             }
-            else if (!part[0].compare(std::string("f"))) {
-                if (part.size() >= 4) {
-                    if (part.size() > 5) {
-                        throw(std::ios_base::failure(std::string("Error: f commands with more than 4 vertices not supported")));
-                    }
-                    else if (part.size() == 5) {
-                        // Break a quad into two triangles
-                        Quad quad;
-                        for (int i = 0; i < 4; i++) {
-                            std::vector<std::string> fd = string_split_once(part[i + 1], face_separator);
-                            if (fd.size() == 1) {
-                                quad.i[i] = str_to_num<float>(fd[0].c_str()) - 1;
-                                quad.t[i] = -1;
-                                quad.n[i] = -1;
-                            }
-                            else if (fd.size() == 2) {
-                                quad.i[i] = str_to_num<float>(fd[0].c_str()) - 1;
-                                quad.t[i] = str_to_num<float>(fd[1].c_str()) - 1;
-                                quad.n[i] = -1;
-                            }
-                            else if (fd.size() == 3) {
-                                quad.i[i] = str_to_num<float>(fd[0].c_str()) - 1;
-                                if (std::string("").compare(fd[1]) != 0) {
-                                    quad.t[i] = str_to_num<float>(fd[1].c_str()) - 1;
-                                }
-                                else {
-                                    quad.t[i] = -1;
-                                }
-                                quad.n[i] = str_to_num<float>(fd[2].c_str()) - 1;
-                            }
-                            else {
-                                throw(std::ios_base::failure(std::string("Error: f parameter should have 1 or 3 parameters separated by '/'")));
-                            }
-                        }
-                        Face face1, face2;
-                        face1.i[0] = quad.i[0]; face1.i[1] = quad.i[1]; face1.i[2] = quad.i[2];
-                        face1.n[0] = quad.n[0]; face1.n[1] = quad.n[1]; face1.n[2] = quad.n[2];
-                        face1.t[0] = quad.t[0]; face1.t[1] = quad.t[1]; face1.t[2] = quad.t[2];
-                        face2.i[0] = quad.i[0]; face2.i[1] = quad.i[2]; face2.i[2] = quad.i[3];
-                        face2.n[0] = quad.n[0]; face2.n[1] = quad.n[2]; face2.n[2] = quad.n[3];
-                        face2.t[0] = quad.t[0]; face2.t[1] = quad.t[2]; face2.t[2] = quad.t[3];
-                        mesh.face.push_back(face1);
-                        mesh.face.push_back(face2);
-                    }
-                    else if (part.size() == 4) {
-                        Face face;
-                        for (int i = 0; i < 3; i++) {
-                            std::vector<std::string> fd = string_split_once(part[i + 1], face_separator);
-                            if (fd.size() == 1) {
-                                face.i[i] = str_to_num<float>(fd[0].c_str()) - 1;
-                                face.t[i] = -1;
-                                face.n[i] = -1;
-                            }
-                            else if (fd.size() == 2) {
-                                face.i[i] = str_to_num<float>(fd[0].c_str()) - 1;
-                                face.t[i] = str_to_num<float>(fd[1].c_str()) - 1;
-                                face.n[i] = -1;
-                            }
-                            else if (fd.size() == 3) {
-                                face.i[i] = str_to_num<float>(fd[0].c_str()) - 1;
-                                if (std::string("").compare(fd[1]) != 0) {
-                                    face.t[i] = str_to_num<float>(fd[1].c_str()) - 1;
-                                }
-                                else {
-                                    face.t[i] = -1;
-                                }
-                                face.n[i] = str_to_num<float>(fd[2].c_str()) - 1;
-                            }
-                            else {
-                                throw(std::ios_base::failure(std::string("Error: f parameter should have 1, 2, or 3 parameters separated by '/'")));
-                            }
-                        }
-                        mesh.face.push_back(face);
-                    }
+        }
+    }
+
+
+    void ResourceManager::Evict(Resource *res) {
+
+        DeleteObjects(res);
+        if (res->GetType() == Texture) {
+            res->SetResource(0);
+        }
+        else {
+            res->SetBuffers(0, 0, res->GetSize());
+        }
+        resident_bytes_[res->GetType()] -= res->GetBytes();
+        res->SetResident(false);
+        num_evicted_++;
+    }
+
+
+    void ResourceManager::Reload(Resource *res) {
+
+        // Read the file the way it was first loaded. Meshes come from their
+        // cache, in the format they were loaded in, so this does not parse
+        // the OBJ file again and keeps the layout their vertex arrays use
+        const char *filename = res->GetSource().c_str();
+        if (res->GetType() == Texture) {
+            TextureImage image;
+            ReadTexture(filename, image);
+            size_t bytes = texture_bytes(image);
+            res->SetResource(CreateTexture(image));
+            res->SetBytes(bytes);
+        }
+        else {
+            MeshSource source;
+            ReadMesh(filename, res->GetVertexFormat(), source);
+            const void *vertex = source.cached ? source.cache.GetVertices() : source.data.vertex.data();
+            size_t vertex_bytes = source.cached ? source.cache.GetVertexBytes() : source.data.vertex.size();
+            const void *index = source.cached ? source.cache.GetIndices() : source.data.index.data();
+            GLsizei num_indices = source.cached ? source.cache.GetNumIndices() : source.data.num_indices;
+            const VertexLayout &layout = source.cached ? source.cache.GetLayout() : source.data.layout;
+            GLuint vbo, ebo;
+            GeometryRange range;
+            CreateMeshBuffers(vertex, vertex_bytes, index, num_indices, layout, vbo, ebo, range);
+            res->SetBuffers(vbo, ebo, res->GetSize());
+            res->SetRange(range);
+            res->SetBytes(vertex_bytes + num_indices * ((layout.index_type == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint)));
+        }
+        resident_bytes_[res->GetType()] += res->GetBytes();
+        res->SetResident(true);
+        num_reloaded_++;
+    }
+
+
+    void ResourceManager::SetMemoryBudget(size_t bytes) {
+
+        memory_budget_ = bytes;
+    }
+
+
+    size_t ResourceManager::GetMemoryBudget(void) const {
+
+        return memory_budget_;
+    }
+
+
+    size_t ResourceManager::GetResidentBytes(ResourceType type) const {
+
+        return resident_bytes_[type];
+    }
+
+
+    void ResourceManager::Trim(void) {
+
+        if (memory_budget_ == 0) {
+            return;
+        }
+
+        // Evict the least recently used resource until the meshes and
+        // textures fit. Resources held by scene nodes stay, as the nodes
+        // keep their OpenGL objects, and so does the one just used
+        while (resident_bytes_[Mesh] + resident_bytes_[Texture] > memory_budget_) {
+            Resource *victim = NULL;
+            for (unsigned int i = 0; i < resource_.size(); i++) {
+                Resource *res = resource_[i];
+                if ((res->GetType() != Mesh) && (res->GetType() != Texture)) {
+                    continue;
                 }
-                else {
-                    throw(std::ios_base::failure(std::string("Error: f command should have 3 or 4 parameters")));
+                if (!res->IsResident() || (res->GetRefCount() > 0) || res->GetSource().empty() || (res->GetLastUse() == use_clock_)) {
+                    continue;
+                }
+                if (!victim || (res->GetLastUse() < victim->GetLastUse())) {
+                    victim = res;
                 }
             }
-            // Ignore other commands
+            if (!victim) {
+                break;
+            }
+            Evict(victim);
         }
+    }
 
-        // Close file
-        f.close();
 
-        // Check if vertex references are correct
-        for (unsigned int i = 0; i < mesh.face.size(); i++) {
-            for (int j = 0; j < 3; j++) {
-                if (mesh.face[i].i[j] >= mesh.position.size()) {
-                    throw(std::ios_base::failure(std::string("Error: index for triangle ") + num_to_str<int>(mesh.face[i].i[j]) + std::string(" is out of bounds")));
-                }
+    void ResourceManager::PrintMemoryStats(void) const {
+
+        const char *type_name[num_resource_types] = { "materials", "point sets", "meshes", "textures" };
+        std::cout << "GPU memory:";
+        for (int i = 0; i < num_resource_types; i++) {
+            std::cout << " " << type_name[i] << " " << resident_bytes_[i] / 1024 << " KB";
+        }
+        std::cout << ", budget " << memory_budget_ / 1024 << " KB, " <<
+            num_evicted_ << " evicted, " << num_reloaded_ << " reloaded" << std::endl;
+        for (size_t i = 0; i < geometry_pool_.size(); i++) {
+            geometry_pool_[i]->PrintStats();
+        }
+    }
+
+
+    void ResourceManager::Clear(void) {
+
+        VertexArrayCache::Clear();
+
+        for (unsigned int i = 0; i < resource_.size(); i++) {
+            if (resource_[i]->IsResident()) {
+                DeleteObjects(resource_[i]);
+            }
+            delete resource_[i];
+            // Handles to the slot go stale. Generations are kept, so that
+            // they do not match whatever is added there next
+            if (++generation_[i] == 0) {
+                generation_[i] = 1;
             }
         }
+        resource_.clear();
+        name_index_.clear();
+        for (size_t i = 0; i < geometry_pool_.size(); i++) {
+            delete geometry_pool_[i];
+        }
+        geometry_pool_.clear();
+        for (int i = 0; i < num_resource_types; i++) {
+            resident_bytes_[i] = 0;
+        }
+    }
 
-        // Compute degree of each vertex
-        std::vector<int> degree(mesh.position.size(), 0);
+
+    void ResourceManager::LoadMesh(const std::string name, const char* filename) {
+
+        MeshSource source;
+        ReadMesh(filename, vertex_format_, source);
+        AddMesh(name, source, filename);
+    }
+
+
+    void ResourceManager::ReadMesh(const char* filename, VertexFormat format, MeshSource& source) {
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        // Use the binary cache of the mesh if it is up to date with the OBJ
+        // file. The mapped data goes straight to OpenGL
+        source.format = format;
+        source.cached = source.cache.Open(filename, format);
+        if (source.cached) {
+            source.load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            return;
+        }
+
+        // First load model into memory. If that goes well, we transfer the
+        // mesh to an OpenGL buffer
+        TriMesh mesh;
+        load_obj(filename, mesh);
+
+#ifdef VERIFY_OBJ_PARSER
+        // Check the parser against the original loader
+        TriMesh reference;
+        load_obj_legacy(filename, reference);
+        std::string diff;
+        if (!compare_meshes(mesh, reference, diff)) {
+            throw(std::ios_base::failure(std::string("Error: OBJ parsers disagree on ") + std::string(filename) + std::string(": ") + diff));
+        }
+#endif
+
+        // Normals are indexed by face corner if the file has any, and by
+        // vertex if they are computed
+        bool added_normal = mesh.normal.size() > 0;
+
+        // Check if vertex references are correct
         for (unsigned int i = 0; i < mesh.face.size(); i++) {
             for (int j = 0; j < 3; j++) {
-                degree[mesh.face[i].i[j]]++;
+                if ((mesh.face[i].i[j] < 0) || (mesh.face[i].i[j] >= (int) mesh.position.size())) {
+                    throw(std::ios_base::failure(std::string("Error: index for triangle ") + num_to_str<int>(mesh.face[i].i[j]) + std::string(" is out of bounds")));
+                }
             }
         }
 
         // Compute vertex normals if no normals were ever added
         if (!added_normal) {
-            mesh.normal = std::vector<glm::vec3>(mesh.position.size(), glm::vec3(0.0, 0.0, 0.0));
-            for (unsigned int i = 0; i < mesh.face.size(); i++) {
-                // Compute face normal
-                glm::vec3 vec1, vec2;
-                vec1 = mesh.position[mesh.face[i].i[0]] -
-                    mesh.position[mesh.face[i].i[1]];
-                vec2 = mesh.position[mesh.face[i].i[0]] -
-                    mesh.position[mesh.face[i].i[2]];
-                glm::vec3 norm = glm::cross(vec1, vec2);
-                norm = glm::normalize(norm);
-                // Add face normal to vertices
-                mesh.normal[mesh.face[i].i[0]] += norm;
-                mesh.normal[mesh.face[i].i[1]] += norm;
-                mesh.normal[mesh.face[i].i[2]] += norm;
-            }
-            for (unsigned int i = 0; i < mesh.normal.size(); i++) {
-                if (degree[i] > 0) {
-                    mesh.normal[i] /= degree[i];
-                }
-            }
+            compute_vertex_normals(mesh);
         }
 
         // Debug
@@ -257,87 +494,287 @@ namespace game {
 
         // If we got to this point, the file was parsed successfully and the
         // mesh is in memory
-        // Now, transfer the mesh to OpenGL buffers
-        // Create three new vertices for each face, in case vertex
-        // normals/texture coordinates are not consistent over the mesh
+        // Now, build the buffer layout, share vertices between triangles and
+        // order them for the vertex cache, add simplified levels of detail,
+        // pack them, then save the result for the next run
+        MeshData data;
+        build_mesh_data(mesh, !added_normal, data);
+        optimize_mesh(data, &source.stats);
+        build_mesh_lods(data);
+        pack_mesh(data, format, source.data);
+        source.stats.bytes_after = source.data.vertex.size() + source.data.index.size();
+        MeshCache::Write(filename, format, source.data);
+        source.load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
 
-        // Number of attributes for vertices and faces
-        const int vertex_att = 11;
-        const int face_att = 3;
 
-        // Create OpenGL buffers and copy data
-        GLuint vbo, ebo;
+    void ResourceManager::AddMesh(const std::string name, const MeshSource& source, const char *filename) {
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
+        Resource *res;
+        if (source.cached) {
+            res = AddMesh(name, source.cache.GetVertices(), source.cache.GetVertexBytes(), source.cache.GetIndices(), source.cache.GetNumIndices(), source.cache.GetLayout(), source.cache.GetBoundsMin(), source.cache.GetBoundsMax(), source.cache.GetLods(), source.cache.GetNumLods());
+        }
+        else {
+            res = AddMesh(name, source.data.vertex.data(), source.data.vertex.size(), source.data.index.data(), source.data.num_indices, source.data.layout, source.data.bounds_min, source.data.bounds_max, source.data.lod.data(), (int) source.data.lod.size());
+        }
+        if (filename) {
+            res->SetSource(filename);
+        }
+        res->SetVertexFormat(source.format);
+
+        double upload_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (source.cached) {
+            mesh_stats_.num_cached++;
+            mesh_stats_.cached_ms += source.load_ms + upload_ms;
+        }
+        else {
+            mesh_stats_.num_parsed++;
+            mesh_stats_.parsed_ms += source.load_ms + upload_ms;
+
+            // Report what the optimizer did
+            const MeshOptimizeStats &stats = source.stats;
+            std::cout << "Mesh " << name << ": " <<
+                stats.num_vertices_before << " -> " << stats.num_vertices_after << " vertices, ACMR " <<
+                stats.acmr_before << " -> " << stats.acmr_after << ", " <<
+                stats.bytes_before / 1024 << " KB -> " << stats.bytes_after / 1024 << " KB, triangles per level";
+            for (size_t i = 0; i < source.data.lod.size(); i++) {
+                std::cout << " " << source.data.lod[i].num_indices / 3;
+            }
+            std::cout << std::endl;
+        }
+    }
+
+
+    void ResourceManager::CreateMeshBuffers(const void *vertex, size_t vertex_bytes, const void *index, GLsizei num_indices, const VertexLayout &layout, GLuint &vbo, GLuint &ebo, GeometryRange &range) {
+
+        size_t index_size = (layout.index_type == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+        GLuint num_vertices = (GLuint) (vertex_bytes / layout.stride);
+
+        // Use the first pool of the layout with room, or start a new one
+        if (GeometryPool::Fits(layout, num_vertices, num_indices)) {
+            GeometryPool *pool = NULL;
+            for (size_t i = 0; i < geometry_pool_.size(); i++) {
+                if (geometry_pool_[i]->Matches(layout) && geometry_pool_[i]->Allocate(vertex, num_vertices, index, num_indices, range)) {
+                    pool = geometry_pool_[i];
+                    break;
+                }
+            }
+            if (!pool) {
+                pool = new GeometryPool(layout);
+                geometry_pool_.push_back(pool);
+                pool->Allocate(vertex, num_vertices, index, num_indices, range);
+            }
+            vbo = pool->GetArrayBuffer();
+            ebo = pool->GetElementArrayBuffer();
+            return;
+        }
+
+        range.base_vertex = 0;
+        range.num_vertices = num_vertices;
+        range.first_index = 0;
+        range.num_indices = num_indices;
+
+        // Create OpenGL buffers and copy data
         glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, mesh.face.size() * 3 * vertex_att * sizeof(GLuint), 0, GL_STATIC_DRAW);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, vertex_bytes, vertex, GL_STATIC_DRAW);
 
         glGenBuffers(1, &ebo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.face.size() * face_att * sizeof(GLuint), 0, GL_STATIC_DRAW);
+        GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, num_indices * index_size, index, GL_STATIC_DRAW);
+    }
 
-        unsigned int vertex_index = 0;
-        for (unsigned int i = 0; i < mesh.face.size(); i++) {
-            // Add three vertices and their attributes
-            GLfloat att[3 * vertex_att] = { 0 };
-            for (int j = 0; j < 3; j++) {
-                // Position
-                att[j * vertex_att + 0] = mesh.position[mesh.face[i].i[j]][0];
-                att[j * vertex_att + 1] = mesh.position[mesh.face[i].i[j]][1];
-                att[j * vertex_att + 2] = mesh.position[mesh.face[i].i[j]][2];
-                // Normal
-                if (!added_normal) {
-                    att[j * vertex_att + 3] = mesh.normal[mesh.face[i].i[j]][0];
-                    att[j * vertex_att + 4] = mesh.normal[mesh.face[i].i[j]][1];
-                    att[j * vertex_att + 5] = mesh.normal[mesh.face[i].i[j]][2];
-                }
-                else {
-                    if (mesh.face[i].n[j] >= 0) {
-                        att[j * vertex_att + 3] = mesh.normal[mesh.face[i].n[j]][0];
-                        att[j * vertex_att + 4] = mesh.normal[mesh.face[i].n[j]][1];
-                        att[j * vertex_att + 5] = mesh.normal[mesh.face[i].n[j]][2];
-                    }
-                }
-                // No color in (6, 7, 8)
-                // Texture coordinates
-                if (mesh.face[i].t[j] >= 0) {
-                    att[j * vertex_att + 9] = mesh.tex_coord[mesh.face[i].t[j]][0];
-                    att[j * vertex_att + 10] = mesh.tex_coord[mesh.face[i].t[j]][1];
-                }
+
+    Resource* ResourceManager::AddMesh(const std::string name, const void *vertex, size_t vertex_bytes, const void *index, GLsizei num_indices, const VertexLayout &layout, const glm::vec3 &bounds_min, const glm::vec3 &bounds_max, const MeshLod *lod, int num_lods) {
+
+        size_t index_size = (layout.index_type == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+
+        GLuint vbo, ebo;
+        GeometryRange range;
+        CreateMeshBuffers(vertex, vertex_bytes, index, num_indices, layout, vbo, ebo, range);
+
+        // Create resource. The index buffer holds every level of detail,
+        // and the size is that of the full mesh
+        GLsizei size = (num_lods > 0) ? lod[0].num_indices : num_indices;
+        Resource* res = new Resource(Mesh, name, vbo, ebo, size);
+        res->SetBounds(bounds_min, bounds_max);
+        res->SetLayout(layout);
+        res->SetLods(lod, num_lods);
+        res->SetRange(range);
+        InsertResource(res);
+        SetResidentBytes(res, vertex_bytes + num_indices * index_size);
+        return res;
+    }
+
+
+    void ResourceManager::SetVertexFormat(VertexFormat format) {
+
+        vertex_format_ = format;
+    }
+
+
+    VertexFormat ResourceManager::GetVertexFormat(void) const {
+
+        return vertex_format_;
+    }
+
+
+    const MeshLoadStats &ResourceManager::GetMeshLoadStats(void) const {
+
+        return mesh_stats_;
+    }
+
+
+    const ProgramLoadStats &ResourceManager::GetProgramLoadStats(void) const {
+
+        return program_stats_;
+    }
+
+
+    void ResourceManager::LoadMaterial(const std::string name, const char* prefix) {
+
+        MaterialSource source;
+        ReadMaterial(prefix, source);
+        AddMaterial(name, source);
+    }
+
+
+    void ResourceManager::ReadMaterial(const char* prefix, MaterialSource& source) {
+
+        source.prefix = prefix;
+
+        // Load vertex program source code
+        std::string filename = std::string(prefix) + std::string(VERTEX_PROGRAM_EXTENSION);
+        source.vp = LoadTextFile(filename.c_str());
+
+        // Load fragment program source code
+        filename = std::string(prefix) + std::string(FRAGMENT_PROGRAM_EXTENSION);
+        source.fp = LoadTextFile(filename.c_str());
+
+        // Try to also load a geometry shader
+        filename = std::string(prefix) + std::string(GEOMETRY_PROGRAM_EXTENSION);
+        source.geometry_program = false;
+        source.gp = "";
+        try {
+            source.gp = LoadTextFile(filename.c_str());
+            source.geometry_program = true;
+        }
+        catch (std::exception& e) {
+        }
+    }
+
+
+    void ResourceManager::AddMaterial(const std::string name, const MaterialSource& source) {
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        // Use the program saved by an earlier run if the sources and the
+        // driver are the same. Otherwise, compile the sources and save the
+        // result for the next run
+        bool use_cache = !source.prefix.empty() && ProgramCache::IsSupported();
+        uint64_t key = 0;
+        GLuint sp = 0;
+        if (use_cache) {
+            key = ProgramCache::GetKey(source.vp, source.fp, source.gp);
+            sp = ProgramCache::Load(source.prefix.c_str(), key);
+        }
+        bool cached = sp != 0;
+        if (!cached) {
+            sp = CompileProgram(source, use_cache);
+            if (use_cache) {
+                ProgramCache::Write(source.prefix.c_str(), key, sp);
             }
+        }
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (cached) {
+            program_stats_.num_cached++;
+            program_stats_.cached_ms += ms;
+        }
+        else {
+            program_stats_.num_compiled++;
+            program_stats_.compiled_ms += ms;
+        }
+
+        // Add a resource for the shader program, with the locations of its
+        // inputs so that drawing does not look them up by name
+        ProgramLocations locations;
+        ReflectProgram(sp, locations);
+        Resource *res = new Resource(Material, name, sp, 0);
+        res->SetLocations(locations);
+        InsertResource(res);
+    }
 
-            // Copy attributes to buffer
-            glBufferSubData(GL_ARRAY_BUFFER, i * 3 * vertex_att * sizeof(GLfloat), 3 * vertex_att * sizeof(GLfloat), att);
 
-            // Add triangle
-            GLuint findex[face_att] = { 0 };
-            findex[0] = vertex_index;
-            findex[1] = vertex_index + 1;
-            findex[2] = vertex_index + 2;
-            vertex_index += 3;
+    void ResourceManager::ReflectProgram(GLuint program, ProgramLocations &locations) {
+
+        for (int i = 0; i < num_program_uniforms; i++) {
+            locations.uniform[i] = -1;
+        }
+        for (int i = 0; i < num_program_attribs; i++) {
+            locations.attrib[i] = -1;
+        }
+
+        GLint num_active, max_length;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &num_active);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+        std::vector<GLchar> name(std::max(max_length, 1));
+        for (GLint i = 0; i < num_active; i++) {
+            GLint size;
+            GLenum type;
+            glGetActiveUniform(program, i, (GLsizei) name.size(), NULL, &size, &type, name.data());
+            for (int j = 0; j < num_program_uniforms; j++) {
+                if (strcmp(name.data(), program_uniform_name[j]) == 0) {
+                    locations.uniform[j] = glGetUniformLocation(program, name.data());
+                }
+            }
+        }
+
+        glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &num_active);
+        glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &max_length);
+        name.resize(std::max(max_length, 1));
+        for (GLint i = 0; i < num_active; i++) {
+            GLint size;
+            GLenum type;
+            glGetActiveAttrib(program, i, (GLsizei) name.size(), NULL, &size, &type, name.data());
+            for (int j = 0; j < num_program_attribs; j++) {
+                if (strcmp(name.data(), program_attrib_name[j]) == 0) {
+                    locations.attrib[j] = glGetAttribLocation(program, name.data());
+                }
+            }
+        }
 
-            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, i * face_att * sizeof(GLuint), face_att * sizeof(GLuint), findex);
+        // Connect the per-frame data of the camera and the per-draw data
+        // of the nodes
+        GLuint block = glGetUniformBlockIndex(program, "PerFrame");
+        if (block != GL_INVALID_INDEX) {
+            glUniformBlockBinding(program, block, frame_uniforms_binding);
+        }
+        block = glGetUniformBlockIndex(program, "PerDraw");
+        if (block != GL_INVALID_INDEX) {
+            glUniformBlockBinding(program, block, draw_uniforms_binding);
         }
 
-        // Create resource
-        AddResource(Mesh, name, vbo, ebo, mesh.face.size() * face_att);
+        // Textures always go to the same units, so the samplers are set
+        // here rather than on every draw
+        GLState::UseProgram(program);
+        if (locations.uniform[TextureMapUniform] >= 0) {
+            glUniform1i(locations.uniform[TextureMapUniform], 0);
+        }
+        if (locations.uniform[NormalMapUniform] >= 0) {
+            glUniform1i(locations.uniform[NormalMapUniform], 1);
+        }
+        GLState::UseProgram(0);
     }
 
 
-    void ResourceManager::LoadMaterial(const std::string name, const char* prefix) {
-
-
-        // Load vertex program source code
-        std::string filename = std::string(prefix) + std::string(VERTEX_PROGRAM_EXTENSION);
-        std::string vp = LoadTextFile(filename.c_str());
-
-        // Load fragment program source code
-        filename = std::string(prefix) + std::string(FRAGMENT_PROGRAM_EXTENSION);
-        std::string fp = LoadTextFile(filename.c_str());
+    GLuint ResourceManager::CompileProgram(const MaterialSource& source, bool retrievable) {
 
         // Create a shader from the vertex program source code
         GLuint vs = glCreateShader(GL_VERTEX_SHADER);
-        const char* source_vp = vp.c_str();
+        const char* source_vp = source.vp.c_str();
         glShaderSource(vs, 1, &source_vp, NULL);
         glCompileShader(vs);
 
@@ -352,7 +789,7 @@ namespace game {
 
         // Create a shader from the fragment program source code
         GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
-        const char* source_fp = fp.c_str();
+        const char* source_fp = source.fp.c_str();
         glShaderSource(fs, 1, &source_fp, NULL);
         glCompileShader(fs);
 
@@ -364,23 +801,14 @@ namespace game {
             throw(std::ios_base::failure(std::string("Error compiling fragment shader: ") + std::string(buffer)));
         }
 
-        // Try to also load a geometry shader
-        filename = std::string(prefix) + std::string(GEOMETRY_PROGRAM_EXTENSION);
-        bool geometry_program = false;
-        std::string gp = "";
+        // Compile the geometry shader, if there is one
+        bool geometry_program = source.geometry_program;
         GLuint gs;
-        try {
-            gp = LoadTextFile(filename.c_str());
-            geometry_program = true;
-        }
-        catch (std::exception& e) {
-        }
-
         if (geometry_program) {
             //std::cout << "GP worjking" << std::endl;
             // Create a shader from the geometry program source code
             gs = glCreateShader(GL_GEOMETRY_SHADER);
-            const char* source_gp = gp.c_str();
+            const char* source_gp = source.gp.c_str();
             glShaderSource(gs, 1, &source_gp, NULL);
             glCompileShader(gs);
 
@@ -397,6 +825,9 @@ namespace game {
         // Create a shader program linking both vertex and fragment shaders
         // together
         GLuint sp = glCreateProgram();
+        if (retrievable) {
+            glProgramParameteri(sp, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
         glAttachShader(sp, vs);
         glAttachShader(sp, fs);
         if (geometry_program) {
@@ -420,20 +851,183 @@ namespace game {
             glDeleteShader(gs);
         }
 
-        // Add a resource for the shader program
-        AddResource(Material, name, sp, 0);
+        return sp;
     }
 
     void ResourceManager::LoadTexture(const std::string name, const char* filename) {
 
-        // Load texture from file
-        GLuint texture = SOIL_load_OGL_texture(filename, SOIL_LOAD_AUTO, SOIL_CREATE_NEW_ID, 0);
-        if (!texture) {
+        TextureImage image;
+        ReadTexture(filename, image);
+        AddTexture(name, image, filename);
+    }
+
+
+    void ResourceManager::ReadTexture(const char* filename, TextureImage& image) {
+
+        // Decode image from file, keeping the channels it was saved with
+        image.pixels = SOIL_load_image(filename, &image.width, &image.height, &image.channels, SOIL_LOAD_AUTO);
+        if (!image.pixels) {
             throw(std::ios_base::failure(std::string("Error loading texture ") + std::string(filename) + std::string(": ") + std::string(SOIL_last_result())));
         }
+    }
+
+
+    void ResourceManager::AddTexture(const std::string name, TextureImage& image, const char *filename) {
+
+        size_t bytes = texture_bytes(image);
+        GLuint texture = CreateTexture(image);
 
         // Create resource
-        AddResource(Texture, name, texture, 0);
+        Resource *res = new Resource(Texture, name, texture, 0);
+        if (filename) {
+            res->SetSource(filename);
+        }
+        InsertResource(res);
+        SetResidentBytes(res, bytes);
+    }
+
+
+    void ResourceManager::PackTextureArray(const std::string name, const std::vector<std::string> &textures) {
+
+        // Find the layer of each texture
+        std::vector<Resource *> member;
+        std::vector<GLint> member_layer;
+        std::vector<GLuint> layer_texture; // 2D texture copied to each layer
+        for (size_t i = 0; i < textures.size(); i++) {
+            Resource *res = GetResource(textures[i]);
+            if (!res || (res->GetType() != Texture) || (res->GetTarget() != GL_TEXTURE_2D)) {
+                throw(std::invalid_argument(std::string("Cannot pack ") + textures[i] + std::string(" into texture array ") + name));
+            }
+            GLint layer = (GLint) layer_texture.size();
+            for (size_t j = 0; j < member.size(); j++) {
+                if (!res->GetSource().empty() && (member[j]->GetSource() == res->GetSource())) {
+                    layer = member_layer[j];
+                    break;
+                }
+            }
+            if (layer == (GLint) layer_texture.size()) {
+                layer_texture.push_back(res->GetResource());
+            }
+            member.push_back(res);
+            member_layer.push_back(layer);
+        }
+        if (layer_texture.empty()) {
+            return;
+        }
+
+        // All layers have the size and format of the first texture
+        GLint width, height, internal_format;
+        for (size_t i = 0; i < layer_texture.size(); i++) {
+            GLint w, h, format;
+            GLState::BindTexture(0, GL_TEXTURE_2D, layer_texture[i]);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &w);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &h);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+            if (i == 0) {
+                width = w;
+                height = h;
+                internal_format = format;
+            }
+            else if ((w != width) || (h != height) || (format != internal_format)) {
+                throw(std::invalid_argument(std::string("Textures of texture array ") + name + std::string(" differ in size or format")));
+            }
+        }
+
+        // Storage for the full mip chain of every layer
+        GLsizei num_layers = (GLsizei) layer_texture.size();
+        int num_levels = 1;
+        while (((width >> num_levels) > 0) || ((height >> num_levels) > 0)) {
+            num_levels++;
+        }
+        GLuint array;
+        glGenTextures(1, &array);
+        GLState::BindTexture(0, GL_TEXTURE_2D_ARRAY, array);
+        for (int level = 0; level < num_levels; level++) {
+            GLsizei w = glm::max(width >> level, 1);
+            GLsizei h = glm::max(height >> level, 1);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internal_format, w, h, num_layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        }
+
+        // The 2D textures already have their mipmaps. Copy them on the GPU
+        // where possible; otherwise read back the base level and build the
+        // mipmaps again
+        if (GLEW_VERSION_4_3 || GLEW_ARB_copy_image) {
+            for (GLsizei layer = 0; layer < num_layers; layer++) {
+                for (int level = 0; level < num_levels; level++) {
+                    GLsizei w = glm::max(width >> level, 1);
+                    GLsizei h = glm::max(height >> level, 1);
+                    glCopyImageSubData(layer_texture[layer], GL_TEXTURE_2D, level, 0, 0, 0, array, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, w, h, 1);
+                }
+            }
+        }
+        else {
+            std::vector<unsigned char> pixels((size_t) width * height * 4);
+            for (GLsizei layer = 0; layer < num_layers; layer++) {
+                GLState::BindTexture(0, GL_TEXTURE_2D, layer_texture[layer]);
+                glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            }
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        }
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        // The textures now only refer to the array, which is never evicted.
+        // Layers were numbered in order, so the member that opens each one
+        // is the first with the next layer number
+        size_t bytes = 0;
+        GLint next_layer = 0;
+        for (size_t i = 0; i < member.size(); i++) {
+            Resource *res = member[i];
+            if (member_layer[i] == next_layer) {
+                bytes += res->GetBytes();
+                next_layer++;
+            }
+            DeleteObjects(res);
+            resident_bytes_[Texture] -= res->GetBytes();
+            res->SetBytes(0);
+            res->SetSource("");
+            res->SetResource(array);
+            res->SetTarget(GL_TEXTURE_2D_ARRAY, member_layer[i]);
+        }
+        Resource *res = new Resource(Texture, name, array, 0);
+        res->SetTarget(GL_TEXTURE_2D_ARRAY, -1);
+        InsertResource(res);
+        SetResidentBytes(res, bytes);
+    }
+
+
+    GLuint ResourceManager::CreateTexture(TextureImage& image) {
+
+        GLenum format;
+        switch (image.channels) {
+            case 1: format = GL_LUMINANCE; break;
+            case 2: format = GL_LUMINANCE_ALPHA; break;
+            case 3: format = GL_RGB; break;
+            default: format = GL_RGBA; break;
+        }
+
+        // Copy the image to a new texture and build its mipmaps, once. The
+        // parameters match the sampler that nodes draw textures with, for
+        // drivers without sampler objects
+        GLuint texture;
+        glGenTextures(1, &texture);
+        GLState::BindTexture(0, GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        SOIL_free_image_data(image.pixels);
+        image.pixels = NULL;
+
+        return texture;
     }
 
 
@@ -602,21 +1196,26 @@ namespace game {
 
         // Create OpenGL buffer for vertices
         glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, vbo);
         glBufferData(GL_ARRAY_BUFFER, vertex_num * vertex_att * sizeof(GLfloat), vertex, GL_STATIC_DRAW);
 
         // Create OpenGL buffer for faces
         glGenBuffers(1, &ebo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, face_num * face_att * sizeof(GLuint), face, GL_STATIC_DRAW);
 
+        // Bounds of the geometry, for culling
+        glm::vec3 bounds_min, bounds_max;
+        vertex_bounds(vertex, vertex_num, vertex_att, bounds_min, bounds_max);
+
         // Free data buffers
         delete[] vertex;
         delete[] face;
 
 
         // Create resource
-        AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
+        Resource *res = AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
+        res->SetBounds(bounds_min, bounds_max);
 
     }
 
@@ -765,21 +1364,26 @@ namespace game {
 
         // Create OpenGL buffer for vertices
         glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, vbo);
         glBufferData(GL_ARRAY_BUFFER, vertex_num * vertex_att * sizeof(GLfloat), vertex, GL_STATIC_DRAW);
 
         // Create OpenGL buffer for faces
         glGenBuffers(1, &ebo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, face_num * face_att * sizeof(GLuint), face, GL_STATIC_DRAW);
 
+        // Bounds of the geometry, for culling
+        glm::vec3 bounds_min, bounds_max;
+        vertex_bounds(vertex, vertex_num, vertex_att, bounds_min, bounds_max);
+
         // Free data buffers
         delete[] vertex;
         delete[] face;
 
 
         // Create resource
-        AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
+        Resource *res = AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
+        res->SetBounds(bounds_min, bounds_max);
 
     }
 
@@ -873,19 +1477,24 @@ namespace game {
 
         GLuint vbo, ebo;
         glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, vbo);
         glBufferData(GL_ARRAY_BUFFER, vertex_num * vertex_att * sizeof(GLfloat), vertex, GL_STATIC_DRAW);
 
         glGenBuffers(1, &ebo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, face_num * face_att * sizeof(GLuint), face, GL_STATIC_DRAW);
 
+        // Bounds of the geometry, for culling
+        glm::vec3 bounds_min, bounds_max;
+        vertex_bounds(vertex, vertex_num, vertex_att, bounds_min, bounds_max);
+
         // Free data buffers
         delete[] vertex;
         delete[] face;
 
         // Create resource
-        AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
+        Resource *res = AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
+        res->SetBounds(bounds_min, bounds_max);
     }
 
 
@@ -965,6 +1574,247 @@ namespace game {
     }
 
 
+    int obj_index(std::string str, size_t count) {
+
+        // Negative indices count back from the last element read so far
+        int value = (int) str_to_num<float>(str.c_str());
+        if (value < 0) {
+            return (int) count + value;
+        }
+        return value - 1;
+    }
+
+
+    void load_obj_legacy(const char* filename, TriMesh& mesh) {
+
+        mesh = TriMesh();
+
+        // Parse file
+        // Open file
+        std::ifstream f;
+        f.open(filename);
+        if (f.fail()) {
+            throw(std::ios_base::failure(std::string("Error opening file ") + std::string(filename)));
+        }
+
+        // Parse lines
+        std::string line;
+        std::string ignore(" \t\r\n");
+        std::string part_separator(" \t");
+        std::string face_separator("/");
+        while (std::getline(f, line)) {
+            // Clean extremities of the string
+            string_trim(line, ignore);
+            // Ignore comments
+            if ((line.size() <= 0) ||
+                (line[0] == '#')) {
+                continue;
+            }
+            // Parse string
+            std::vector<std::string> part = string_split(line, part_separator);
+            // Check commands
+            if (!part[0].compare(std::string("v"))) {
+                if (part.size() >= 4) {
+                    glm::vec3 position(str_to_num<float>(part[1].c_str()), str_to_num<float>(part[2].c_str()), str_to_num<float>(part[3].c_str()));
+                    mesh.position.push_back(position);
+                }
+                else {
+                    throw(std::ios_base::failure(std::string("Error: v command should have exactly 3 parameters")));
+                }
+            }
+            else if (!part[0].compare(std::string("vn"))) {
+                if (part.size() >= 4) {
+                    glm::vec3 normal(str_to_num<float>(part[1].c_str()), str_to_num<float>(part[2].c_str()), str_to_num<float>(part[3].c_str()));
+                    mesh.normal.push_back(normal);
+                }
+                else {
+                    throw(std::ios_base::failure(std::string("Error: vn command should have exactly 3 parameters")));
+                }
+            }
+            else if (!part[0].compare(std::string("vt"))) {
+                if (part.size() >= 3) {
+                    glm::vec2 tex_coord(str_to_num<float>(part[1].c_str()), str_to_num<float>(part[2].c_str()));
+                    mesh.tex_coord.push_back(tex_coord);
+                }
+                else {
+                    throw(std::ios_base::failure(std::string("Error: vt command should have exactly 2 parameters")));
+                }
+            }
+            else if (!part[0].compare(std::string("f"))) {
+                if (part.size() >= 4) {
+                    if (part.size() > 5) {
+                        throw(std::ios_base::failure(std::string("Error: f commands with more than 4 vertices not supported")));
+                    }
+                    else if (part.size() == 5) {
+                        // Break a quad into two triangles
+                        Quad quad;
+                        for (int i = 0; i < 4; i++) {
+                            std::vector<std::string> fd = string_split_once(part[i + 1], face_separator);
+                            if (fd.size() == 1) {
+                                quad.i[i] = obj_index(fd[0], mesh.position.size());
+                                quad.t[i] = -1;
+                                quad.n[i] = -1;
+                            }
+                            else if (fd.size() == 2) {
+                                quad.i[i] = obj_index(fd[0], mesh.position.size());
+                                quad.t[i] = obj_index(fd[1], mesh.tex_coord.size());
+                                quad.n[i] = -1;
+                            }
+                            else if (fd.size() == 3) {
+                                quad.i[i] = obj_index(fd[0], mesh.position.size());
+                                if (std::string("").compare(fd[1]) != 0) {
+                                    quad.t[i] = obj_index(fd[1], mesh.tex_coord.size());
+                                }
+                                else {
+                                    quad.t[i] = -1;
+                                }
+                                quad.n[i] = obj_index(fd[2], mesh.normal.size());
+                            }
+                            else {
+                                throw(std::ios_base::failure(std::string("Error: f parameter should have 1 or 3 parameters separated by '/'")));
+                            }
+                        }
+                        Face face1, face2;
+                        face1.i[0] = quad.i[0]; face1.i[1] = quad.i[1]; face1.i[2] = quad.i[2];
+                        face1.n[0] = quad.n[0]; face1.n[1] = quad.n[1]; face1.n[2] = quad.n[2];
+                        face1.t[0] = quad.t[0]; face1.t[1] = quad.t[1]; face1.t[2] = quad.t[2];
+                        face2.i[0] = quad.i[0]; face2.i[1] = quad.i[2]; face2.i[2] = quad.i[3];
+                        face2.n[0] = quad.n[0]; face2.n[1] = quad.n[2]; face2.n[2] = quad.n[3];
+                        face2.t[0] = quad.t[0]; face2.t[1] = quad.t[2]; face2.t[2] = quad.t[3];
+                        mesh.face.push_back(face1);
+                        mesh.face.push_back(face2);
+                    }
+                    else if (part.size() == 4) {
+                        Face face;
+                        for (int i = 0; i < 3; i++) {
+                            std::vector<std::string> fd = string_split_once(part[i + 1], face_separator);
+                            if (fd.size() == 1) {
+                                face.i[i] = obj_index(fd[0], mesh.position.size());
+                                face.t[i] = -1;
+                                face.n[i] = -1;
+                            }
+                            else if (fd.size() == 2) {
+                                face.i[i] = obj_index(fd[0], mesh.position.size());
+                                face.t[i] = obj_index(fd[1], mesh.tex_coord.size());
+                                face.n[i] = -1;
+                            }
+                            else if (fd.size() == 3) {
+                                face.i[i] = obj_index(fd[0], mesh.position.size());
+                                if (std::string("").compare(fd[1]) != 0) {
+                                    face.t[i] = obj_index(fd[1], mesh.tex_coord.size());
+                                }
+                                else {
+                                    face.t[i] = -1;
+                                }
+                                face.n[i] = obj_index(fd[2], mesh.normal.size());
+                            }
+                            else {
+                                throw(std::ios_base::failure(std::string("Error: f parameter should have 1, 2, or 3 parameters separated by '/'")));
+                            }
+                        }
+                        mesh.face.push_back(face);
+                    }
+                }
+                else {
+                    throw(std::ios_base::failure(std::string("Error: f command should have 3 or 4 parameters")));
+                }
+            }
+            // Ignore other commands
+        }
+
+        // Close file
+        f.close();
+    }
+
+
+    void compute_vertex_normals(TriMesh& mesh) {
+
+        // Compute degree of each vertex
+        std::vector<int> degree(mesh.position.size(), 0);
+        for (unsigned int i = 0; i < mesh.face.size(); i++) {
+            for (int j = 0; j < 3; j++) {
+                degree[mesh.face[i].i[j]]++;
+            }
+        }
+
+        mesh.normal = std::vector<glm::vec3>(mesh.position.size(), glm::vec3(0.0, 0.0, 0.0));
+        for (unsigned int i = 0; i < mesh.face.size(); i++) {
+            // Compute face normal
+            glm::vec3 vec1, vec2;
+            vec1 = mesh.position[mesh.face[i].i[0]] -
+                mesh.position[mesh.face[i].i[1]];
+            vec2 = mesh.position[mesh.face[i].i[0]] -
+                mesh.position[mesh.face[i].i[2]];
+            glm::vec3 norm = glm::cross(vec1, vec2);
+            norm = glm::normalize(norm);
+            // Add face normal to vertices
+            mesh.normal[mesh.face[i].i[0]] += norm;
+            mesh.normal[mesh.face[i].i[1]] += norm;
+            mesh.normal[mesh.face[i].i[2]] += norm;
+        }
+        for (unsigned int i = 0; i < mesh.normal.size(); i++) {
+            if (degree[i] > 0) {
+                mesh.normal[i] /= degree[i];
+            }
+        }
+    }
+
+
+    void build_mesh_data(const TriMesh& mesh, bool vertex_normals, MeshData& data) {
+
+        // Create three new vertices for each face, in case vertex
+        // normals/texture coordinates are not consistent over the mesh
+        data.vertex.assign(mesh.face.size() * 3 * mesh_vertex_att, 0.0f);
+        data.index.resize(mesh.face.size() * 3);
+        data.bounds_min = glm::vec3(0.0);
+        data.bounds_max = glm::vec3(0.0);
+
+        GLfloat *att = data.vertex.data();
+        for (unsigned int i = 0; i < mesh.face.size(); i++) {
+            for (int j = 0; j < 3; j++) {
+                const glm::vec3 &pos = mesh.position[mesh.face[i].i[j]];
+                // Position
+                att[0] = pos[0];
+                att[1] = pos[1];
+                att[2] = pos[2];
+                // Normal
+                if (vertex_normals) {
+                    att[3] = mesh.normal[mesh.face[i].i[j]][0];
+                    att[4] = mesh.normal[mesh.face[i].i[j]][1];
+                    att[5] = mesh.normal[mesh.face[i].i[j]][2];
+                }
+                else {
+                    if (mesh.face[i].n[j] >= 0) {
+                        att[3] = mesh.normal[mesh.face[i].n[j]][0];
+                        att[4] = mesh.normal[mesh.face[i].n[j]][1];
+                        att[5] = mesh.normal[mesh.face[i].n[j]][2];
+                    }
+                }
+                // No color in (6, 7, 8)
+                // Texture coordinates
+                if (mesh.face[i].t[j] >= 0) {
+                    att[9] = mesh.tex_coord[mesh.face[i].t[j]][0];
+                    att[10] = mesh.tex_coord[mesh.face[i].t[j]][1];
+                }
+                att += mesh_vertex_att;
+
+                // Add triangle
+                data.index[i * 3 + j] = i * 3 + j;
+
+                // Grow the bounds
+                if ((i == 0) && (j == 0)) {
+                    data.bounds_min = pos;
+                    data.bounds_max = pos;
+                }
+                else {
+                    data.bounds_min = glm::min(data.bounds_min, pos);
+                    data.bounds_max = glm::max(data.bounds_max, pos);
+                }
+            }
+        }
+    }
+
+
     void print_mesh(TriMesh& mesh) {
 
         for (unsigned int i = 0; i < mesh.position.size(); i++) {
@@ -993,26 +1843,6 @@ namespace game {
     }
 
 
-    template <typename T> std::string num_to_str(T num) {
-
-        std::ostringstream ss;
-        ss << num;
-        return ss.str();
-    }
-
-
-    template <typename T> T str_to_num(const std::string& str) {
-
-        std::istringstream ss(str);
-        T result;
-        ss >> result;
-        if (ss.fail()) {
-            throw(std::ios_base::failure(std::string("Invalid number: ") + str));
-        }
-        return result;
-    }
-
-
     void ResourceManager::CreateSphere(std::string object_name, float radius, int num_samples_theta, int num_samples_phi) {
 
         // Create a sphere using a well-known parameterization
@@ -1099,19 +1929,24 @@ namespace game {
 
         GLuint vbo, ebo;
         glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, vbo);
         glBufferData(GL_ARRAY_BUFFER, vertex_num * vertex_att * sizeof(GLfloat), vertex, GL_STATIC_DRAW);
 
         glGenBuffers(1, &ebo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, face_num * face_att * sizeof(GLuint), face, GL_STATIC_DRAW);
 
+        // Bounds of the geometry, for culling
+        glm::vec3 bounds_min, bounds_max;
+        vertex_bounds(vertex, vertex_num, vertex_att, bounds_min, bounds_max);
+
         // Free data buffers
         delete[] vertex;
         delete[] face;
 
         // Create resource
-        AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
+        Resource *res = AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
+        res->SetBounds(bounds_min, bounds_max);
     }
 
 
@@ -1211,19 +2046,24 @@ namespace game {
 
         GLuint vbo, ebo;
         glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, vbo);
         glBufferData(GL_ARRAY_BUFFER, vertex_num * vertex_att * sizeof(GLfloat), vertex, GL_STATIC_DRAW);
 
         glGenBuffers(1, &ebo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, face_num * face_att * sizeof(GLuint), face, GL_STATIC_DRAW);
 
+        // Bounds of the geometry, for culling
+        glm::vec3 bounds_min, bounds_max;
+        vertex_bounds(vertex, vertex_num, vertex_att, bounds_min, bounds_max);
+
         // Free data buffers
         delete[] vertex;
         delete[] face;
 
         // Create resource
-        AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
+        Resource *res = AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
+        res->SetBounds(bounds_min, bounds_max);
     }
 
     void ResourceManager::CreateCubeInverted(std::string object_name) {
@@ -1271,15 +2111,20 @@ namespace game {
         GLuint vbo, ebo;
 
         glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, vbo);
         glBufferData(GL_ARRAY_BUFFER, 14 * 11 * sizeof(GLfloat), vertex, GL_STATIC_DRAW);
 
         glGenBuffers(1, &ebo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, 2 * 3 * 6 * sizeof(GLuint), face, GL_STATIC_DRAW);
 
+        // Bounds of the geometry, for culling
+        glm::vec3 bounds_min, bounds_max;
+        vertex_bounds(vertex, 14, 11, bounds_min, bounds_max);
+
         // Create resource
-        AddResource(Mesh, object_name, vbo, ebo, 2 * 3 * 6);
+        Resource *res = AddResource(Mesh, object_name, vbo, ebo, 2 * 3 * 6);
+        res->SetBounds(bounds_min, bounds_max);
     }
 
     void ResourceManager::CreateWall(std::string object_name) {
@@ -1300,15 +2145,20 @@ namespace game {
         GLuint vbo, ebo;
 
         glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, vbo);
         glBufferData(GL_ARRAY_BUFFER, 4 * 11 * sizeof(GLfloat), vertex, GL_STATIC_DRAW);
 
         glGenBuffers(1, &ebo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, 2 * 3 * sizeof(GLuint), face, GL_STATIC_DRAW);
 
+        // Bounds of the geometry, for culling
+        glm::vec3 bounds_min, bounds_max;
+        vertex_bounds(vertex, 4, 11, bounds_min, bounds_max);
+
         // Create resource
-        AddResource(Mesh, object_name, vbo, ebo, 2 * 3);
+        Resource *res = AddResource(Mesh, object_name, vbo, ebo, 2 * 3);
+        res->SetBounds(bounds_min, bounds_max);
     }
 
     void ResourceManager::CreateWall2(std::string object_name)
@@ -1330,15 +2180,20 @@ namespace game {
         GLuint vbo, ebo;
 
         glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, vbo);
         glBufferData(GL_ARRAY_BUFFER, 4 * 11 * sizeof(GLfloat), vertex, GL_STATIC_DRAW);
 
         glGenBuffers(1, &ebo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, 2 * 3 * sizeof(GLuint), face, GL_STATIC_DRAW);
 
+        // Bounds of the geometry, for culling
+        glm::vec3 bounds_min, bounds_max;
+        vertex_bounds(vertex, 4, 11, bounds_min, bounds_max);
+
         // Create resource
-        AddResource(Mesh, object_name, vbo, ebo, 2 * 3);
+        Resource *res = AddResource(Mesh, object_name, vbo, ebo, 2 * 3);
+        res->SetBounds(bounds_min, bounds_max);
     }
 
 
@@ -1392,20 +2247,36 @@ namespace game {
                 particle[i * particle_att + k + 3] = normal[k];
                 particle[i * particle_att + k + 6] = color[k];
             }
+            // No texture coordinates
+            particle[i * particle_att + 9] = 0.0;
+            particle[i * particle_att + 10] = 0.0;
 
         }
 
+        // Store the particles in the current vertex format
+        std::vector<unsigned char> packed;
+        VertexLayout layout;
+        pack_point_set(particle, num_particles, vertex_format_, packed, layout);
+
         // Create OpenGL buffer and copy data
         GLuint vbo;
         glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, num_particles * particle_att * sizeof(GLfloat), particle, GL_STATIC_DRAW);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, packed.size(), packed.data(), GL_STATIC_DRAW);
+
+        // Bounds of the particles where they start, for culling
+        glm::vec3 bounds_min, bounds_max;
+        vertex_bounds(particle, num_particles, particle_att, bounds_min, bounds_max);
 
         // Free data buffers
         delete[] particle;
 
         // Create resource
-        AddResource(PointSet, object_name, vbo, 0, num_particles);
+        Resource* res = new Resource(PointSet, object_name, vbo, 0, num_particles);
+        res->SetLayout(layout);
+        res->SetBounds(bounds_min, bounds_max);
+        InsertResource(res);
+        SetResidentBytes(res, packed.size());
     }
 
     float ResourceManager::getRand() {
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
 #define GLEW_STATIC
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -10,6 +11,10 @@
 #include <glm/gtc/constants.hpp>
 
 #include "resource.h"
+#include "mesh_cache.h"
+#include "mesh_optimizer.h"
+#include "vertex_format.h"
+#include "geometry_pool.h"
 
 // Default extensions for different shader source files
 #define VERTEX_PROGRAM_EXTENSION "_vp.glsl"
@@ -23,6 +28,52 @@ namespace game {
         glm::vec3 normals;
     };
 
+    // Time spent loading meshes, split between meshes read from the binary
+    // cache and meshes parsed from OBJ files
+    struct MeshLoadStats {
+        int num_cached;
+        int num_parsed;
+        double cached_ms;
+        double parsed_ms;
+    };
+
+    // Time spent creating shader programs, split between programs loaded
+    // from the binary cache and programs compiled from source
+    struct ProgramLoadStats {
+        int num_cached;
+        int num_compiled;
+        double cached_ms;
+        double compiled_ms;
+    };
+
+    // Shader programs of a material, read from their source files
+    struct MaterialSource {
+        std::string prefix; // Files the sources were read from
+        std::string vp;
+        std::string fp;
+        std::string gp;
+        bool geometry_program;
+    };
+
+    // Image decoded from a file, waiting to be copied to a texture
+    struct TextureImage {
+        unsigned char *pixels;
+        int width;
+        int height;
+        int channels;
+    };
+
+    // Mesh read from disk, either mapped from its cache or built from the
+    // OBJ file
+    struct MeshSource {
+        MeshCache cache;
+        PackedMesh data;
+        VertexFormat format; // Format the mesh was read in
+        bool cached;
+        double load_ms; // Time spent reading the mesh
+        MeshOptimizeStats stats; // Set if the mesh was built from the OBJ file
+    };
+
     // Class that manages all resources
     class ResourceManager {
 
@@ -33,11 +84,63 @@ namespace game {
             ~ResourceManager();
             // Add a resource that was already loaded and allocated to memory
             void AddResource(ResourceType type, const std::string name, GLuint resource, GLsizei size);
-            void AddResource(ResourceType type, const std::string name, GLuint array_buffer, GLuint element_array_buffer, GLsizei size);
-            // Load a resource from a file, according to the specified type
+            Resource *AddResource(ResourceType type, const std::string name, GLuint array_buffer, GLuint element_array_buffer, GLsizei size);
+            // Load a resource from a file, according to the specified type.
+            // Nothing is done if a resource with the name is already loaded
             void LoadResource(ResourceType type, const std::string name, const char *filename);
-            // Get the resource with the specified name
-            Resource *GetResource(const std::string name) const;
+            // Get the resource with the specified name. A resource that was
+            // evicted is loaded again from its file
+            Resource *GetResource(const std::string name);
+            // Get handles to resources of each kind. The handle is null if
+            // there is no resource of that kind with the name
+            MeshHandle GetMesh(const std::string name) const;
+            MaterialHandle GetMaterial(const std::string name) const;
+            TextureHandle GetTexture(const std::string name) const;
+            // Get the resource a handle refers to, or NULL if the handle is
+            // null or the resource is gone. Evicted resources are reloaded
+            Resource *GetResource(MeshHandle handle);
+            Resource *GetResource(MaterialHandle handle);
+            Resource *GetResource(TextureHandle handle);
+            // Read resources from files without calling OpenGL. These are
+            // safe to call from worker threads
+            static void ReadMaterial(const char *prefix, MaterialSource &source);
+            static void ReadTexture(const char *filename, TextureImage &image);
+            static void ReadMesh(const char *filename, VertexFormat format, MeshSource &source);
+            // Create the OpenGL objects for resources read by the methods
+            // above and add them. Must be called from the thread that owns
+            // the OpenGL context. AddTexture frees the image pixels. If the
+            // file name is given, the resource can be evicted and reloaded
+            void AddMaterial(const std::string name, const MaterialSource &source);
+            void AddTexture(const std::string name, TextureImage &image, const char *filename = NULL);
+            void AddMesh(const std::string name, const MeshSource &source, const char *filename = NULL);
+            // Copy loaded textures of the same size and format into the
+            // layers of a new GL_TEXTURE_2D_ARRAY added under name.
+            // Textures read from the same file share a layer. The textures
+            // then refer to the array and their layer, their own objects
+            // are deleted, and they are no longer evicted. Materials that
+            // draw them must sample a sampler2DArray
+            void PackTextureArray(const std::string name, const std::vector<std::string> &textures);
+            // Format used for meshes loaded from files and for point sets
+            // created afterwards
+            void SetVertexFormat(VertexFormat format);
+            VertexFormat GetVertexFormat(void) const;
+            // Get the time spent loading meshes so far
+            const MeshLoadStats &GetMeshLoadStats(void) const;
+            // Get the time spent creating shader programs so far
+            const ProgramLoadStats &GetProgramLoadStats(void) const;
+            // Limit on the GPU memory of meshes and textures, in bytes. Zero
+            // means no limit. When the limit is exceeded, Trim evicts the
+            // least recently used meshes and textures that no scene node
+            // holds and that can be read again from their files
+            void SetMemoryBudget(size_t bytes);
+            size_t GetMemoryBudget(void) const;
+            size_t GetResidentBytes(ResourceType type) const;
+            void Trim(void);
+            // Print the GPU memory used by each type of resource
+            void PrintMemoryStats(void) const;
+            // Delete the OpenGL objects of all resources. Must be called
+            // while the OpenGL context still exists
+            void Clear(void);
 
             // Methods to create specific resources
             // Create the geometry for a torus and add it to the list of resources
@@ -62,8 +165,24 @@ namespace game {
 			
         private:
            
-            // List storing all resources
+            // List storing all resources. A handle holds the index of a
+            // resource and the generation of its slot. Generations are
+            // kept across Clear, so that older handles stay stale
             std::vector<Resource*> resource_; 
+            std::vector<unsigned int> generation_;
+            // Index of the first resource added under each name
+            std::unordered_map<std::string, unsigned int> name_index_;
+            MeshLoadStats mesh_stats_;
+            ProgramLoadStats program_stats_;
+            VertexFormat vertex_format_;
+            // GPU memory in use by each type of resource, and the limit
+            size_t resident_bytes_[num_resource_types];
+            size_t memory_budget_;
+            unsigned long use_clock_; // Counts lookups, to order them
+            int num_evicted_;
+            int num_reloaded_;
+            // Shared buffers of static meshes, by vertex layout
+            std::vector<GeometryPool *> geometry_pool_;
  
             // Methods to load specific types of resources
             // Load shaders programs
@@ -71,11 +190,45 @@ namespace game {
             float getRand();
             // Load a texture from an image file: png, jpg, etc.
             void LoadTexture(const std::string name, const char* filename);
+            // Compile and link the shaders of a material
+            static GLuint CompileProgram(const MaterialSource &source, bool retrievable);
+            // Find the locations of the inputs of a program by going through
+            // its active uniforms and attributes, and bind the samplers to
+            // their texture units
+            static void ReflectProgram(GLuint program, ProgramLocations &locations);
             // Load a text file into memory (could be source code)
-            std::string LoadTextFile(const char *filename);
+            static std::string LoadTextFile(const char *filename);
             // Loads a mesh in obj format
             void LoadMesh(const std::string name, const char* filename);
+            // Copy interleaved vertices and triangle indices to OpenGL
+            // buffers and add them as a mesh resource. lod gives the ranges
+            // of the index buffer that hold each level of detail
+            Resource *AddMesh(const std::string name, const void *vertex, size_t vertex_bytes, const void *index, GLsizei num_indices, const VertexLayout &layout, const glm::vec3 &bounds_min, const glm::vec3 &bounds_max, const MeshLod *lod, int num_lods);
+            // Create the OpenGL objects of meshes and textures. These are
+            // shared by adding and reloading. Meshes go to a geometry pool
+            // of their layout, or get buffers of their own if too large
+            void CreateMeshBuffers(const void *vertex, size_t vertex_bytes, const void *index, GLsizei num_indices, const VertexLayout &layout, GLuint &vbo, GLuint &ebo, GeometryRange &range);
+            static GLuint CreateTexture(TextureImage &image);
             double getAugmentedPos(glm::vec2, HeightMap);
+            // Store a new resource and index it by name
+            void InsertResource(Resource *res);
+            // Find the slot of a resource by name, checking its type
+            bool FindSlot(const std::string &name, ResourceType type, ResourceType alt_type, unsigned int &index) const;
+            // Get the resource in a slot if the generation matches
+            Resource *GetSlot(unsigned int index, unsigned int generation) const;
+            // Count the GPU memory of a new resource
+            void SetResidentBytes(Resource *res, size_t bytes);
+            // Mark a resource as used now, reloading it if it was evicted
+            Resource *Touch(Resource *res);
+            // Delete the OpenGL objects of a resource, or create them again
+            // from its file
+            void Evict(Resource *res);
+            void Reload(Resource *res);
+            // Delete the OpenGL objects of a resource, or free its part of
+            // a geometry pool
+            void DeleteObjects(Resource *res);
+            // Pool that owns an array buffer, or NULL
+            GeometryPool *FindPool(GLuint array_buffer) const;
 
     }; // class ResourceManager
 
@@ -0,0 +1,53 @@
+#include "sampler_cache.h"
+#include "gl_state.h"
+
+namespace game {
+
+    std::map<SamplerCache::Key, GLuint> SamplerCache::sampler_;
+
+
+    bool SamplerCache::Key::operator<(const Key &other) const {
+
+        if (min_filter != other.min_filter) {
+            return min_filter < other.min_filter;
+        }
+        if (mag_filter != other.mag_filter) {
+            return mag_filter < other.mag_filter;
+        }
+        return wrap < other.wrap;
+    }
+
+
+    GLuint SamplerCache::Get(GLint min_filter, GLint mag_filter, GLint wrap) {
+
+        if (!(GLEW_VERSION_3_3 || GLEW_ARB_sampler_objects)) {
+            return 0;
+        }
+
+        Key key = { min_filter, mag_filter, wrap };
+        std::map<Key, GLuint>::const_iterator it = sampler_.find(key);
+        if (it != sampler_.end()) {
+            return it->second;
+        }
+
+        GLuint sampler;
+        glGenSamplers(1, &sampler);
+        glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, min_filter);
+        glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, mag_filter);
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, wrap);
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, wrap);
+        sampler_[key] = sampler;
+        return sampler;
+    }
+
+
+    void SamplerCache::Clear(void) {
+
+        for (std::map<Key, GLuint>::iterator it = sampler_.begin(); it != sampler_.end(); ++it) {
+            GLState::ForgetSampler(it->second);
+            glDeleteSamplers(1, &it->second);
+        }
+        sampler_.clear();
+    }
+
+} // namespace game
@@ -0,0 +1,37 @@
+#ifndef SAMPLER_CACHE_H_
+#define SAMPLER_CACHE_H_
+
+#include <map>
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+namespace game {
+
+    // Sampler objects shared by every texture drawn with the same
+    // filtering. A sampler bound to a unit overrides the parameters of the
+    // texture bound there, so textures themselves keep no draw state.
+    // Samplers are only used from the thread that owns the OpenGL context
+    class SamplerCache {
+
+        public:
+            // Get the sampler with some filters and wrap mode, creating it
+            // on first use. Returns 0, which leaves the parameters of the
+            // texture in effect, if the driver has no sampler objects
+            static GLuint Get(GLint min_filter, GLint mag_filter, GLint wrap);
+            // Delete all samplers
+            static void Clear(void);
+
+        private:
+            struct Key {
+                GLint min_filter;
+                GLint mag_filter;
+                GLint wrap;
+                bool operator<(const Key &other) const;
+            };
+            static std::map<Key, GLuint> sampler_;
+
+    }; // class SamplerCache
+
+} // namespace game
+
+#endif // SAMPLER_CACHE_H_
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#define GLM_FORCE_RADIANS
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "scene_benchmark.h"
+#include "scene_graph.h"
+#include "resource_manager.h"
+#include "model_loader.h"
+#include "transform_kernel.h"
+
+namespace game {
+
+    namespace {
+
+        // About as many resources of each kind as the game loads
+        const int benchmark_num_meshes = 24;
+        const int benchmark_num_materials = 12;
+        const int benchmark_num_textures = 32;
+        // Transforms in each chain of parents, and times the matrices of
+        // all of them are computed
+        const int benchmark_chain_length = 4;
+        const int benchmark_transform_passes = 20;
+
+
+    } // namespace
+
+
+    void benchmark_world_construction(int num_instances) {
+
+        // Resources without OpenGL objects behind them; nodes only read
+        // their attributes
+        ResourceManager resman;
+        std::vector<std::string> mesh_name, material_name, texture_name;
+        for (int i = 0; i < benchmark_num_meshes; i++) {
+            mesh_name.push_back("BenchmarkMesh" + num_to_str<int>(i));
+            resman.AddResource(Mesh, mesh_name.back(), 0, 0, 0);
+        }
+        for (int i = 0; i < benchmark_num_materials; i++) {
+            material_name.push_back("BenchmarkMaterial" + num_to_str<int>(i));
+            resman.AddResource(Material, material_name.back(), 0, 0);
+        }
+        for (int i = 0; i < benchmark_num_textures; i++) {
+            texture_name.push_back("BenchmarkTexture" + num_to_str<int>(i));
+            resman.AddResource(Texture, texture_name.back(), 0, 0);
+        }
+
+        std::vector<std::string> node_name(num_instances);
+        for (int i = 0; i < num_instances; i++) {
+            node_name[i] = "Instance" + num_to_str<int>(i);
+        }
+
+        // Look up the four resources of every node by name, as the scene
+        // setup used to. Only the construction is timed; the scenes are
+        // torn down after the timer stops
+        std::chrono::steady_clock::time_point start;
+        double by_name_ms, by_handle_ms;
+        {
+            SceneGraph scene;
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < num_instances; i++) {
+                Resource *geom = resman.GetResource(mesh_name[i % benchmark_num_meshes]);
+                Resource *mat = resman.GetResource(material_name[i % benchmark_num_materials]);
+                Resource *tex = resman.GetResource(texture_name[i % benchmark_num_textures]);
+                Resource *norm = resman.GetResource(texture_name[(i + 1) % benchmark_num_textures]);
+                scene.CreateNode(node_name[i], geom, mat, tex, norm);
+            }
+            by_name_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        // Resolve handles once per kind of node, then only follow them
+        {
+            SceneGraph scene;
+            start = std::chrono::steady_clock::now();
+            std::vector<MeshHandle> mesh(benchmark_num_meshes);
+            std::vector<MaterialHandle> material(benchmark_num_materials);
+            std::vector<TextureHandle> texture(benchmark_num_textures);
+            for (int i = 0; i < benchmark_num_meshes; i++) {
+                mesh[i] = resman.GetMesh(mesh_name[i]);
+            }
+            for (int i = 0; i < benchmark_num_materials; i++) {
+                material[i] = resman.GetMaterial(material_name[i]);
+            }
+            for (int i = 0; i < benchmark_num_textures; i++) {
+                texture[i] = resman.GetTexture(texture_name[i]);
+            }
+
+            for (int i = 0; i < num_instances; i++) {
+                Resource *geom = resman.GetResource(mesh[i % benchmark_num_meshes]);
+                Resource *mat = resman.GetResource(material[i % benchmark_num_materials]);
+                Resource *tex = resman.GetResource(texture[i % benchmark_num_textures]);
+                Resource *norm = resman.GetResource(texture[(i + 1) % benchmark_num_textures]);
+                scene.CreateNode(node_name[i], geom, mat, tex, norm);
+            }
+            by_handle_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        std::cout << "World construction, " << num_instances << " instances: " <<
+            by_name_ms << " ms by name, " << by_handle_ms << " ms by handle" << std::endl;
+    }
+
+
+
+    void benchmark_transforms(int num_nodes) {
+
+        std::vector<glm::vec3> position(num_nodes), scale(num_nodes);
+        std::vector<glm::quat> orientation(num_nodes);
+        std::vector<glm::mat4> orbit(num_nodes, glm::mat4(1.0));
+        std::vector<unsigned int> parent(num_nodes);
+        for (int i = 0; i < num_nodes; i++) {
+            float t = (float) i;
+            position[i] = glm::vec3(std::sin(t), std::cos(t), 0.1f * t);
+            scale[i] = glm::vec3(1.0f + 0.5f * std::sin(t), 1.0f, 2.0f);
+            orientation[i] = glm::angleAxis(t, glm::normalize(glm::vec3(std::sin(t), 1.0f, std::cos(t))));
+            parent[i] = (i % benchmark_chain_length) ? i - 1 : ~0u;
+        }
+
+        // Local and world matrices multiplied out, and the normal matrix
+        // inverted, as SceneNode::SetupShader did for every node
+        std::vector<glm::mat4> world(num_nodes), model(num_nodes), normal(num_nodes);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < benchmark_transform_passes; pass++) {
+            for (int i = 0; i < num_nodes; i++) {
+                glm::mat4 local = glm::translate(glm::mat4(1.0), position[i]) * orbit[i] * glm::mat4_cast(orientation[i]);
+                world[i] = (parent[i] != ~0u) ? world[parent[i]] * local : local;
+                model[i] = world[i] * glm::scale(glm::mat4(1.0), scale[i]);
+                normal[i] = glm::transpose(glm::inverse(model[i]));
+            }
+        }
+        double glm_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Transforms, " << num_nodes << " nodes: glm " <<
+            (num_nodes * 1e-6 * benchmark_transform_passes / glm_s) << " M nodes/s";
+
+        std::vector<glm::mat4> local(num_nodes);
+        std::vector<unsigned int> version(num_nodes, 0);
+        std::vector<unsigned char> dirty(num_nodes), changed(num_nodes);
+        TransformBatch batch;
+        batch.count = num_nodes;
+        batch.position = &position[0];
+        batch.orientation = &orientation[0];
+        batch.orbit = &orbit[0];
+        batch.scale = &scale[0];
+        batch.parent = &parent[0];
+        batch.dirty = &dirty[0];
+        batch.changed = &changed[0];
+        batch.local = &local[0];
+        batch.world = &world[0];
+        batch.model = &model[0];
+        batch.normal = &normal[0];
+        batch.version = &version[0];
+        for (int k = 0; k < num_transform_kernels; k++) {
+            TransformKernel kernel = (TransformKernel) k;
+            if (!is_transform_kernel_supported(kernel)) {
+                continue;
+            }
+            // Everything moved, so that the whole batch is computed
+            double kernel_s = 0.0;
+            for (int pass = 0; pass < benchmark_transform_passes; pass++) {
+                std::fill(dirty.begin(), dirty.end(), 1);
+                start = std::chrono::steady_clock::now();
+                compute_transforms(batch, kernel);
+                kernel_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+            std::cout << ", " << get_transform_kernel_name(kernel) << " " <<
+                (num_nodes * 1e-6 * benchmark_transform_passes / kernel_s) << " M nodes/s";
+        }
+        std::cout << std::endl;
+    }
+
+} // namespace game
@@ -0,0 +1,17 @@
+#ifndef SCENE_BENCHMARK_H_
+#define SCENE_BENCHMARK_H_
+
+namespace game {
+
+    // Time building a synthetic world of num_instances scene nodes, once
+    // looking up the resources of every node by name and once with handles
+    // resolved beforehand. Needs no OpenGL context
+    void benchmark_world_construction(int num_instances);
+    // Time computing the world and normal matrices of num_nodes
+    // transforms in chains of a few, with glm as the scene nodes used to
+    // and with each transform kernel this processor supports
+    void benchmark_transforms(int num_nodes);
+
+} // namespace game
+
+#endif // SCENE_BENCHMARK_H_
@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 #include <fstream>
@@ -8,6 +9,11 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "scene_graph.h"
+#include "render_stats.h"
+#include "vertex_array_cache.h"
+#include "gl_state.h"
+#include "transform_system.h"
+#include "node_pool.h"
 
 namespace game {
 
@@ -15,10 +21,33 @@ SceneGraph::SceneGraph(void){
 
     background_color_ = glm::vec3(0.0, 0.0, 0.0);
     startTime_ = 0;
+    skyBox_ = NULL;
 }
 
 
 SceneGraph::~SceneGraph(){
+
+    Clear();
+}
+
+
+void SceneGraph::Clear(void){
+
+    // Removed nodes are still in the lists until the flush
+    removed_nodes_.clear();
+    for (int i = 0; i < node_.size(); i++){
+        NodePool::Destroy(node_[i]);
+    }
+    for (int i = 0; i < effects_.size(); i++){
+        NodePool::Destroy(effects_[i]);
+    }
+    NodePool::Destroy(skyBox_);
+    node_.clear();
+    effects_.clear();
+    collidable_nodes_.clear();
+    name_index_.clear();
+    collidable_index_.clear();
+    skyBox_ = NULL;
 }
 
 
@@ -37,10 +66,10 @@ glm::vec3 SceneGraph::GetBackgroundColor(void) const {
 SceneNode *SceneGraph::CreateNode(std::string node_name, Resource *geometry, Resource *material, Resource *texture, Resource *normal_map){
 
     // Create scene node with the specified resources
-    SceneNode *scn = new SceneNode(node_name, geometry, material, texture, normal_map);
+    SceneNode *scn = NodePool::Create<SceneNode>(node_name, geometry, material, texture, normal_map);
 
     // Add node to the scene
-    node_.push_back(scn);
+    InsertNode(scn);
 
     return scn;
 }
@@ -48,10 +77,11 @@ SceneNode *SceneGraph::CreateNode(std::string node_name, Resource *geometry, Res
 
 void SceneGraph::AddNode(SceneNode *node, Options x){
     if (node->GetCollidable()) {
+        collidable_index_[node] = (unsigned int) collidable_nodes_.size();
         collidable_nodes_.push_back(node);
     }
     if (x == OBJ) {
-        node_.push_back(node);
+        InsertNode(node);
     }
     else if (x == EFFECTS) {
         
@@ -61,34 +91,106 @@ void SceneGraph::AddNode(SceneNode *node, Options x){
 }
 
 
-SceneNode *SceneGraph::GetNode(std::string node_name) const {
+void SceneGraph::InsertNode(SceneNode *node) {
+
+    std::unordered_map<std::string, NameEntry>::iterator name = name_index_.find(node->GetName());
+    if (name == name_index_.end()) {
+        NameEntry entry = { (unsigned int) node_.size(), 0 };
+        name = name_index_.insert(std::make_pair(node->GetName(), entry)).first;
+    }
+    name->second.count++;
+    node_.push_back(node);
+}
+
+
+SceneNode *SceneGraph::GetNode(const std::string &node_name) const {
 
     // Find node with the specified name
-    for (int i = 0; i < node_.size(); i++){
-        if (node_[i]->GetName() == node_name){
-            return node_[i];
-        }
+    std::unordered_map<std::string, NameEntry>::const_iterator it = name_index_.find(node_name);
+    if (it == name_index_.end()) {
+        return NULL;
     }
-    return NULL;
+    return node_[it->second.index];
+}
+
 
+void SceneGraph::RemoveCollidable(SceneNode *node) {
+
+    if ((collidable_index_.count(node) == 0) ||
+        (std::find(removed_nodes_.begin(), removed_nodes_.end(), node) != removed_nodes_.end())) {
+        return;
+    }
+    removed_nodes_.push_back(node);
 }
 
-void SceneGraph::RemoveCollidable(std::string node_name) {
-    for (int i = 0; i < collidable_nodes_.size(); i++) {
-        if (collidable_nodes_[i]->GetName() == node_name) {
-            collidable_nodes_.erase(collidable_nodes_.begin() + i);
-            RemoveNode(node_name);
-            break;
-        }
+
+void SceneGraph::FlushRemovals(void) {
+
+    for (size_t i = 0; i < removed_nodes_.size(); i++) {
+        RemoveNode(removed_nodes_[i]);
+        NodePool::Destroy(removed_nodes_[i]);
     }
+    removed_nodes_.clear();
 }
 
+
 // remove from main graph, this is private
-void SceneGraph::RemoveNode(std::string node_name) {
-    for (int i = 0; i < node_.size(); i++) {
-        if (node_[i]->GetName() == node_name) {
-            node_.erase(node_.begin() + i);
-            break;
+void SceneGraph::RemoveNode(SceneNode *node) {
+
+    std::unordered_map<SceneNode *, unsigned int>::iterator collidable = collidable_index_.find(node);
+    if (collidable != collidable_index_.end()) {
+        unsigned int index = collidable->second;
+        collidable_index_.erase(collidable);
+        if (index + 1 < collidable_nodes_.size()) {
+            collidable_nodes_[index] = collidable_nodes_.back();
+            collidable_index_[collidable_nodes_[index]] = index;
+        }
+        collidable_nodes_.pop_back();
+    }
+
+    // The name index finds the node unless another one of the same name
+    // is indexed instead
+    std::unordered_map<std::string, NameEntry>::iterator name = name_index_.find(node->GetName());
+    bool indexed = (name != name_index_.end()) && (node_[name->second.index] == node);
+    unsigned int index;
+    if (indexed) {
+        index = name->second.index;
+    }
+    else {
+        std::vector<SceneNode *>::iterator it = std::find(node_.begin(), node_.end(), node);
+        if (it == node_.end()) {
+            // Effects are few, and keep their order for blending
+            it = std::find(effects_.begin(), effects_.end(), node);
+            if (it != effects_.end()) {
+                effects_.erase(it);
+            }
+            return;
+        }
+        index = (unsigned int) (it - node_.begin());
+    }
+    unsigned int last = (unsigned int) node_.size() - 1;
+    if (index != last) {
+        node_[index] = node_[last];
+        std::unordered_map<std::string, NameEntry>::iterator moved = name_index_.find(node_[index]->GetName());
+        if ((moved != name_index_.end()) && (moved->second.index == last)) {
+            moved->second.index = index;
+        }
+    }
+    node_.pop_back();
+
+    // Point the entry at another node of the name, if any is left
+    if (name == name_index_.end()) {
+        return;
+    }
+    if (--name->second.count == 0) {
+        name_index_.erase(name);
+    }
+    else if (indexed) {
+        for (unsigned int i = 0; i < node_.size(); i++) {
+            if (node_[i]->GetName() == name->first) {
+                name->second.index = i;
+                break;
+            }
         }
     }
 }
@@ -110,20 +212,20 @@ void SceneGraph::AlphaBlending(bool set)
 {
     if (set) {
         // Disable depth write
-        glEnable(GL_DEPTH_TEST);
-        glDepthMask(GL_FALSE);
+        GLState::Enable(GL_DEPTH_TEST);
+        GLState::DepthMask(GL_FALSE);
 
         // Enable blending
-        glEnable(GL_BLEND);
+        GLState::Enable(GL_BLEND);
         //glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Simpler form
-        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glBlendEquationSeparate(GL_FUNC_ADD, GL_MAX);
+        GLState::BlendFuncSeparate(GL_SRC_ALPHA, GL_ONE, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        GLState::BlendEquationSeparate(GL_FUNC_ADD, GL_MAX);
     }
     else {
         // Enable z-buffer
-        glDepthMask(GL_TRUE);
-        glDepthFunc(GL_LESS);
-        glDisable(GL_BLEND);
+        GLState::DepthMask(GL_TRUE);
+        GLState::DepthFunc(GL_LESS);
+        GLState::Disable(GL_BLEND);
     }
 }
 
@@ -137,22 +239,33 @@ void SceneGraph::Draw(Camera *camera, Options x, bool first){
     }
     
     if (x == OBJ) {
-        glDepthMask(GL_FALSE);
+        GLState::DepthMask(GL_FALSE);
         skyBox_->Draw(camera);
-        glDepthMask(GL_TRUE);
+        GLState::DepthMask(GL_TRUE);
 
 
-        // Draw all scene nodes
+        // Draw the scene nodes in view, grouped by state and front to
+        // back
+        Frustum frustum(camera->GetProjectionMatrix() * camera->GetViewMatrix());
+        queue_.Clear();
         for (int i = 0; i < node_.size(); i++){
-            node_[i]->Draw(camera);
+            node_[i]->UpdateBounds();
+            queue_.Add(node_[i], camera, frustum, OpaquePass);
         }
+        queue_.Sort();
+        queue_.Submit(camera);
     } else if (x == EFFECTS) {
-        // Draw all scene nodes
+        // Draw the effects in view, back to front for blending
         //std::cout << "print effects" <<  std::endl;
+        Frustum frustum(camera->GetProjectionMatrix() * camera->GetViewMatrix());
+        queue_.Clear();
         for (int i = 0; i < effects_.size(); i++) {
-            effects_[i]->Draw(camera);
+            effects_[i]->UpdateBounds();
+            queue_.Add(effects_[i], camera, frustum, BlendedPass);
             //std::cout << "print " << effects_[i]->GetPosition().z <<  std::endl;
         }
+        queue_.Sort();
+        queue_.Submit(camera);
     }
 }
 
@@ -166,6 +279,10 @@ void SceneGraph::Update(float delta_time){
     for (int j = 0; j < effects_.size(); j++) {
         effects_[j]->Update(delta_time);
     }
+
+    // Compute the transforms that the updates changed, in one sweep
+    // before any draw asks for them
+    TransformSystem::Update();
 }
 
 
@@ -174,11 +291,11 @@ void SceneGraph::SetupDrawToTexture(void) {
 
     // Set up frame buffer
     glGenFramebuffers(1, &frame_buffer_);
-    glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_);
+    GLState::BindFramebuffer(frame_buffer_);
 
     // Set up target texture for rendering
     glGenTextures(1, &texture_);
-    glBindTexture(GL_TEXTURE_2D, texture_);
+    GLState::BindTexture(0, GL_TEXTURE_2D, texture_);
 
     // Set up an image for the texture
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
@@ -202,7 +319,7 @@ void SceneGraph::SetupDrawToTexture(void) {
     }
 
     // Reset frame buffer
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::BindFramebuffer(0);
 
     // Set up quad for drawing to the screen
     static const GLfloat quad_vertex_data[] = {
@@ -216,7 +333,7 @@ void SceneGraph::SetupDrawToTexture(void) {
 
     // Create buffer for quad
     glGenBuffers(1, &quad_array_buffer_);
-    glBindBuffer(GL_ARRAY_BUFFER, quad_array_buffer_);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, quad_array_buffer_);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertex_data), quad_vertex_data, GL_STATIC_DRAW);
 }
 
@@ -228,7 +345,7 @@ void SceneGraph::DrawToTexture(Camera* camera) {
     glGetIntegerv(GL_VIEWPORT, viewport);
 
     // Enable frame buffer
-    glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_);
+    GLState::BindFramebuffer(frame_buffer_);
     glViewport(0, 0, FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT);
 
     // Clear background
@@ -245,14 +362,14 @@ void SceneGraph::DrawToTexture(Camera* camera) {
     AlphaBlending(false);
 
     // Reset frame buffer
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::BindFramebuffer(0);
 
     // Restore viewport
     glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
 }
 
 
-float SceneGraph::DisplayTexture(GLuint program) {
+float SceneGraph::DisplayTexture(const Resource *material) {
 
     if (startTime_ == 0) {
         startTime_ = glfwGetTime();
@@ -260,38 +377,51 @@ float SceneGraph::DisplayTexture(GLuint program) {
 
     // Configure output to the screen
     //glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glDisable(GL_DEPTH_TEST);
-
-    // Set up quad geometry
-    glBindBuffer(GL_ARRAY_BUFFER, quad_array_buffer_);
+    GLState::Disable(GL_DEPTH_TEST);
 
     // Select proper material (shader program)
-    glUseProgram(program);
-
-    // Setup attributes of screen-space shader
-    GLint pos_att = glGetAttribLocation(program, "position");
-    glEnableVertexAttribArray(pos_att);
-    glVertexAttribPointer(pos_att, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), 0);
-
-    GLint tex_att = glGetAttribLocation(program, "uv");
-    glEnableVertexAttribArray(tex_att);
-    glVertexAttribPointer(tex_att, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+    const ProgramLocations &locations = material->GetLocations();
+    GLuint program = material->GetResource();
+    GLState::UseProgram(program);
+
+    // Set up quad geometry. The attributes of the screen-space shader are
+    // set once, in the vertex array of the quad and the program
+    GLuint vertex_array = VertexArrayCache::Find(quad_array_buffer_, 0, program);
+    if (vertex_array == 0) {
+        glGenVertexArrays(1, &vertex_array);
+        GLState::BindVertexArray(vertex_array);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, quad_array_buffer_);
+
+        GLint pos_att = locations.attrib[PositionAttribute];
+        glEnableVertexAttribArray(pos_att);
+        glVertexAttribPointer(pos_att, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), 0);
+
+        GLint tex_att = locations.attrib[UvAttribute];
+        glEnableVertexAttribArray(tex_att);
+        glVertexAttribPointer(tex_att, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+
+        VertexArrayCache::Add(quad_array_buffer_, 0, program, vertex_array);
+    }
+    else {
+        GLState::BindVertexArray(vertex_array);
+    }
 
     // Timer
-    GLint timer_var = glGetUniformLocation(program, "timer");
     float current_time = glfwGetTime();
     float deltaT = current_time - startTime_;
-    glUniform1f(timer_var, deltaT);
+    glUniform1f(locations.uniform[TimerUniform], deltaT);
 
     // Bind texture
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture_);
+    GLState::BindTexture(0, GL_TEXTURE_2D, texture_);
+    GLState::BindSampler(0, 0); // No mipmaps; keep its own filtering
 
     // Draw geometry
     glDrawArrays(GL_TRIANGLES, 0, 6); // Quad: 6 coordinates
+    RenderStats::AddDraw(GL_TRIANGLES, 6);
 
     // Reset current geometry
-    glEnable(GL_DEPTH_TEST);
+    GLState::BindVertexArray(0);
+    GLState::Enable(GL_DEPTH_TEST);
 
     return deltaT;
 }
@@ -302,7 +432,7 @@ void SceneGraph::SaveTexture(char* filename) {
     unsigned char data[FRAME_BUFFER_WIDTH * FRAME_BUFFER_HEIGHT * 4];
 
     // Retrieve image data from texture
-    glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_);
+    GLState::BindFramebuffer(frame_buffer_);
     glReadPixels(0, 0, FRAME_BUFFER_WIDTH, FRAME_BUFFER_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, data);
 
     // Create file in ppm format
@@ -333,7 +463,7 @@ void SceneGraph::SaveTexture(char* filename) {
     f.close();
 
     // Reset frame buffer
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::BindFramebuffer(0);
 }
 
 
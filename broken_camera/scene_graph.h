@@ -2,6 +2,7 @@
 #define SCENE_GRAPH_H_
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 #define GLEW_STATIC
 #include <GL/glew.h>
@@ -10,6 +11,7 @@
 #include "scene_node.h"
 #include "resource.h"
 #include "camera.h"
+#include "render_queue.h"
 
 // Size of the texture that we will draw
 #define FRAME_BUFFER_WIDTH 1024
@@ -27,11 +29,24 @@ namespace game {
             // Scene nodes to render
             std::vector<SceneNode *> node_;
             std::vector<SceneNode*> collidable_nodes_;
-            
+            // Index in node_ of one node of each name, with the number of
+            // nodes of that name, and index of each node in
+            // collidable_nodes_
+            struct NameEntry {
+                unsigned int index;
+                unsigned int count;
+            };
+            std::unordered_map<std::string, NameEntry> name_index_;
+            std::unordered_map<SceneNode *, unsigned int> collidable_index_;
+            // Nodes to take out of the lists at the end of the frame
+            std::vector<SceneNode *> removed_nodes_;
+
 
             //Particle effect
             std::vector<SceneNode*> effects_;
 
+            // Nodes of the pass being drawn, sorted by state
+            RenderQueue queue_;
 
             // Frame buffer for drawing to texture
             GLuint frame_buffer_;
@@ -43,7 +58,11 @@ namespace game {
 
             double startTime_;
 
-            void RemoveNode(std::string);
+            // Add a node to node_ and the name index
+            void InsertNode(SceneNode *node);
+            // Take a node out of the lists by moving the last one into its
+            // place
+            void RemoveNode(SceneNode *node);
 
         public:
 
@@ -53,9 +72,12 @@ namespace game {
             {
                 OBJ, EFFECTS
             };
-            // Constructor and destructor
+            // Constructor and destructor. The scene graph owns the nodes
+            // added to it and the sky box, and destroys them
             SceneGraph(void);
             ~SceneGraph();
+            // Destroy all nodes of the scene
+            void Clear(void);
 
             // Background color
             void SetBackgroundColor(glm::vec3 color);
@@ -65,15 +87,21 @@ namespace game {
             SceneNode *CreateNode(std::string node_name, Resource *geometry, Resource *material, Resource* texture = NULL, Resource* normal_map = NULL);
             // Add an already-created node
             void AddNode(SceneNode *node, Options x = OBJ);
-            // Find a scene node with a specific name
-            SceneNode *GetNode(std::string node_name) const;
-            void RemoveCollidable(std::string node_name);
+            // Find a scene node with a specific name. With several nodes
+            // of the same name, any one of them may be found
+            SceneNode *GetNode(const std::string &node_name) const;
+            // Remove a collidable node from the scene at the end of the
+            // frame, so that loops over the nodes can keep going
+            void RemoveCollidable(SceneNode *node);
+            // Take out and destroy the nodes removed during the frame.
+            // Changes the order of the nodes
+            void FlushRemovals(void);
             // Get node const iterator
             std::vector<SceneNode *>::const_iterator begin() const;
             std::vector<SceneNode *>::const_iterator end() const;
 
-            inline std::vector<SceneNode *> GetGraph() { return node_; }
-            inline std::vector<SceneNode *> GetCollidables() { return collidable_nodes_; }
+            inline const std::vector<SceneNode *> &GetGraph() const { return node_; }
+            inline const std::vector<SceneNode *> &GetCollidables() const { return collidable_nodes_; }
 
             //Alpha Blending
             static void AlphaBlending(bool set);
@@ -84,7 +112,7 @@ namespace game {
             // Draw the scene into a texture
             void DrawToTexture(Camera* camera);
             // Process and draw the texture on the screen
-            float DisplayTexture(GLuint program);
+            float DisplayTexture(const Resource *material);
             // Save texture to a file in ppm format
             void SaveTexture(char* filename);
 
@@ -6,9 +6,20 @@
 #include <time.h>
 
 #include "scene_node.h"
+#include "render_stats.h"
+#include "vertex_array_cache.h"
+#include "draw_ring.h"
+#include "render_queue.h"
+#include "gl_state.h"
+#include "sampler_cache.h"
+#include "transform_system.h"
+#include "node_pool.h"
 
 namespace game {
 
+bool SceneNode::lod_enabled_ = true;
+
+
 SceneNode::SceneNode(const std::string name, const Resource *geometry, const Resource *material, const Resource* texture, const Resource* normal_map){
 
     // Set name of scene node
@@ -26,6 +37,21 @@ SceneNode::SceneNode(const std::string name, const Resource *geometry, const Res
     array_buffer_ = geometry->GetArrayBuffer();
     element_array_buffer_ = geometry->GetElementArrayBuffer();
     size_ = geometry->GetSize();
+    layout_ = geometry->GetLayout();
+    range_ = geometry->GetRange();
+    num_lods_ = geometry->GetNumLods();
+    for (int i = 0; i < num_lods_; i++){
+        lod_[i] = geometry->GetLod(i);
+    }
+    bounds_center_ = (geometry->GetBoundsMin() + geometry->GetBoundsMax()) * 0.5f;
+    bounds_radius_ = glm::length(geometry->GetBoundsMax() - geometry->GetBoundsMin()) * 0.5f;
+    if (geometry->GetBoundsMin() == geometry->GetBoundsMax()){
+        bounds_radius_ = -1.0f; // Not known, so never culled
+    }
+    world_bounds_.center = glm::vec3(0.0);
+    world_bounds_.radius = -1.0f;
+    subtree_bounds_ = world_bounds_;
+    subtree_size_ = 1;
 
     // Set material (shader program)
     if (material->GetType() != Material){
@@ -33,10 +59,19 @@ SceneNode::SceneNode(const std::string name, const Resource *geometry, const Res
     }
 
     material_ = material->GetResource();
-
-    // Set texture
+    locations_ = material->GetLocations();
+    vertex_array_ = 0;
+    cull_face_ = false;
+    instanced_ = false;
+
+    // Set texture. Textures packed into an array are drawn from their
+    // layer of it
+    texture_target_ = GL_TEXTURE_2D;
+    texture_layer_ = 0;
     if (texture) {
         texture_ = texture->GetResource();
+        texture_target_ = texture->GetTarget();
+        texture_layer_ = glm::max(texture->GetLayer(), 0);
         //std::cout << "aaaaahhhhhhhhhhh" << std::endl;
     }
     else {
@@ -44,8 +79,12 @@ SceneNode::SceneNode(const std::string name, const Resource *geometry, const Res
     }
 
     // Set normal_map
+    normal_map_target_ = GL_TEXTURE_2D;
+    normal_map_layer_ = 0;
     if (normal_map != NULL) {
         normal_map_ = normal_map->GetResource();
+        normal_map_target_ = normal_map->GetTarget();
+        normal_map_layer_ = glm::max(normal_map->GetLayer(), 0);
         //std::cout << "blah" << std::endl;
     }
     else {
@@ -53,44 +92,63 @@ SceneNode::SceneNode(const std::string name, const Resource *geometry, const Res
     }
 
     // Other attributes
-    scale_ = glm::vec3(1.0, 1.0, 1.0);
-    parent_ = NULL;
+    pool_ = NULL;
+    transform_ = TransformSystem::Create();
     orbiting_ = false;
     orbit_angle_ = 0;
   
     orbit_speed_ = 1;
+
+    // Matrices derived from the transform are computed on first use
+    draw_version_ = ~0u;
+    bounds_version_ = ~0u;
+
+    // Hold the resources, so that the OpenGL objects copied above stay
+    // valid while the node exists
+    resource_[0] = geometry;
+    resource_[1] = material;
+    resource_[2] = texture;
+    resource_[3] = normal_map;
+    for (int i = 0; i < 4; i++){
+        if (resource_[i]){
+            resource_[i]->AddRef();
+        }
+    }
 }
 
 
 SceneNode::~SceneNode(){
 
+    for (int i = 0; i < children_.size(); i++) {
+        NodePool::Destroy(children_[i]);
+    }
+
+    // Nodes that followed this one become roots
+    TransformSystem::Destroy(transform_);
+
+    for (int i = 0; i < 4; i++){
+        if (resource_[i]){
+            resource_[i]->Release();
+        }
+    }
 }
 
-glm::mat4 SceneNode::GetTransf() {
+const glm::mat4 &SceneNode::GetTransf(void) {
+
+    return TransformSystem::GetWorld(transform_);
+}
 
-    // World transformation
-    glm::mat4 rotation = glm::mat4_cast(orientation_);
-    glm::mat4 orbit = glm::mat4(1.0);
-    glm::mat4 translation = glm::translate(glm::mat4(1.0), position_);
-    glm::mat4 transf = glm::mat4(1.0);
-    glm::mat4 parent_mat = glm::mat4(1.0);
 
-    // apply orbit transform if it is orbiting
+void SceneNode::UpdateOrbit(void) {
+
+    // Rotation about the joint, between the translation and orientation
+    glm::mat4 orbit = glm::mat4(1.0);
     if (orbiting_) {
-        // creates auxillary variable (orbit matrix) from rotation and axis
         glm::quat orbit_rot = glm::normalize(glm::angleAxis(orbit_angle_, orbit_axis_));
         glm::mat4 orbit_trans = glm::translate(glm::mat4(1.0), joint_pos_);
         orbit = glm::inverse(orbit_trans) * glm::mat4_cast(orbit_rot) * orbit_trans;
     }
-
-    // get parent transform if node has a parent
-    if (parent_ != NULL) {
-        parent_mat = parent_->GetTransf();
-    }
-
-    transf = parent_mat * translation * orbit * rotation * transf;
-
-    return transf;
+    TransformSystem::SetOrbit(transform_, orbit);
 }
 
 const std::string SceneNode::GetName(void) const {
@@ -101,60 +159,60 @@ const std::string SceneNode::GetName(void) const {
 
 glm::vec3 SceneNode::GetPosition(void) const {
 
-    return position_;
+    return TransformSystem::GetPosition(transform_);
 }
 
 
 glm::quat SceneNode::GetOrientation(void) const {
 
-    return orientation_;
+    return TransformSystem::GetOrientation(transform_);
 }
 
 
 glm::vec3 SceneNode::GetScale(void) const {
 
-    return scale_;
+    return TransformSystem::GetScale(transform_);
 }
 
 
 void SceneNode::SetPosition(glm::vec3 position){
 
-    position_ = position;
+    TransformSystem::SetPosition(transform_, position);
 }
 
 void SceneNode::SetParent(SceneNode* p) {
-    parent_ = p;
+
+    TransformSystem::SetParent(transform_, p ? p->transform_ : TransformSystem::no_parent);
 }
 
 
 void SceneNode::SetOrientation(glm::quat orientation){
 
-    orientation_ = orientation;
+    TransformSystem::SetOrientation(transform_, orientation);
 }
 
 
 void SceneNode::SetScale(glm::vec3 scale){
 
-    scale_ = scale;
+    TransformSystem::SetScale(transform_, scale);
 }
 
 
 void SceneNode::Translate(glm::vec3 trans){
 
-    position_ += trans;
+    TransformSystem::SetPosition(transform_, GetPosition() + trans);
 }
 
 
 void SceneNode::Rotate(glm::quat rot){
 
-    orientation_ *= rot;
-    orientation_ = glm::normalize(orientation_);
+    TransformSystem::SetOrientation(transform_, glm::normalize(GetOrientation() * rot));
 }
 
 
 void SceneNode::Scale(glm::vec3 scale){
 
-    scale_ *= scale;
+    TransformSystem::SetScale(transform_, GetScale() * scale);
 }
 
 
@@ -188,42 +246,262 @@ GLuint SceneNode::GetMaterial(void) const {
 }
 
 
+GLuint SceneNode::GetTexture(void) const {
+
+    return texture_;
+}
+
+
+GLint SceneNode::GetBaseVertex(void) const {
+
+    return range_.base_vertex;
+}
+
+
+bool SceneNode::GetCullFace(void) const {
+
+    return cull_face_;
+}
+
+
+void SceneNode::SetInstanced(bool instanced){
+
+    // Without per-instance transforms the node would never be batched
+    if (instanced && (locations_.attrib[WorldMatAttribute] < 0)){
+        throw(std::invalid_argument(std::string("Material of ") + name_ + std::string(" does not read world_mat per instance")));
+    }
+    instanced_ = instanced;
+}
+
+
+bool SceneNode::GetInstanced(void) const {
+
+    return instanced_;
+}
+
+
+bool SceneNode::CanBatchWith(const SceneNode *other) const {
+
+    return (locations_.attrib[WorldMatAttribute] >= 0) && (mode_ == GL_TRIANGLES) && (other->mode_ == mode_) &&
+        (array_buffer_ == other->array_buffer_) && (element_array_buffer_ == other->element_array_buffer_) &&
+        (material_ == other->material_) && (texture_ == other->texture_) && (normal_map_ == other->normal_map_) &&
+        (cull_face_ == other->cull_face_);
+}
+
+
+bool SceneNode::CanInstanceWith(const SceneNode *other) const {
+
+    return instanced_ && other->instanced_ && CanBatchWith(other) &&
+        (range_.base_vertex == other->range_.base_vertex) && (range_.first_index == other->range_.first_index);
+}
+
+
+void SceneNode::SetBounds(const glm::vec3 &center, float radius){
+
+    bounds_center_ = center;
+    bounds_radius_ = radius;
+    bounds_version_ = ~0u;
+}
+
+
+void SceneNode::UpdateBounds(void){
+
+    // The sphere grows with the largest scale of the transformation. It
+    // only moves with the node
+    unsigned int version = TransformSystem::GetVersion(transform_);
+    if (bounds_version_ != version) {
+        const glm::mat4 &transf = TransformSystem::GetModel(transform_);
+        float scale = glm::max(glm::length(glm::vec3(transf[0])), glm::max(glm::length(glm::vec3(transf[1])), glm::length(glm::vec3(transf[2]))));
+        world_bounds_.center = glm::vec3(transf * glm::vec4(bounds_center_, 1.0));
+        world_bounds_.radius = (bounds_radius_ < 0.0f) ? -1.0f : bounds_radius_ * scale;
+        bounds_version_ = version;
+    }
+
+    // Children move with the node, so their bounds are found again too
+    subtree_bounds_ = world_bounds_;
+    subtree_size_ = 1;
+    for (int i = 0; i < children_.size(); i++){
+        children_[i]->UpdateBounds();
+        subtree_bounds_ = merge_bounds(subtree_bounds_, children_[i]->subtree_bounds_);
+        subtree_size_ += children_[i]->subtree_size_;
+    }
+}
+
+
+const BoundingSphere &SceneNode::GetBounds(void) const {
+
+    return world_bounds_;
+}
+
+
+const BoundingSphere &SceneNode::GetSubtreeBounds(void) const {
+
+    return subtree_bounds_;
+}
+
+
+int SceneNode::GetSubtreeSize(void) const {
+
+    return subtree_size_;
+}
+
+
+void SceneNode::SetLodEnabled(bool enabled){
+
+    lod_enabled_ = enabled;
+}
+
+
+bool SceneNode::GetLodEnabled(void){
+
+    return lod_enabled_;
+}
+
+
 void SceneNode::Draw(Camera *camera){
 
-    // Select proper material (shader program)
-    glUseProgram(material_);
+    Submit(camera);
+
+    // Buffers bound elsewhere must not change the vertex array
+    GLState::BindVertexArray(0);
+
+    for (int i = 0; i < children_.size(); i++) {
+        children_[i]->Draw(camera);
+    }
+}
+
 
-    // Set geometry to draw
-    glBindBuffer(GL_ARRAY_BUFFER, array_buffer_);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_array_buffer_);
+void SceneNode::Submit(Camera *camera){
 
-    // Set globals for camera
-    camera->SetupShader(material_);
+    BindState();
 
     // Set world matrix and other shader input variables
-    SetupShader(material_);
+    SetupShader(locations_);
+
+    // Programs that draw instances get the transforms with the draw
+    if (locations_.attrib[WorldMatAttribute] >= 0){
+        DrawUniforms data;
+        GetDrawUniforms(&data);
+        DrawInstances(&data, 1, SelectLod(camera));
+        return;
+    }
 
     // Draw geometry
     if (mode_ == GL_POINTS){
-        glDrawArrays(mode_, 0, size_);
+        GL_COUNT(glDrawArrays(mode_, 0, size_));
+        RenderStats::AddDraw(mode_, size_);
     } else {
-        glDrawElements(mode_, size_, GL_UNSIGNED_INT, 0);
+        // Pooled geometry starts at a base vertex and first index of the
+        // shared buffers
+        DrawElementsCommand command;
+        GetDrawCommand(SelectLod(camera), &command);
+        size_t index_size = (layout_.index_type == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+        GL_COUNT(glDrawElementsBaseVertex(mode_, command.count, layout_.index_type, (void *) (command.first_index * index_size), command.base_vertex));
+        RenderStats::AddDraw(mode_, command.count);
     }
+}
 
-    for (int i = 0; i < children_.size(); i++) {
-        children_[i]->Draw(camera);
+
+void SceneNode::GetDrawCommand(int lod, DrawElementsCommand *command) const {
+
+    command->count = lod_[lod].num_indices;
+    command->instance_count = 1;
+    command->first_index = range_.first_index + lod_[lod].first_index;
+    command->base_vertex = range_.base_vertex;
+    command->base_instance = 0;
+}
+
+
+void SceneNode::SubmitCommands(const DrawUniforms *instance, GLuint num_instances, DrawElementsCommand *command, GLuint num_commands){
+
+    BindState();
+    SetupShader(locations_);
+
+    // Instances are numbered from the first one written to the ring
+    GLuint first = DrawRing::PushInstances(instance, num_instances);
+    GLsizei num_indices = 0;
+    for (GLuint i = 0; i < num_commands; i++){
+        command[i].base_instance += first;
+        num_indices += command[i].count * command[i].instance_count;
+    }
+
+    // All the commands in one call, read from the ring
+    bool multi_draw = GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && (GLEW_VERSION_4_2 || GLEW_ARB_base_instance));
+    if ((num_commands > 1) && multi_draw){
+        GLintptr offset = DrawRing::Write(command, num_commands * sizeof(DrawElementsCommand));
+        GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, DrawRing::GetBuffer());
+        GL_COUNT(glMultiDrawElementsIndirect(mode_, layout_.index_type, (void *) offset, num_commands, 0));
+        RenderStats::AddDraw(mode_, num_indices);
+        return;
+    }
+
+    for (GLuint i = 0; i < num_commands; i++){
+        DrawCommand(command[i]);
+    }
+}
+
+
+void SceneNode::DrawInstances(const DrawUniforms *instance, GLuint count, int lod){
+
+    GLuint first = DrawRing::PushInstances(instance, count);
+    if (mode_ != GL_POINTS){
+        DrawElementsCommand command;
+        GetDrawCommand(lod, &command);
+        command.instance_count = count;
+        command.base_instance = first;
+        DrawCommand(command);
+        return;
     }
+
+    // The instance attributes of the vertex array start at the first
+    // element of the ring; the base instance selects where these are.
+    // Without it the attributes are pointed to them instead
+    if (GLEW_VERSION_4_2 || GLEW_ARB_base_instance){
+        GL_COUNT(glDrawArraysInstancedBaseInstance(mode_, 0, size_, count, first));
+    } else {
+        SetupInstanceAttributes(first * sizeof(DrawUniforms));
+        GL_COUNT(glDrawArraysInstanced(mode_, 0, size_, count));
+    }
+    RenderStats::AddDraw(mode_, size_ * count);
+}
+
+
+void SceneNode::DrawCommand(const DrawElementsCommand &command){
+
+    size_t index_size = (layout_.index_type == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+    void *indices = (void *) (command.first_index * index_size);
+    if (GLEW_VERSION_4_2 || GLEW_ARB_base_instance){
+        GL_COUNT(glDrawElementsInstancedBaseVertexBaseInstance(mode_, command.count, layout_.index_type, indices, command.instance_count, command.base_vertex, command.base_instance));
+    } else {
+        SetupInstanceAttributes(command.base_instance * sizeof(DrawUniforms));
+        GL_COUNT(glDrawElementsInstancedBaseVertex(mode_, command.count, layout_.index_type, indices, command.instance_count, command.base_vertex));
+    }
+    RenderStats::AddDraw(mode_, command.count * command.instance_count);
+}
+
+
+void SceneNode::BindState(void){
+
+    // Select proper material (shader program)
+    GLState::UseProgram(material_);
+
+    // Set geometry to draw, with its attributes pointed to the inputs of
+    // the program
+    BindVertexArray();
+    BindTextures();
+    GLState::SetEnabled(GL_CULL_FACE, cull_face_);
 }
 
 void SceneNode::Orbit(double d) {
     if (orbiting_) {
         orbit_angle_ += orbit_speed_ * d;
+        UpdateOrbit();
     }
 }
 
 glm::vec3 SceneNode::GetForward()
 {
-    glm::vec3 current_forward = orientation_ * forward_;
+    glm::vec3 current_forward = GetOrientation() * forward_;
     return current_forward; // Return -forward since the camera coordinate system points in the opposite direction
 }
 
@@ -236,71 +514,157 @@ void SceneNode::Update(float d){
 
 void SceneNode::AddChild(std::string f, const Resource* geom, const Resource* mat, const Resource* tex) { 
 
-    SceneNode* scn = new SceneNode(f, geom, mat, tex);
+    SceneNode* scn = NodePool::Create<SceneNode>(f, geom, mat, tex);
     children_.push_back(scn);
-    scn->parent_ = this;
+    scn->SetParent(this);
+}
+
+
+void SceneNode::BindVertexArray(void){
+
+    if (vertex_array_ == 0){
+        vertex_array_ = VertexArrayCache::Find(array_buffer_, element_array_buffer_, material_);
+    }
+    if (vertex_array_ != 0){
+        GLState::BindVertexArray(vertex_array_);
+        return;
+    }
+
+    // First draw of this geometry with this material. The vertex array
+    // records the buffers and attribute pointers set while it is bound
+    glGenVertexArrays(1, &vertex_array_);
+    GLState::BindVertexArray(vertex_array_);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, array_buffer_);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_array_buffer_);
+    SetupVertexAttributes(locations_);
+    VertexArrayCache::Add(array_buffer_, element_array_buffer_, material_, vertex_array_);
+}
+
+
+void SceneNode::SetupVertexAttributes(const ProgramLocations &locations) {
+
+    // Set attributes for shaders. Attributes the program does not use are
+    // skipped
+    const VertexAttrib *attrib[4] = { &layout_.position, &layout_.normal, &layout_.color, &layout_.uv };
+    const ProgramAttrib input[4] = { VertexAttribute, NormalAttribute, ColorAttribute, UvAttribute };
+    for (int i = 0; i < 4; i++){
+        GLint location = locations.attrib[input[i]];
+        if (location < 0){
+            continue;
+        }
+        glVertexAttribPointer(location, attrib[i]->size, attrib[i]->type, attrib[i]->normalized, layout_.stride, (void *) (size_t) attrib[i]->offset);
+        glEnableVertexAttribArray(location);
+    }
+    SetupInstanceAttributes(0);
+}
+
+
+void SceneNode::SetupInstanceAttributes(GLintptr offset) {
+
+    // Transforms advance once per instance. A matrix takes four
+    // locations, one per column
+    const ProgramAttrib input[2] = { WorldMatAttribute, NormalMatAttribute };
+    bool bound = false;
+    for (int i = 0; i < 2; i++){
+        GLint location = locations_.attrib[input[i]];
+        if (location < 0){
+            continue;
+        }
+        if (!bound){
+            GLState::BindBuffer(GL_ARRAY_BUFFER, DrawRing::GetBuffer());
+            bound = true;
+        }
+        for (int c = 0; c < 4; c++){
+            size_t column = offset + i * sizeof(glm::mat4) + c * sizeof(glm::vec4);
+            GL_COUNT(glVertexAttribPointer(location + c, 4, GL_FLOAT, GL_FALSE, sizeof(DrawUniforms), (void *) column));
+            GL_COUNT(glEnableVertexAttribArray(location + c));
+            GL_COUNT(glVertexAttribDivisor(location + c, 1));
+        }
+    }
+}
+
+
+glm::mat4 SceneNode::GetDequantization(void) const {
+
+    return glm::scale(glm::translate(glm::mat4(1.0), layout_.position_offset), layout_.position_scale);
+}
+
+
+int SceneNode::SelectLod(Camera *camera){
+
+    if ((num_lods_ <= 1) || !lod_enabled_){
+        return 0;
+    }
+
+    // Distance to the bounding sphere, in world space
+    glm::mat4 transf = GetTransf();
+    glm::vec3 node_scale = GetScale();
+    glm::vec3 center = glm::vec3(transf * glm::vec4(bounds_center_ * node_scale, 1.0));
+    glm::vec3 abs_scale = glm::abs(node_scale);
+    float scale = glm::max(abs_scale.x, glm::max(abs_scale.y, abs_scale.z));
+    float distance = glm::length(center - camera->GetPosition());
+    if (distance <= bounds_radius_ * scale){
+        return 0;
+    }
+
+    // Project the error of each level to pixels; the errors grow with the
+    // level
+    float pixels_per_unit = camera->GetPixelsPerUnit(distance) * scale;
+    int level = 0;
+    while ((level + 1 < num_lods_) && (lod_[level + 1].error * pixels_per_unit <= lod_pixel_error)){
+        level++;
+    }
+    return level;
 }
 
 
-void SceneNode::SetupShader(GLuint program) {
+void SceneNode::SetupShader(const ProgramLocations &locations) {
+
+    // Programs that draw instances read the transforms as attributes
+    if (locations.attrib[WorldMatAttribute] >= 0) {
+        return;
+    }
 
-    // Set attributes for shaders
-    GLint vertex_att = glGetAttribLocation(program, "vertex");
-    glVertexAttribPointer(vertex_att, 3, GL_FLOAT, GL_FALSE, 11*sizeof(GLfloat), 0);
-    glEnableVertexAttribArray(vertex_att);
+    DrawUniforms data;
+    GetDrawUniforms(&data);
+    DrawRing::Push(data);
+}
 
-    GLint normal_att = glGetAttribLocation(program, "normal");
-    glVertexAttribPointer(normal_att, 3, GL_FLOAT, GL_FALSE, 11*sizeof(GLfloat), (void *) (3*sizeof(GLfloat)));
-    glEnableVertexAttribArray(normal_att);
 
-    GLint color_att = glGetAttribLocation(program, "color");
-    glVertexAttribPointer(color_att, 3, GL_FLOAT, GL_FALSE, 11*sizeof(GLfloat), (void *) (6*sizeof(GLfloat)));
-    glEnableVertexAttribArray(color_att);
+void SceneNode::GetDrawUniforms(DrawUniforms *data) {
 
-    GLint tex_att = glGetAttribLocation(program, "uv");
-    glVertexAttribPointer(tex_att, 2, GL_FLOAT, GL_FALSE, 11*sizeof(GLfloat), (void *) (9*sizeof(GLfloat)));
-    glEnableVertexAttribArray(tex_att);
+    // World transformation only recomputed when the node has moved.
+    // Packed positions are scaled back to model space along with it. The
+    // transform system keeps the normal matrix
+    unsigned int version = TransformSystem::GetVersion(transform_);
+    if (draw_version_ != version) {
+        draw_mat_ = TransformSystem::GetModel(transform_) * GetDequantization();
+        draw_version_ = version;
+    }
+    data->world_mat = draw_mat_;
+    data->normal_mat = TransformSystem::GetNormal(transform_);
+    data->normal_mat[3] = glm::vec4((float) texture_layer_, (float) normal_map_layer_, 0.0f, 1.0f);
+}
 
-    // World transformation
-    glm::mat4 scaling = glm::scale(glm::mat4(1.0), scale_);
-    glm::mat4 transf = GetTransf() * scaling;
 
-    GLint world_mat = glGetUniformLocation(program, "world_mat");
-    glUniformMatrix4fv(world_mat, 1, GL_FALSE, glm::value_ptr(transf));
+void SceneNode::BindTextures(void) {
 
-    // Normal matrix
-    glm::mat4 normal_matrix = glm::transpose(glm::inverse(transf));
-    GLint normal_mat = glGetUniformLocation(program, "normal_mat");
-    glUniformMatrix4fv(normal_mat, 1, GL_FALSE, glm::value_ptr(normal_matrix));
+    // The mipmaps were built when the textures were loaded, and filtering
+    // comes from the sampler of each unit
+    GLuint sampler = SamplerCache::Get(GL_NEAREST_MIPMAP_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE);
 
-    // Texture
+    // Texture. The sampler was assigned the first unit when the material
+    // was loaded
     if (texture_) {
-        GLint tex = glGetUniformLocation(program, "texture_map");
-        glUniform1i(tex, 0); // Assign the first texture to the map
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_); // First texture we bind
-        // Define texture interpolation
-        glGenerateMipmap(GL_TEXTURE_2D);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        GLState::BindTexture(0, texture_target_, texture_);
+        GLState::BindSampler(0, sampler);
     }
 
-    // Normal Map
+    // Normal Map, on the second unit
     if (normal_map_) {
-        GLint tex = glGetUniformLocation(program, "normal_map");
-        glUniform1i(tex, 1); // Assign the first texture to the map
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, normal_map_); // First texture we bind
-        // Define texture interpolation
-        glGenerateMipmap(GL_TEXTURE_2D);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    }
-
-    // Timer
-    GLint timer_var = glGetUniformLocation(program, "timer");
-    double current_time = glfwGetTime();
-    glUniform1f(timer_var, (float) current_time);
+        GLState::BindTexture(1, normal_map_target_, normal_map_);
+        GLState::BindSampler(1, sampler);
+    }
 }
 
 } // namespace game;
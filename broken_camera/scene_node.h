@@ -12,10 +12,19 @@
 
 #include "resource.h"
 #include "camera.h"
+#include "frustum.h"
 #include <vector>
 
 namespace game {
 
+    // Coarser levels of detail are drawn while their error stays under
+    // this many pixels on screen
+    const float lod_pixel_error = 1.0f;
+
+    struct DrawUniforms;
+    struct DrawElementsCommand;
+    class NodePoolBase;
+
     // Class that manages one object in a scene 
     class SceneNode {
 
@@ -24,8 +33,8 @@ namespace game {
             // Create scene node from given resources
             SceneNode(const std::string name, const Resource *geometry, const Resource *material, const Resource* texture = NULL, const Resource* normal_map = NULL);
 
-            // Destructor
-            ~SceneNode();
+            // Destructor. Destroys the children of the node, which it owns
+            virtual ~SceneNode();
             
             // Get name of node
             const std::string GetName(void) const;
@@ -34,19 +43,22 @@ namespace game {
             glm::vec3 GetPosition(void) const;
             glm::quat GetOrientation(void) const;
             glm::vec3 GetScale(void) const;
-            virtual glm::mat4 GetTransf();
+            // World transformation, without the scale of the node. Kept by
+            // the TransformSystem, and only computed again after the node or
+            // one of its parents has moved
+            const glm::mat4 &GetTransf(void);
             void AddChild(std::string, const Resource*, const Resource*, const Resource*);
 
             // Set node attributes
             void SetPosition(glm::vec3 position);
             void SetOrientation(glm::quat orientation);
             void SetScale(glm::vec3 scale);
-            void SceneNode::SetParent(SceneNode* p);
-            inline std::vector<SceneNode*> GetChildren() { return children_; }
-            inline void SetOrbiting() { orbiting_ = true; }
-            inline void SetJointPos(glm::vec3 p) { joint_pos_ = p; }
+            void SetParent(SceneNode* p);
+            inline const std::vector<SceneNode*> &GetChildren() const { return children_; }
+            inline void SetOrbiting() { orbiting_ = true; UpdateOrbit(); }
+            inline void SetJointPos(glm::vec3 p) { joint_pos_ = p; UpdateOrbit(); }
             
-            inline void SetOrbitAxis(glm::vec3 a) { orbit_axis_ = a; }
+            inline void SetOrbitAxis(glm::vec3 a) { orbit_axis_ = a; UpdateOrbit(); }
             inline void SetOrbitSpeed(float s) { orbit_speed_ = s; }
             
             // Perform transformations on node
@@ -57,6 +69,29 @@ namespace game {
             // Draw the node according to scene parameters in 'camera'
             // variable
             virtual void Draw(Camera *camera);
+            // Draw the node alone, without its children
+            void Submit(Camera *camera);
+            // Draw commands with the node's program, buffers and textures.
+            // The base instance of each command is relative to the first
+            // of the instance transforms
+            void SubmitCommands(const DrawUniforms *instance, GLuint num_instances, DrawElementsCommand *command, GLuint num_commands);
+            // Command that draws the node once at a level of detail
+            void GetDrawCommand(int lod, DrawElementsCommand *command) const;
+
+            // Nodes that are instanced are drawn together with the other
+            // instanced nodes of the same geometry, material and textures.
+            // The material must read its transforms as instance attributes
+            void SetInstanced(bool instanced);
+            bool GetInstanced(void) const;
+            // Whether another node can be drawn by the same indirect draw
+            // as this one, or as an instance of this one
+            bool CanBatchWith(const SceneNode *other) const;
+            bool CanInstanceWith(const SceneNode *other) const;
+            // Transforms of the node for its next draw
+            void GetDrawUniforms(DrawUniforms *data);
+            // Coarsest level of detail that looks the same as the full
+            // geometry from the camera
+            int SelectLod(Camera *camera);
 
             // Update the node
             virtual void Update(float);
@@ -67,6 +102,26 @@ namespace game {
             GLuint GetElementArrayBuffer(void) const;
             GLsizei GetSize(void) const;
             GLuint GetMaterial(void) const;
+            GLuint GetTexture(void) const;
+            GLint GetBaseVertex(void) const;
+            bool GetCullFace(void) const;
+
+            // Bounding sphere of the geometry, in model space. Nodes whose
+            // shaders move vertices past the geometry give bounds that hold
+            // the moved vertices; a negative radius is never culled
+            void SetBounds(const glm::vec3 &center, float radius);
+            // Find the world bounds of the node and of it with all its
+            // children, from their current transforms. Called once a frame,
+            // before culling
+            void UpdateBounds(void);
+            const BoundingSphere &GetBounds(void) const;
+            const BoundingSphere &GetSubtreeBounds(void) const;
+            // Number of nodes in the subtree of the node, itself included
+            int GetSubtreeSize(void) const;
+
+            // Switch between levels of detail for all nodes
+            static void SetLodEnabled(bool enabled);
+            static bool GetLodEnabled(void);
 
             inline float GetRadius() { return radius_; }
             inline bool GetCollidable() { return collidable_; }
@@ -81,29 +136,76 @@ namespace game {
             GLuint element_array_buffer_;
             GLenum mode_; // Type of geometry
             GLsizei size_; // Number of primitives in geometry
+            VertexLayout layout_; // How the geometry is stored
+            GeometryRange range_; // Part of the buffers that holds the geometry
+            MeshLod lod_[mesh_max_lods]; // Levels of detail of the geometry
+            int num_lods_;
+            glm::vec3 bounds_center_; // Bounding sphere of the geometry
+            float bounds_radius_;
+            BoundingSphere world_bounds_; // Of the node, in world space
+            BoundingSphere subtree_bounds_; // Of the node and its children
+            int subtree_size_;
             GLuint material_; // Reference to shader program
+            ProgramLocations locations_; // Inputs of the shader program
+            GLuint vertex_array_; // Shared with nodes of the same geometry and material
             GLuint texture_;
             GLuint normal_map_;
+            GLenum texture_target_; // 2D texture or texture array
+            GLenum normal_map_target_;
+            GLint texture_layer_; // Layers in texture arrays, else 0
+            GLint normal_map_layer_;
+            bool cull_face_; // Whether back faces are culled
+            bool instanced_; // Whether the node is drawn with others like it
+            const Resource *resource_[4]; // Resources referenced by the node, so
+                                          // they are not evicted while in use
             
             std::string type_ = "NoneType";
             float radius_ = 1.0f;
             bool collidable_ = false;
             std::vector<SceneNode*> children_;  // child nodes vector
-            SceneNode* parent_;
             
-            glm::vec3 position_; // Position of node
-            glm::quat orientation_; // Orientation of node
+            // Position, orientation, scale and parent are stored in the
+            // TransformSystem
+            unsigned int transform_; // Id of the transform of the node
             glm::vec3 joint_pos_;
-            glm::vec3 scale_; // Scale of node
             glm::vec3 forward_ = glm::vec3(0.0, 0.0, 1.0);
+            glm::mat4 draw_mat_; // Model matrix from stored positions
+            unsigned int draw_version_; // Transform version of draw_mat_
+            unsigned int bounds_version_; // And of world_bounds_
+            // Give the transform the rotation of the orbit
+            void UpdateOrbit(void);
             // Set matrices that transform the node in a shader program
-            virtual void SetupShader(GLuint program);
+            virtual void SetupShader(const ProgramLocations &locations);
+            // Bind the program, geometry and textures of the node
+            void BindState(void);
+            // Bind the vertex array of the geometry and material, creating it
+            // on the first draw
+            void BindVertexArray(void);
+            // Bind the texture and normal map to their units
+            void BindTextures(void);
+            // Point the vertex attributes of the program to the geometry
+            void SetupVertexAttributes(const ProgramLocations &locations);
+            // Point the instance attributes of the program to the draw ring,
+            // starting at an offset
+            void SetupInstanceAttributes(GLintptr offset);
+            // Draw instances whose transforms are given
+            void DrawInstances(const DrawUniforms *instance, GLuint count, int lod);
+            // Draw one command whose instances are already in the ring
+            void DrawCommand(const DrawElementsCommand &command);
+            // Matrix that maps stored vertex positions to model space
+            glm::mat4 GetDequantization(void) const;
 
             glm::vec3 orbit_axis_ = glm::vec3(1, 0, 0); // Orbit Axis
             bool orbiting_;     // whether obj is orbiting
             float orbit_angle_;  // current Orbit angle
             float orbit_speed_;
 
+            static bool lod_enabled_;
+
+        private:
+            friend class NodePool;
+            NodePoolBase *pool_; // Pool the node was created from, if any
+
     }; // class SceneNode
 
 } // namespace game
@@ -1,6 +1,7 @@
 // Material with no illumination simulation
 
 #version 130
+#extension GL_ARB_uniform_buffer_object : require
 
 // Vertex buffer
 in vec3 vertex;
@@ -11,10 +12,21 @@ in vec2 uv;
 out vec4 color_;
 out vec2 uv_;
 
-// Uniform (global) buffer
-uniform mat4 world_mat;
-uniform mat4 view_mat;
-uniform mat4 projection_mat;
+// Transforms of the node being drawn, from the per-draw ring buffer
+layout(std140) uniform PerDraw {
+    mat4 world_mat;
+    mat4 normal_mat;
+};
+
+// Per-frame data shared by all materials, filled once per frame
+layout(std140) uniform PerFrame {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 light_position;
+    vec4 light_color;
+    float timer;
+    int spec_power;
+};
 
 void main()
 {
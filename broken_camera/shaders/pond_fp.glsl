@@ -9,7 +9,16 @@ in vec3 light_pos;
 
 // Uniform (global) buffer
 uniform sampler2D texture_map;
-uniform float timer; 
+
+// Per-frame data shared by all materials, filled once per frame
+layout(std140) uniform PerFrame {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 light_position;
+    vec4 light_color;
+    float timer;
+    int spec_power;
+};
 
 
 void main (void)
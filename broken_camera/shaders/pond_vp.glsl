@@ -6,11 +6,21 @@ in vec3 normal;
 in vec3 color;
 in vec2 uv;
 
-// Uniform (global) buffer
-uniform mat4 world_mat;
-uniform mat4 view_mat;
-uniform mat4 projection_mat;
-uniform mat4 normal_mat;
+// Transforms of the node being drawn, from the per-draw ring buffer
+layout(std140) uniform PerDraw {
+    mat4 world_mat;
+    mat4 normal_mat;
+};
+
+// Per-frame data shared by all materials, filled once per frame
+layout(std140) uniform PerFrame {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 light_position;
+    vec4 light_color;
+    float timer;
+    int spec_power;
+};
 
 // Attributes forwarded to the fragment shader
 out vec3 position_interp;
@@ -23,10 +33,7 @@ out vec3 light_col;
 out float spec_pwr;
 
 // Material attributes (constants)
-uniform vec3 light_position;
 uniform vec3 obj_color;
-uniform float spec_power;
-uniform vec3 light_color;
 
 
 void main()
@@ -42,9 +49,9 @@ void main()
 
     uv_interp = uv;
 
-    light_pos = vec3(view_mat * vec4(light_position, 1.0));
+    light_pos = vec3(view_mat * vec4(light_position.xyz, 1.0));
 
-    light_col = light_color;
+    light_col = light_color.rgb;
 
     spec_pwr = spec_power;
 
@@ -16,20 +16,15 @@ namespace game {
         heightmap_ = h;
         terrain_length_ = l;
         terrain_width_ = w;
+
+        // Only the top of the terrain is seen
+        cull_face_ = true;
     }
 
 
     Terrain::~Terrain() {
     }
 
-    // draws terrain
-    void Terrain::Draw(Camera* c) {
-        glEnable(GL_CULL_FACE);
-        SceneNode::Draw(c);
-        glDisable(GL_CULL_FACE);
-    }
-
-
     // gets player distance to heightmap
     float Terrain::getDistToGround(glm::vec3 pos){
 
@@ -39,8 +34,9 @@ namespace game {
     // get terrain height given y position
     float Terrain::getTerrainY(glm::vec3 pos) {
         float u, v;
-        u = (pos[0] - position_[0] + (terrain_width_ / 2)) / terrain_width_;
-        v = (pos[2] - position_[2] + (terrain_length_ / 2)) / terrain_length_;
+        glm::vec3 position = GetPosition();
+        u = (pos[0] - position[0] + (terrain_width_ / 2)) / terrain_width_;
+        v = (pos[2] - position[2] + (terrain_length_ / 2)) / terrain_length_;
 
         int row = floor(v * heightmap_.height_);
         int col = floor(u * heightmap_.width_);
@@ -48,7 +44,7 @@ namespace game {
 
         float height = (heightmap_.hmap[index] / 255.0) * heightmap_.max_height;
         
-        return position_[1] + height;
+        return GetPosition()[1] + height;
     }
 
 
@@ -1,24 +1,35 @@
 #version 130
+#extension GL_ARB_uniform_buffer_object : require
 
 // Attributes passed from the vertex shader
 in vec3 vertex_position;
 in vec2 vertex_uv;
 in mat3 TBN_mat;
 in vec3 light_pos;
+flat in float texture_layer;
+flat in float normal_layer;
 
 // Uniform (global) buffer
-uniform sampler2D texture_map; // Texture Map
-uniform sampler2D normal_map; // Normal map
+uniform sampler2DArray texture_map; // Texture Map
+uniform sampler2DArray normal_map; // Normal map
 
 // Material attributes (constants)
 uniform vec4 object_color = vec4(0.0, 1.0, 0.0, 1.0);
-uniform vec4 light_color;
-uniform int spec_power;
+
+// Per-frame data shared by all materials, filled once per frame
+layout(std140) uniform PerFrame {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 light_position;
+    vec4 light_color;
+    float timer;
+    int spec_power;
+};
 
 
 void main() 
 {
-    vec4 pixel = texture(texture_map, vertex_uv);
+    vec4 pixel = texture(texture_map, vec3(vertex_uv, texture_layer));
 
 // Incomplete demo -- does matrix multiplication in fragment shader.
 // Left as exercise: move matrix multiplication to vertex shader,
@@ -34,7 +45,7 @@ void main()
     // Get substitute normal in tangent space from the normal map
     vec2 coord = vertex_uv;
     coord.y = 1.0 - coord.y;
-    N = normalize(texture2D(normal_map, coord).rgb*2.0 - 1.0);
+    N = normalize(texture(normal_map, vec3(coord, normal_layer)).rgb*2.0 - 1.0);
 
     // Work in tangent space by multiplying our vectors by TBN_mat    
     // Get light direction
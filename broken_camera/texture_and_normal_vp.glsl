@@ -1,4 +1,5 @@
 #version 130
+#extension GL_ARB_uniform_buffer_object : require
 
 // Vertex buffer
 in vec3 vertex;
@@ -6,21 +7,29 @@ in vec3 normal;
 in vec3 color;
 in vec2 uv;
 
-// Uniform (global) buffer
-uniform mat4 world_mat;
-uniform mat4 view_mat;
-uniform mat4 projection_mat;
-uniform mat4 normal_mat;
+// Transforms of the node being drawn, one per instance, read from the
+// draw ring. The last column of normal_mat holds the layers of the
+// texture and normal map in their arrays
+in mat4 world_mat;
+in mat4 normal_mat;
+
+// Per-frame data shared by all materials, filled once per frame
+layout(std140) uniform PerFrame {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 light_position;
+    vec4 light_color;
+    float timer;
+    int spec_power;
+};
 
 // Attributes forwarded to the fragment shader
 out vec3 vertex_position;
 out vec2 vertex_uv;
 out mat3 TBN_mat;
 out vec3 light_pos;
-
-// Material attributes (constants)
-uniform vec3 light_position;
-
+flat out float texture_layer;
+flat out float normal_layer;
 
 void main()
 {
@@ -41,8 +50,10 @@ void main()
     TBN_mat = transpose(mat3(vertex_tangent_ts, vertex_bitangent_ts, vertex_normal));
 
     // Transform light
-    light_pos = vec3(view_mat * vec4(light_position, 1.0));
+    light_pos = vec3(view_mat * vec4(light_position.xyz, 1.0));
 
-    // Send texture coordinates
+    // Send texture coordinates and layers
     vertex_uv = uv; 
+    texture_layer = normal_mat[3].x;
+    normal_layer = normal_mat[3].y;
 }
@@ -0,0 +1,67 @@
+#include "thread_pool.h"
+
+namespace game {
+
+    ThreadPool::ThreadPool(unsigned int num_threads) {
+
+        stop_ = false;
+        if (num_threads == 0) {
+            num_threads = std::thread::hardware_concurrency();
+        }
+        if (num_threads == 0) {
+            num_threads = 1;
+        }
+        for (unsigned int i = 0; i < num_threads; i++) {
+            workers_.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+        }
+    }
+
+
+    ThreadPool::~ThreadPool() {
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (size_t i = 0; i < workers_.size(); i++) {
+            workers_[i].join();
+        }
+    }
+
+
+    void ThreadPool::Submit(std::function<void(void)> task) {
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(task);
+        }
+        wake_.notify_one();
+    }
+
+
+    unsigned int ThreadPool::GetNumThreads(void) const {
+
+        return (unsigned int) workers_.size();
+    }
+
+
+    void ThreadPool::WorkerLoop(void) {
+
+        while (true) {
+            std::function<void(void)> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                // Drain the queue before stopping
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = tasks_.front();
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+} // namespace game
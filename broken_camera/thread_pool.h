@@ -0,0 +1,44 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace game {
+
+    // Fixed set of worker threads running tasks in the order they were
+    // submitted
+    class ThreadPool {
+
+        public:
+            // Start the workers. With num_threads = 0, one worker is started
+            // per hardware thread
+            ThreadPool(unsigned int num_threads = 0);
+            // Finish the tasks already submitted and stop the workers
+            ~ThreadPool();
+
+            // Queue a task to run on one of the workers
+            void Submit(std::function<void(void)> task);
+            unsigned int GetNumThreads(void) const;
+
+        private:
+            std::vector<std::thread> workers_;
+            std::deque<std::function<void(void)> > tasks_;
+            std::mutex mutex_;
+            std::condition_variable wake_;
+            bool stop_;
+
+            void WorkerLoop(void);
+
+            ThreadPool(const ThreadPool &);
+            ThreadPool &operator=(const ThreadPool &);
+
+    }; // class ThreadPool
+
+} // namespace game
+
+#endif // THREAD_POOL_H_
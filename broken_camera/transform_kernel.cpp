@@ -0,0 +1,163 @@
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define TRANSFORM_KERNEL_SSE
+#include <emmintrin.h>
+#endif
+
+#include "transform_kernel.h"
+#include "transform_kernel_impl.h"
+
+namespace game {
+
+#if defined(TRANSFORM_KERNEL_AVX2)
+    // Built with AVX2 in transform_kernel_avx2.cpp
+    void compute_transforms_avx2(const TransformBatch &batch);
+#endif
+
+    namespace {
+
+        struct ScalarOps {
+
+            static void Multiply(const float *a, const float *b, float *out) {
+
+                for (int j = 0; j < 4; j++) {
+                    for (int i = 0; i < 4; i++) {
+                        out[4 * j + i] = a[i] * b[4 * j] + a[4 + i] * b[4 * j + 1] +
+                            a[8 + i] * b[4 * j + 2] + a[12 + i] * b[4 * j + 3];
+                    }
+                }
+            }
+        };
+
+
+#if defined(TRANSFORM_KERNEL_SSE)
+        struct SseOps {
+
+            // Each column of the product is the columns of a weighted by
+            // the entries of that column of b
+            static void Multiply(const float *a, const float *b, float *out) {
+
+                __m128 a0 = _mm_loadu_ps(a);
+                __m128 a1 = _mm_loadu_ps(a + 4);
+                __m128 a2 = _mm_loadu_ps(a + 8);
+                __m128 a3 = _mm_loadu_ps(a + 12);
+                for (int j = 0; j < 4; j++) {
+                    __m128 col = _mm_mul_ps(a0, _mm_set1_ps(b[4 * j]));
+                    col = _mm_add_ps(col, _mm_mul_ps(a1, _mm_set1_ps(b[4 * j + 1])));
+                    col = _mm_add_ps(col, _mm_mul_ps(a2, _mm_set1_ps(b[4 * j + 2])));
+                    col = _mm_add_ps(col, _mm_mul_ps(a3, _mm_set1_ps(b[4 * j + 3])));
+                    _mm_storeu_ps(out + 4 * j, col);
+                }
+            }
+        };
+#endif
+
+
+        // Whether the processor and the operating system support AVX2
+        // and FMA
+        bool cpu_has_avx2(void) {
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) {
+                return false;
+            }
+            __cpuid(info, 1);
+            bool fma = (info[2] & (1 << 12)) != 0;
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            if (!fma || !osxsave || ((_xgetbv(0) & 6) != 6)) {
+                return false;
+            }
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+            return false;
+#endif
+        }
+
+
+        TransformKernel best_kernel(void) {
+
+#if defined(TRANSFORM_KERNEL_AVX2)
+            if (cpu_has_avx2()) {
+                return Avx2TransformKernel;
+            }
+#endif
+#if defined(TRANSFORM_KERNEL_SSE)
+            return SseTransformKernel;
+#else
+            return ScalarTransformKernel;
+#endif
+        }
+
+    } // namespace
+
+
+    void compute_transforms(const TransformBatch &batch) {
+
+        compute_transforms(batch, get_transform_kernel());
+    }
+
+
+    void compute_transforms(const TransformBatch &batch, TransformKernel kernel) {
+
+        switch (kernel) {
+#if defined(TRANSFORM_KERNEL_AVX2)
+            case Avx2TransformKernel:
+                compute_transforms_avx2(batch);
+                return;
+#endif
+#if defined(TRANSFORM_KERNEL_SSE)
+            case SseTransformKernel:
+                compute_transforms_with<SseOps>(batch);
+                return;
+#endif
+            default:
+                compute_transforms_with<ScalarOps>(batch);
+                return;
+        }
+    }
+
+
+    TransformKernel get_transform_kernel(void) {
+
+        static const TransformKernel kernel = best_kernel();
+        return kernel;
+    }
+
+
+    bool is_transform_kernel_supported(TransformKernel kernel) {
+
+        switch (kernel) {
+            case ScalarTransformKernel:
+                return true;
+            case SseTransformKernel:
+#if defined(TRANSFORM_KERNEL_SSE)
+                return true;
+#else
+                return false;
+#endif
+            case Avx2TransformKernel:
+#if defined(TRANSFORM_KERNEL_AVX2)
+                return cpu_has_avx2();
+#else
+                return false;
+#endif
+            default:
+                return false;
+        }
+    }
+
+
+    const char *get_transform_kernel_name(TransformKernel kernel) {
+
+        static const char *name[num_transform_kernels] = { "scalar", "SSE2", "AVX2" };
+        return ((kernel >= 0) && (kernel < num_transform_kernels)) ? name[kernel] : "unknown";
+    }
+
+} // namespace game
@@ -0,0 +1,52 @@
+#ifndef TRANSFORM_KERNEL_H_
+#define TRANSFORM_KERNEL_H_
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#define GLM_FORCE_RADIANS
+#include <glm/gtc/quaternion.hpp>
+
+namespace game {
+
+    // Instruction sets the transform kernel is built for
+    typedef enum TransformKernel {
+        ScalarTransformKernel,
+        SseTransformKernel, // SSE2, 4 floats at a time
+        Avx2TransformKernel, // AVX2 and FMA, two matrix columns at a time
+        num_transform_kernels
+    } TransformKernel;
+
+    // Arrays of a set of transforms sorted so that parents come before
+    // their children. All of them hold count entries
+    struct TransformBatch {
+        size_t count;
+        const glm::vec3 *position;
+        const glm::quat *orientation;
+        const glm::mat4 *orbit; // Applied between translation and orientation
+        const glm::vec3 *scale; // Only applies to the model matrix
+        const unsigned int *parent; // Index of the parent, or ~0u for roots
+        unsigned char *dirty; // Local transform changed; cleared
+        unsigned char *changed; // Set where the world matrix was computed
+        glm::mat4 *local;
+        glm::mat4 *world;
+        glm::mat4 *model;
+        glm::mat4 *normal; // Inverse transpose of the model matrix
+        unsigned int *version; // Incremented where changed is set
+    };
+
+    // Compute the local, world, model and normal matrices of the
+    // transforms that are dirty or whose parent changed. The normal matrix
+    // only needs a transpose when the world matrix is a rotation, which it
+    // is unless an orbit scales or shears
+    void compute_transforms(const TransformBatch &batch);
+    void compute_transforms(const TransformBatch &batch, TransformKernel kernel);
+
+    // Fastest kernel that this build and processor support, and whether
+    // a given one is
+    TransformKernel get_transform_kernel(void);
+    bool is_transform_kernel_supported(TransformKernel kernel);
+    const char *get_transform_kernel_name(TransformKernel kernel);
+
+} // namespace game
+
+#endif // TRANSFORM_KERNEL_H_
@@ -0,0 +1,46 @@
+// Only built with AVX2 and FMA enabled, see CMakeLists.txt. The rest of
+// the game must not depend on them, so this unit only holds the kernel,
+// which is called after checking the processor
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+#include "transform_kernel.h"
+#include "transform_kernel_impl.h"
+
+namespace game {
+
+    namespace {
+
+        struct Avx2Ops {
+
+            // Two columns of the product at a time: both halves of a
+            // register hold the same column of a, and each is weighted by
+            // the entries of one column of b
+            static void Multiply(const float *a, const float *b, float *out) {
+
+                __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a));
+                __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a + 4));
+                __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a + 8));
+                __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a + 12));
+                for (int j = 0; j < 4; j += 2) {
+                    __m256 bj = _mm256_loadu_ps(b + 4 * j);
+                    __m256 col = _mm256_mul_ps(a0, _mm256_permute_ps(bj, 0x00));
+                    col = _mm256_fmadd_ps(a1, _mm256_permute_ps(bj, 0x55), col);
+                    col = _mm256_fmadd_ps(a2, _mm256_permute_ps(bj, 0xAA), col);
+                    col = _mm256_fmadd_ps(a3, _mm256_permute_ps(bj, 0xFF), col);
+                    _mm256_storeu_ps(out + 4 * j, col);
+                }
+            }
+        };
+
+    } // namespace
+
+
+    void compute_transforms_avx2(const TransformBatch &batch) {
+
+        compute_transforms_with<Avx2Ops>(batch);
+    }
+
+} // namespace game
+
+#endif // __AVX2__
@@ -0,0 +1,186 @@
+#ifndef TRANSFORM_KERNEL_IMPL_H_
+#define TRANSFORM_KERNEL_IMPL_H_
+
+#include <cmath>
+
+#include "transform_kernel.h"
+
+// Body of the transform kernel, shared by the translation units that
+// build it for each instruction set. Ops supplies the 4x4 matrix product.
+// Everything here has internal linkage and reads glm types as plain
+// floats, so that no inline glm function is emitted with the instruction
+// set of one of those units and then picked by the linker for the others
+
+namespace game {
+
+    namespace {
+
+        // Columns of a matrix orthonormal within rounding
+        const float rigid_tolerance = 1e-4f;
+
+
+        inline const float *floats(const glm::mat4 &m) {
+
+            return reinterpret_cast<const float *>(&m);
+        }
+
+
+        inline float *floats(glm::mat4 &m) {
+
+            return reinterpret_cast<float *>(&m);
+        }
+
+
+        inline float dot3(const float *a, const float *b) {
+
+            return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+        }
+
+
+        // Rotation matrix of a unit quaternion, as glm::mat4_cast
+        inline void quat_to_matrix(const glm::quat &q, float *m) {
+
+            float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+            float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+            float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+            m[0] = 1.0f - 2.0f * (yy + zz);
+            m[1] = 2.0f * (xy + wz);
+            m[2] = 2.0f * (xz - wy);
+            m[3] = 0.0f;
+            m[4] = 2.0f * (xy - wz);
+            m[5] = 1.0f - 2.0f * (xx + zz);
+            m[6] = 2.0f * (yz + wx);
+            m[7] = 0.0f;
+            m[8] = 2.0f * (xz + wy);
+            m[9] = 2.0f * (yz - wx);
+            m[10] = 1.0f - 2.0f * (xx + yy);
+            m[11] = 0.0f;
+            m[12] = 0.0f;
+            m[13] = 0.0f;
+            m[14] = 0.0f;
+            m[15] = 1.0f;
+        }
+
+
+        // Whether the upper 3x3 of an affine matrix is a rotation
+        inline bool is_rigid(const float *m) {
+
+            return (std::fabs(dot3(m, m) - 1.0f) < rigid_tolerance) &&
+                (std::fabs(dot3(m + 4, m + 4) - 1.0f) < rigid_tolerance) &&
+                (std::fabs(dot3(m + 8, m + 8) - 1.0f) < rigid_tolerance) &&
+                (std::fabs(dot3(m, m + 4)) < rigid_tolerance) &&
+                (std::fabs(dot3(m, m + 8)) < rigid_tolerance) &&
+                (std::fabs(dot3(m + 4, m + 8)) < rigid_tolerance);
+        }
+
+
+        // Inverse transpose of world * scale, for an affine world matrix.
+        // The upper 3x3 of the result is the cofactor matrix of that of
+        // the model matrix over its determinant, and the last row is the
+        // inverse translation
+        inline void normal_matrix(const float *world, const float *scale, float *n) {
+
+            const float *t = world + 12;
+            if (is_rigid(world)) {
+                // (R S)^-T = R S^-1, and the inverse translates by
+                // -S^-1 R^T t
+                for (int j = 0; j < 3; j++) {
+                    float inv = 1.0f / scale[j];
+                    n[4 * j] = world[4 * j] * inv;
+                    n[4 * j + 1] = world[4 * j + 1] * inv;
+                    n[4 * j + 2] = world[4 * j + 2] * inv;
+                    n[4 * j + 3] = -dot3(world + 4 * j, t) * inv;
+                }
+            }
+            else {
+                float a[12];
+                for (int j = 0; j < 3; j++) {
+                    a[4 * j] = world[4 * j] * scale[j];
+                    a[4 * j + 1] = world[4 * j + 1] * scale[j];
+                    a[4 * j + 2] = world[4 * j + 2] * scale[j];
+                }
+                // Cofactors of column j are the cross product of the
+                // other two columns
+                for (int j = 0; j < 3; j++) {
+                    const float *u = a + 4 * ((j + 1) % 3);
+                    const float *v = a + 4 * ((j + 2) % 3);
+                    n[4 * j] = u[1] * v[2] - u[2] * v[1];
+                    n[4 * j + 1] = u[2] * v[0] - u[0] * v[2];
+                    n[4 * j + 2] = u[0] * v[1] - u[1] * v[0];
+                }
+                float inv_det = 1.0f / dot3(a, n);
+                for (int j = 0; j < 3; j++) {
+                    n[4 * j] *= inv_det;
+                    n[4 * j + 1] *= inv_det;
+                    n[4 * j + 2] *= inv_det;
+                    n[4 * j + 3] = -dot3(n + 4 * j, t);
+                }
+            }
+            n[12] = 0.0f;
+            n[13] = 0.0f;
+            n[14] = 0.0f;
+            n[15] = 1.0f;
+        }
+
+
+        template <typename Ops> void compute_transforms_with(const TransformBatch &batch) {
+
+            // Parents come first, so whether a parent moved is known by the
+            // time its children are reached
+            for (size_t i = 0; i < batch.count; i++) {
+                bool changed = batch.dirty[i] != 0;
+                if (changed) {
+                    // Translate * orbit * rotation
+                    float rotation[16];
+                    float *local = floats(batch.local[i]);
+                    const float *position = &batch.position[i].x;
+                    quat_to_matrix(batch.orientation[i], rotation);
+                    Ops::Multiply(floats(batch.orbit[i]), rotation, local);
+                    for (int j = 0; j < 4; j++) {
+                        local[4 * j] += position[0] * local[4 * j + 3];
+                        local[4 * j + 1] += position[1] * local[4 * j + 3];
+                        local[4 * j + 2] += position[2] * local[4 * j + 3];
+                    }
+                    batch.dirty[i] = 0;
+                }
+                unsigned int parent = batch.parent[i];
+                if ((parent != ~0u) && batch.changed[parent]) {
+                    changed = true;
+                }
+                batch.changed[i] = changed ? 1 : 0;
+                if (!changed) {
+                    continue;
+                }
+
+                float *world = floats(batch.world[i]);
+                if (parent != ~0u) {
+                    Ops::Multiply(floats(batch.world[parent]), floats(batch.local[i]), world);
+                }
+                else {
+                    const float *local = floats(batch.local[i]);
+                    for (int k = 0; k < 16; k++) {
+                        world[k] = local[k];
+                    }
+                }
+
+                const float *scale = &batch.scale[i].x;
+                float *model = floats(batch.model[i]);
+                for (int j = 0; j < 3; j++) {
+                    for (int k = 0; k < 4; k++) {
+                        model[4 * j + k] = world[4 * j + k] * scale[j];
+                    }
+                }
+                for (int k = 0; k < 4; k++) {
+                    model[12 + k] = world[12 + k];
+                }
+                normal_matrix(world, scale, floats(batch.normal[i]));
+                batch.version[i]++;
+            }
+        }
+
+    } // namespace
+
+} // namespace game
+
+#endif // TRANSFORM_KERNEL_IMPL_H_
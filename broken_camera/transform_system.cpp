@@ -0,0 +1,319 @@
+#include <stdexcept>
+
+#include "transform_system.h"
+#include "transform_kernel.h"
+
+namespace game {
+
+    const unsigned int TransformSystem::no_parent;
+    const unsigned int TransformSystem::no_id;
+    std::vector<unsigned int> TransformSystem::id_;
+    std::vector<unsigned int> TransformSystem::parent_;
+    std::vector<glm::vec3> TransformSystem::position_;
+    std::vector<glm::quat> TransformSystem::orientation_;
+    std::vector<glm::vec3> TransformSystem::scale_;
+    std::vector<glm::mat4> TransformSystem::orbit_;
+    std::vector<glm::mat4> TransformSystem::local_;
+    std::vector<glm::mat4> TransformSystem::world_;
+    std::vector<glm::mat4> TransformSystem::model_;
+    std::vector<glm::mat4> TransformSystem::normal_;
+    std::vector<unsigned int> TransformSystem::version_;
+    std::vector<unsigned char> TransformSystem::dirty_;
+    std::vector<unsigned int> TransformSystem::slot_;
+    std::vector<unsigned int> TransformSystem::free_id_;
+    size_t TransformSystem::num_removed_ = 0;
+    std::vector<unsigned char> TransformSystem::changed_;
+    bool TransformSystem::pending_ = false;
+    bool TransformSystem::unsorted_ = false;
+
+
+    // Reorder an array so that entry i comes from entry order[i]. Entries
+    // missing from order are dropped
+    template <typename T> static void permute(std::vector<T> &data, const std::vector<unsigned int> &order) {
+
+        std::vector<T> sorted(order.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            sorted[i] = data[order[i]];
+        }
+        data.swap(sorted);
+    }
+
+
+    unsigned int TransformSystem::Create(void) {
+
+        unsigned int id;
+        if (!free_id_.empty()) {
+            id = free_id_.back();
+            free_id_.pop_back();
+        }
+        else {
+            id = (unsigned int) slot_.size();
+            slot_.push_back(0);
+        }
+
+        // Roots can go last without breaking the order
+        slot_[id] = (unsigned int) id_.size();
+        id_.push_back(id);
+        parent_.push_back(no_parent);
+        position_.push_back(glm::vec3(0.0));
+        orientation_.push_back(glm::quat());
+        scale_.push_back(glm::vec3(1.0));
+        orbit_.push_back(glm::mat4(1.0));
+        local_.push_back(glm::mat4(1.0));
+        world_.push_back(glm::mat4(1.0));
+        model_.push_back(glm::mat4(1.0));
+        normal_.push_back(glm::mat4(1.0));
+        version_.push_back(0);
+        dirty_.push_back(1);
+        pending_ = true;
+        return id;
+    }
+
+
+    void TransformSystem::Destroy(unsigned int id) {
+
+        // The slot stays until the next sort drops it and makes its
+        // children roots, which has to happen before any matrix is read
+        unsigned int slot = slot_[id];
+        id_[slot] = no_id;
+        parent_[slot] = no_parent;
+        num_removed_++;
+        free_id_.push_back(id);
+        unsorted_ = true;
+        pending_ = true;
+    }
+
+
+    void TransformSystem::SetParent(unsigned int id, unsigned int parent) {
+
+        unsigned int slot = slot_[id];
+        unsigned int parent_slot = no_parent;
+        if (parent != no_parent) {
+            parent_slot = slot_[parent];
+            for (unsigned int s = parent_slot; s != no_parent; s = parent_[s]) {
+                if (s == slot) {
+                    throw(std::invalid_argument(std::string("Transform cannot be its own ancestor")));
+                }
+            }
+        }
+        parent_[slot] = parent_slot;
+        dirty_[slot] = 1;
+        pending_ = true;
+
+        // Keep each subtree together, not just after its parent
+        unsorted_ = true;
+    }
+
+
+    unsigned int TransformSystem::GetParent(unsigned int id) {
+
+        // A removed parent reads as none, as it will once sorted
+        unsigned int parent_slot = parent_[slot_[id]];
+        return ((parent_slot == no_parent) || (id_[parent_slot] == no_id)) ? no_parent : id_[parent_slot];
+    }
+
+
+    const glm::vec3 &TransformSystem::GetPosition(unsigned int id) {
+
+        return position_[slot_[id]];
+    }
+
+
+    const glm::quat &TransformSystem::GetOrientation(unsigned int id) {
+
+        return orientation_[slot_[id]];
+    }
+
+
+    const glm::vec3 &TransformSystem::GetScale(unsigned int id) {
+
+        return scale_[slot_[id]];
+    }
+
+
+    void TransformSystem::SetPosition(unsigned int id, const glm::vec3 &position) {
+
+        position_[slot_[id]] = position;
+        MarkChanged(id);
+    }
+
+
+    void TransformSystem::SetOrientation(unsigned int id, const glm::quat &orientation) {
+
+        orientation_[slot_[id]] = orientation;
+        MarkChanged(id);
+    }
+
+
+    void TransformSystem::SetScale(unsigned int id, const glm::vec3 &scale) {
+
+        scale_[slot_[id]] = scale;
+        MarkChanged(id);
+    }
+
+
+    void TransformSystem::SetOrbit(unsigned int id, const glm::mat4 &orbit) {
+
+        orbit_[slot_[id]] = orbit;
+        MarkChanged(id);
+    }
+
+
+    void TransformSystem::MarkChanged(unsigned int id) {
+
+        dirty_[slot_[id]] = 1;
+        pending_ = true;
+    }
+
+
+    const glm::mat4 &TransformSystem::GetWorld(unsigned int id) {
+
+        if (pending_) {
+            Update();
+        }
+        return world_[slot_[id]];
+    }
+
+
+    const glm::mat4 &TransformSystem::GetModel(unsigned int id) {
+
+        if (pending_) {
+            Update();
+        }
+        return model_[slot_[id]];
+    }
+
+
+    const glm::mat4 &TransformSystem::GetNormal(unsigned int id) {
+
+        if (pending_) {
+            Update();
+        }
+        return normal_[slot_[id]];
+    }
+
+
+    unsigned int TransformSystem::GetVersion(unsigned int id) {
+
+        if (pending_) {
+            Update();
+        }
+        return version_[slot_[id]];
+    }
+
+
+    void TransformSystem::Update(void) {
+
+        if (unsorted_) {
+            Sort();
+        }
+
+        TransformBatch batch;
+        batch.count = id_.size();
+        changed_.resize(batch.count);
+        if (batch.count > 0) {
+            batch.position = &position_[0];
+            batch.orientation = &orientation_[0];
+            batch.orbit = &orbit_[0];
+            batch.scale = &scale_[0];
+            batch.parent = &parent_[0];
+            batch.dirty = &dirty_[0];
+            batch.changed = &changed_[0];
+            batch.local = &local_[0];
+            batch.world = &world_[0];
+            batch.model = &model_[0];
+            batch.normal = &normal_[0];
+            batch.version = &version_[0];
+            compute_transforms(batch);
+        }
+        pending_ = false;
+    }
+
+
+    size_t TransformSystem::GetSize(void) {
+
+        return id_.size() - num_removed_;
+    }
+
+
+    void TransformSystem::Sort(void) {
+
+        // Children of removed transforms become roots. Removed slots have
+        // no parent, so they are not counted as children below
+        size_t size = id_.size();
+        for (size_t i = 0; i < size; i++) {
+            if ((parent_[i] != no_parent) && (id_[parent_[i]] == no_id)) {
+                parent_[i] = no_parent;
+                dirty_[i] = 1;
+            }
+        }
+
+        // Children of each slot, in slot order, as ranges of one array
+        std::vector<unsigned int> first_child(size + 1, 0);
+        for (size_t i = 0; i < size; i++) {
+            if (parent_[i] != no_parent) {
+                first_child[parent_[i] + 1]++;
+            }
+        }
+        for (size_t i = 0; i < size; i++) {
+            first_child[i + 1] += first_child[i];
+        }
+        std::vector<unsigned int> child(first_child[size]);
+        std::vector<unsigned int> next(first_child.begin(), first_child.end() - 1);
+        for (size_t i = 0; i < size; i++) {
+            if (parent_[i] != no_parent) {
+                child[next[parent_[i]]++] = (unsigned int) i;
+            }
+        }
+
+        // Depth first from each root. Children are pushed last to first,
+        // so they come out in their old order. Removed slots are left out
+        std::vector<unsigned int> order;
+        std::vector<unsigned int> stack;
+        order.reserve(size - num_removed_);
+        for (size_t root = 0; root < size; root++) {
+            if ((parent_[root] != no_parent) || (id_[root] == no_id)) {
+                continue;
+            }
+            stack.push_back((unsigned int) root);
+            while (!stack.empty()) {
+                unsigned int slot = stack.back();
+                stack.pop_back();
+                order.push_back(slot);
+                for (unsigned int c = first_child[slot + 1]; c > first_child[slot]; c--) {
+                    stack.push_back(child[c - 1]);
+                }
+            }
+        }
+
+        // Parents are found by slot, which changes for every one
+        std::vector<unsigned int> new_slot(size);
+        size = order.size();
+        for (size_t i = 0; i < size; i++) {
+            new_slot[order[i]] = (unsigned int) i;
+        }
+        permute(parent_, order);
+        for (size_t i = 0; i < size; i++) {
+            if (parent_[i] != no_parent) {
+                parent_[i] = new_slot[parent_[i]];
+            }
+        }
+        permute(id_, order);
+        permute(position_, order);
+        permute(orientation_, order);
+        permute(scale_, order);
+        permute(orbit_, order);
+        permute(local_, order);
+        permute(world_, order);
+        permute(model_, order);
+        permute(normal_, order);
+        permute(version_, order);
+        permute(dirty_, order);
+        for (size_t i = 0; i < size; i++) {
+            slot_[id_[i]] = (unsigned int) i;
+        }
+        num_removed_ = 0;
+        unsorted_ = false;
+    }
+
+} // namespace game
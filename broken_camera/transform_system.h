@@ -0,0 +1,98 @@
+#ifndef TRANSFORM_SYSTEM_H_
+#define TRANSFORM_SYSTEM_H_
+
+#include <vector>
+#include <glm/glm.hpp>
+#define GLM_FORCE_RADIANS
+#include <glm/gtc/quaternion.hpp>
+
+namespace game {
+
+    // Transforms of all scene nodes, stored as one array per field and
+    // sorted so that parents come before their children, depth first.
+    // Updating the hierarchy is then a single sweep in order: a world
+    // matrix is computed when its local transform or the world matrix of
+    // its parent changed, and the parent is always done already. Nodes
+    // refer to their transform by an id that does not change when the
+    // arrays are reordered. Removed transforms leave their slot behind
+    // until the next sort, so removing one costs the same however many
+    // there are. Only used from the main thread
+    class TransformSystem {
+
+        public:
+            // Add a root transform at the origin; returns its id
+            static unsigned int Create(void);
+            // Remove a transform. Its children become roots
+            static void Destroy(unsigned int id);
+
+            // Parent of a transform, or no_parent
+            static void SetParent(unsigned int id, unsigned int parent);
+            static unsigned int GetParent(unsigned int id);
+
+            // Local position, orientation and scale. The scale only
+            // applies to the model matrix of the transform, not to its
+            // children
+            static const glm::vec3 &GetPosition(unsigned int id);
+            static const glm::quat &GetOrientation(unsigned int id);
+            static const glm::vec3 &GetScale(unsigned int id);
+            static void SetPosition(unsigned int id, const glm::vec3 &position);
+            static void SetOrientation(unsigned int id, const glm::quat &orientation);
+            static void SetScale(unsigned int id, const glm::vec3 &scale);
+            // Rotation applied between the translation and orientation
+            static void SetOrbit(unsigned int id, const glm::mat4 &orbit);
+
+            // World matrix, without the scale, and with it. A change since
+            // the last Update makes these run it first
+            static const glm::mat4 &GetWorld(unsigned int id);
+            static const glm::mat4 &GetModel(unsigned int id);
+            // Inverse transpose of the model matrix, for normals
+            static const glm::mat4 &GetNormal(unsigned int id);
+            // Changes each time the world matrix is computed again, so
+            // that data derived from it can be kept until then
+            static unsigned int GetVersion(unsigned int id);
+
+            // Sort the transforms again if the hierarchy changed, and
+            // compute the matrices that changed with the transform kernel
+            static void Update(void);
+
+            // Number of transforms
+            static size_t GetSize(void);
+
+            static const unsigned int no_parent = ~0u;
+
+        private:
+            // Sort parents before children, depth first
+            static void Sort(void);
+            static void MarkChanged(unsigned int id);
+
+            // Id held by a slot whose transform was removed
+            static const unsigned int no_id = ~0u;
+
+            // One entry per slot, in hierarchy order
+            static std::vector<unsigned int> id_; // Id held in the slot, or no_id
+            static std::vector<unsigned int> parent_; // Slot of the parent
+            static std::vector<glm::vec3> position_;
+            static std::vector<glm::quat> orientation_;
+            static std::vector<glm::vec3> scale_;
+            static std::vector<glm::mat4> orbit_;
+            static std::vector<glm::mat4> local_;
+            static std::vector<glm::mat4> world_;
+            static std::vector<glm::mat4> model_;
+            static std::vector<glm::mat4> normal_;
+            static std::vector<unsigned int> version_;
+            static std::vector<unsigned char> dirty_; // Local transform changed
+
+            // Indexed by id
+            static std::vector<unsigned int> slot_; // Slot of each id
+            static std::vector<unsigned int> free_id_;
+            static size_t num_removed_; // Slots of removed transforms
+
+            static std::vector<unsigned char> changed_; // Scratch of Update
+            static bool pending_; // Whether anything changed since Update
+            static bool unsorted_; // Whether a child may precede its parent
+
+    }; // class TransformSystem
+
+} // namespace game
+
+#endif // TRANSFORM_SYSTEM_H_
@@ -1,4 +1,5 @@
  #include "tree.h"
+#include "node_pool.h"
 #include <iostream>
 
 namespace game {
@@ -22,7 +23,7 @@ namespace game {
         for (int i = 0; i < num_branches; i++) {
 
             // creates new child tree/branch
-            Tree* child_tree = new Tree("branch", geom, mat, this->length_ / 2, this->radius_ / 2, thorn_geom, NULL);
+            Tree* child_tree = NodePool::Create<Tree>("branch", geom, mat, this->length_ / 2, this->radius_ / 2, thorn_geom, (const Resource *) NULL);
             children_.push_back(child_tree);
             child_tree->SetParent(this);
 
@@ -52,7 +53,7 @@ namespace game {
         for (int i = 0; i < num_thorns; i++) {
 
             // creates new child tree/branch
-            Thorn* child_tree = new Thorn("thorn", geom, mat);
+            Thorn* child_tree = NodePool::Create<Thorn>("thorn", geom, mat);
             children_.push_back(child_tree);
             child_tree->SetParent(this);
 
@@ -79,10 +80,12 @@ namespace game {
         if (orbit_angle_ < -glm::pi<float>() / 16) {
             curr_state_t = counterclockwise;
             orbit_angle_ = -glm::pi<float>() / 16;
+            UpdateOrbit();
         }
         else if (orbit_angle_ > glm::pi<float>() / 16) {
             curr_state_t = clockwise;
             orbit_angle_ = glm::pi<float>() / 16;
+            UpdateOrbit();
 
         }
         else if (curr_state_t == clockwise) {
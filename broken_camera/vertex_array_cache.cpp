@@ -0,0 +1,86 @@
+#include "vertex_array_cache.h"
+#include "gl_state.h"
+
+namespace game {
+
+    std::map<VertexArrayCache::Key, GLuint> VertexArrayCache::vertex_array_;
+
+
+    bool VertexArrayCache::Key::operator<(const Key &other) const {
+
+        if (array_buffer != other.array_buffer) {
+            return array_buffer < other.array_buffer;
+        }
+        if (element_array_buffer != other.element_array_buffer) {
+            return element_array_buffer < other.element_array_buffer;
+        }
+        return program < other.program;
+    }
+
+
+    GLuint VertexArrayCache::Find(GLuint array_buffer, GLuint element_array_buffer, GLuint program) {
+
+        Key key = { array_buffer, element_array_buffer, program };
+        std::map<Key, GLuint>::const_iterator it = vertex_array_.find(key);
+        if (it == vertex_array_.end()) {
+            return 0;
+        }
+        return it->second;
+    }
+
+
+    void VertexArrayCache::Add(GLuint array_buffer, GLuint element_array_buffer, GLuint program, GLuint vertex_array) {
+
+        Key key = { array_buffer, element_array_buffer, program };
+        vertex_array_[key] = vertex_array;
+    }
+
+
+    void VertexArrayCache::ForgetBuffer(GLuint buffer) {
+
+        std::map<Key, GLuint>::iterator it = vertex_array_.begin();
+        while (it != vertex_array_.end()) {
+            if ((it->first.array_buffer == buffer) || (it->first.element_array_buffer == buffer)) {
+                GLState::ForgetVertexArray(it->second);
+                glDeleteVertexArrays(1, &it->second);
+                it = vertex_array_.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+
+    void VertexArrayCache::ForgetProgram(GLuint program) {
+
+        std::map<Key, GLuint>::iterator it = vertex_array_.begin();
+        while (it != vertex_array_.end()) {
+            if (it->first.program == program) {
+                GLState::ForgetVertexArray(it->second);
+                glDeleteVertexArrays(1, &it->second);
+                it = vertex_array_.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+
+    void VertexArrayCache::Clear(void) {
+
+        for (std::map<Key, GLuint>::iterator it = vertex_array_.begin(); it != vertex_array_.end(); ++it) {
+            GLState::ForgetVertexArray(it->second);
+            glDeleteVertexArrays(1, &it->second);
+        }
+        vertex_array_.clear();
+    }
+
+
+    size_t VertexArrayCache::GetSize(void) {
+
+        return vertex_array_.size();
+    }
+
+} // namespace game
@@ -0,0 +1,45 @@
+#ifndef VERTEX_ARRAY_CACHE_H_
+#define VERTEX_ARRAY_CACHE_H_
+
+#include <cstddef>
+#include <map>
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+namespace game {
+
+    // Vertex array objects shared by everything that draws the same buffers
+    // with the same shader program. The attribute locations differ between
+    // programs, so each pair of geometry and material gets its own. Vertex
+    // arrays are only used from the thread that owns the OpenGL context
+    class VertexArrayCache {
+
+        public:
+            // Get the vertex array of some buffers drawn with a program, or
+            // 0 if there is none yet
+            static GLuint Find(GLuint array_buffer, GLuint element_array_buffer, GLuint program);
+            // Record a vertex array set up by the caller
+            static void Add(GLuint array_buffer, GLuint element_array_buffer, GLuint program, GLuint vertex_array);
+            // Delete the vertex arrays that use a buffer or a program, before
+            // the object is deleted and its name reused
+            static void ForgetBuffer(GLuint buffer);
+            static void ForgetProgram(GLuint program);
+            // Delete all vertex arrays
+            static void Clear(void);
+            // Number of vertex arrays in the cache
+            static size_t GetSize(void);
+
+        private:
+            struct Key {
+                GLuint array_buffer;
+                GLuint element_array_buffer;
+                GLuint program;
+                bool operator<(const Key &other) const;
+            };
+            static std::map<Key, GLuint> vertex_array_;
+
+    }; // class VertexArrayCache
+
+} // namespace game
+
+#endif // VERTEX_ARRAY_CACHE_H_
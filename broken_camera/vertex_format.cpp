@@ -0,0 +1,208 @@
+#include <cmath>
+#include <cstring>
+
+#include "vertex_format.h"
+
+namespace game {
+
+    namespace {
+
+        // Layout of packed mesh vertices, 20 bytes instead of 44
+        const GLsizei packed_mesh_stride = 20;
+        // Layout of packed point set vertices, 28 bytes instead of 44; each
+        // attribute starts on a 4-byte boundary
+        const GLsizei packed_point_stride = 28;
+
+
+        inline int16_t pack_snorm16(float value) {
+
+            value = glm::clamp(value, -1.0f, 1.0f);
+            return (int16_t) floorf(value * 32767.0f + 0.5f);
+        }
+
+
+        inline uint16_t pack_unorm16(float value) {
+
+            value = glm::clamp(value, 0.0f, 1.0f);
+            return (uint16_t) floorf(value * 65535.0f + 0.5f);
+        }
+
+
+        // Normals from files and averaged normals are not always unit
+        // length; only scale down the ones that do not fit
+        inline glm::vec3 fit_direction(const glm::vec3 &value) {
+
+            float m = glm::max(fabsf(value.x), glm::max(fabsf(value.y), fabsf(value.z)));
+            return (m > 1.0f) ? value / m : value;
+        }
+
+    } // namespace
+
+
+    uint16_t pack_half(float value) {
+
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        uint32_t sign = (bits >> 16) & 0x8000;
+        uint32_t magnitude = bits & 0x7fffffff;
+
+        // Rebias the exponent from 127 to 15 and round the mantissa to
+        // nearest
+        uint32_t half = (magnitude - (112 << 23) + (1 << 12)) >> 13;
+        if (magnitude < (113 << 23)) {
+            // Too small for a normal half; flush to zero
+            half = 0;
+        }
+        if (magnitude >= (143 << 23)) {
+            // Too large; infinity
+            half = 0x7c00;
+        }
+        if (magnitude > (255 << 23)) {
+            // NaN
+            half = 0x7e00;
+        }
+        return (uint16_t) (sign | half);
+    }
+
+
+    uint32_t pack_snorm_10_10_10_2(const glm::vec3 &value) {
+
+        // Matches GL_INT_2_10_10_10_REV: x in the low bits, w (unused) in
+        // the two high bits
+        uint32_t packed = 0;
+        for (int k = 0; k < 3; k++) {
+            float c = glm::clamp(value[k], -1.0f, 1.0f);
+            int32_t q = (int32_t) floorf(c * 511.0f + 0.5f);
+            packed |= ((uint32_t) q & 0x3ff) << (10 * k);
+        }
+        return packed;
+    }
+
+
+    void pack_mesh(const MeshData &data, VertexFormat format, PackedMesh &packed) {
+
+        packed.num_vertices = (GLsizei) (data.vertex.size() / mesh_vertex_att);
+        packed.num_indices = (GLsizei) data.index.size();
+        packed.bounds_min = data.bounds_min;
+        packed.bounds_max = data.bounds_max;
+        packed.lod = data.lod;
+
+        if (format == FloatVertexFormat) {
+            packed.layout = float_vertex_layout();
+            packed.vertex.resize(data.vertex.size() * sizeof(GLfloat));
+            packed.index.resize(data.index.size() * sizeof(GLuint));
+            if (!data.vertex.empty()) {
+                memcpy(packed.vertex.data(), data.vertex.data(), packed.vertex.size());
+            }
+            if (!data.index.empty()) {
+                memcpy(packed.index.data(), data.index.data(), packed.index.size());
+            }
+            return;
+        }
+
+        // Positions are stored relative to the center of the bounds, and
+        // the world matrix undoes the scaling
+        glm::vec3 center = (data.bounds_min + data.bounds_max) * 0.5f;
+        glm::vec3 extent = (data.bounds_max - data.bounds_min) * 0.5f;
+        for (int k = 0; k < 3; k++) {
+            if (extent[k] <= 0.0f) {
+                extent[k] = 1.0f;
+            }
+        }
+
+        // Texture coordinates that repeat the texture do not fit in
+        // [0, 1], so keep them as half floats
+        bool uv_unorm = true;
+        for (GLsizei i = 0; i < packed.num_vertices; i++) {
+            const GLfloat *att = &data.vertex[i * mesh_vertex_att];
+            if ((att[9] < 0.0f) || (att[9] > 1.0f) || (att[10] < 0.0f) || (att[10] > 1.0f)) {
+                uv_unorm = false;
+                break;
+            }
+        }
+
+        VertexLayout &layout = packed.layout;
+        layout.stride = packed_mesh_stride;
+        layout.position = { 3, GL_SHORT, GL_TRUE, 0 };
+        layout.normal = { 4, GL_INT_2_10_10_10_REV, GL_TRUE, 8 };
+        layout.color = { 4, GL_INT_2_10_10_10_REV, GL_TRUE, 12 };
+        if (uv_unorm) {
+            layout.uv = { 2, GL_UNSIGNED_SHORT, GL_TRUE, 16 };
+        }
+        else {
+            layout.uv = { 2, GL_HALF_FLOAT, GL_FALSE, 16 };
+        }
+        layout.position_offset = center;
+        layout.position_scale = extent;
+
+        packed.vertex.assign(packed.num_vertices * packed_mesh_stride, 0);
+        for (GLsizei i = 0; i < packed.num_vertices; i++) {
+            const GLfloat *att = &data.vertex[i * mesh_vertex_att];
+            unsigned char *out = &packed.vertex[i * packed_mesh_stride];
+
+            int16_t position[3];
+            for (int k = 0; k < 3; k++) {
+                position[k] = pack_snorm16((att[k] - center[k]) / extent[k]);
+            }
+            memcpy(out, position, sizeof(position));
+
+            uint32_t normal = pack_snorm_10_10_10_2(fit_direction(glm::vec3(att[3], att[4], att[5])));
+            uint32_t color = pack_snorm_10_10_10_2(fit_direction(glm::vec3(att[6], att[7], att[8])));
+            memcpy(out + 8, &normal, sizeof(normal));
+            memcpy(out + 12, &color, sizeof(color));
+
+            uint16_t uv[2];
+            for (int k = 0; k < 2; k++) {
+                uv[k] = uv_unorm ? pack_unorm16(att[9 + k]) : pack_half(att[9 + k]);
+            }
+            memcpy(out + 16, uv, sizeof(uv));
+        }
+
+        // 16-bit indices reach every vertex of most meshes
+        if (packed.num_vertices < 65536) {
+            layout.index_type = GL_UNSIGNED_SHORT;
+            packed.index.resize(data.index.size() * sizeof(GLushort));
+            GLushort *index = (GLushort *) packed.index.data();
+            for (size_t i = 0; i < data.index.size(); i++) {
+                index[i] = (GLushort) data.index[i];
+            }
+        }
+        else {
+            layout.index_type = GL_UNSIGNED_INT;
+            packed.index.resize(data.index.size() * sizeof(GLuint));
+            if (!data.index.empty()) {
+                memcpy(packed.index.data(), data.index.data(), packed.index.size());
+            }
+        }
+    }
+
+
+    void pack_point_set(const GLfloat *vertex, GLsizei num_vertices, VertexFormat format, std::vector<unsigned char> &packed, VertexLayout &layout) {
+
+        if (format == FloatVertexFormat) {
+            layout = float_vertex_layout();
+            packed.resize(num_vertices * mesh_vertex_att * sizeof(GLfloat));
+            memcpy(packed.data(), vertex, packed.size());
+            return;
+        }
+
+        // Particle attributes are not directions or colors only (the
+        // normal holds a velocity), so all of them are half floats
+        layout = float_vertex_layout();
+        layout.stride = packed_point_stride;
+        layout.position = { 3, GL_HALF_FLOAT, GL_FALSE, 0 };
+        layout.normal = { 3, GL_HALF_FLOAT, GL_FALSE, 8 };
+        layout.color = { 3, GL_HALF_FLOAT, GL_FALSE, 16 };
+        layout.uv = { 2, GL_HALF_FLOAT, GL_FALSE, 24 };
+
+        const GLuint offset[mesh_vertex_att] = { 0, 2, 4, 8, 10, 12, 16, 18, 20, 24, 26 };
+        packed.assign(num_vertices * packed_point_stride, 0);
+        for (GLsizei i = 0; i < num_vertices; i++) {
+            for (int k = 0; k < mesh_vertex_att; k++) {
+                uint16_t half = pack_half(vertex[i * mesh_vertex_att + k]);
+                memcpy(&packed[i * packed_point_stride + offset[k]], &half, sizeof(half));
+            }
+        }
+    }
+
+} // namespace game
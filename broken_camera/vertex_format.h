@@ -0,0 +1,38 @@
+#ifndef VERTEX_FORMAT_H_
+#define VERTEX_FORMAT_H_
+
+#include <cstdint>
+#include <vector>
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "resource.h"
+#include "model_loader.h"
+
+namespace game {
+
+    // A mesh in the format of the OpenGL buffers
+    struct PackedMesh {
+        VertexLayout layout;
+        std::vector<unsigned char> vertex;
+        std::vector<unsigned char> index;
+        GLsizei num_vertices;
+        GLsizei num_indices;
+        glm::vec3 bounds_min;
+        glm::vec3 bounds_max;
+        std::vector<MeshLod> lod;
+    };
+
+    // Conversions to packed types
+    uint16_t pack_half(float value);
+    uint32_t pack_snorm_10_10_10_2(const glm::vec3 &value);
+
+    // Store a mesh in the given format
+    void pack_mesh(const MeshData &data, VertexFormat format, PackedMesh &packed);
+    // Store a point set of 11-float vertices in the given format
+    void pack_point_set(const GLfloat *vertex, GLsizei num_vertices, VertexFormat format, std::vector<unsigned char> &packed, VertexLayout &layout);
+
+} // namespace game
+
+#endif // VERTEX_FORMAT_H_